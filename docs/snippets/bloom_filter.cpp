@@ -0,0 +1,24 @@
+// SPDX-FileCopyrightText: 2006-2023, Knut Reinert & Freie Universität Berlin
+// SPDX-FileCopyrightText: 2016-2023, Knut Reinert & MPI für molekulare Genetik
+// SPDX-License-Identifier: CC0-1.0
+#include <fmt/format.h>
+#include <fmt/ranges.h>
+#include <ivsigma/ivsigma.h>
+
+int main() {
+    auto references = std::vector<std::vector<uint8_t>>{
+        ivs::convert_char_to_rank<ivs::dna4>(std::string{"CGATTCAAATGACGGCAGCAGGCCGGGAGTCCCTGAGAGGCTTGTTCCGGAAATGTGCCA"}),
+        ivs::convert_char_to_rank<ivs::dna4>(std::string{"TCTGCGTGCGAACGCAGCGTAAGAGGAGGGCTAGCTGCGTCGAGATCGGG"}),
+        ivs::convert_char_to_rank<ivs::dna4>(std::string{"GGCTTGTTCCGGAAATGTGCCATCTGCGTGCGAACGCAGCGTAAGAGGAG"}),
+    };
+
+    // one bin per reference, 1024 bits per bin, 2 hash functions
+    auto filter = ivs::interleaved_bloom_filter{references.size(), 1024, 2};
+    for (size_t i{0}; i < references.size(); ++i) {
+        filter.insert(i, ivs::compact_encoding<ivs::dna4>{references[i], 11});
+    }
+
+    auto read   = ivs::convert_char_to_rank<ivs::dna4>(std::string{"GAGGCTTGTTCCGGAAATGTGCCATCT"});
+    auto counts = filter.count(ivs::compact_encoding<ivs::dna4>{read, 11});
+    fmt::print("k-mers per bin: {}\n", counts);
+}
@@ -0,0 +1,27 @@
+// SPDX-FileCopyrightText: 2006-2023, Knut Reinert & Freie Universität Berlin
+// SPDX-FileCopyrightText: 2016-2023, Knut Reinert & MPI für molekulare Genetik
+// SPDX-License-Identifier: CC0-1.0
+#include <fmt/format.h>
+#include <fmt/ranges.h>
+#include <ivsigma/ivsigma.h>
+
+int main() {
+    auto references = std::vector<std::vector<uint8_t>>{
+        ivs::convert_char_to_rank<ivs::dna4>(std::string{"CGATTCAAATGACGGCAGCAGGCCGGGAGTCCCTGAGAGGCTTGTTCCGGAAATGTGCCA"}),
+        ivs::convert_char_to_rank<ivs::dna4>(std::string{"TCTGCGTGCGAACGCAGCGTAAGAGGAGGGCTAGCTGCGTCGAGATCGGG"}),
+    };
+    auto index = ivs::minimizer_index<ivs::dna4>{references, {.k = 7, .window = 3}};
+
+    // read from the reverse strand of the first reference, with one substitution
+    auto read = ivs::convert_char_to_rank<ivs::dna4>(std::string{"CAAGCCTCTCAGGGACACCCGGCCTGCTGCCG"});
+
+    auto anchors = ivs::anchors{};
+    ivs::collect_anchors(index, read, anchors);
+    fmt::print("{} anchors\n", anchors.size());
+
+    for (auto const& c : ivs::chain_anchors(anchors, {.min_score = 10, .min_anchors = 2})) {
+        fmt::print("sequence {} {} score {}: query [{}, {}) reference [{}, {}), {} anchors\n",
+                   c.sequence, c.reverse ? '-' : '+', c.score, c.query.begin, c.query.end,
+                   c.reference.begin, c.reference.end, c.anchors.size());
+    }
+}
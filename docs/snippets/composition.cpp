@@ -0,0 +1,20 @@
+// SPDX-FileCopyrightText: 2006-2023, Knut Reinert & Freie Universität Berlin
+// SPDX-FileCopyrightText: 2016-2023, Knut Reinert & MPI für molekulare Genetik
+// SPDX-License-Identifier: CC0-1.0
+#include <fmt/format.h>
+#include <fmt/ranges.h>
+#include <ivsigma/ivsigma.h>
+
+int main()
+{
+    auto input = ivs::convert_char_to_rank<ivs::dna5>(std::string{"ACGCGTTANNCGATCGCGCGTATA"});
+    fmt::print("histogram: {}\n", ivs::rank_histogram<ivs::dna5>(input));
+
+    for (auto const& w : ivs::sliding_composition<ivs::dna5>{input, /*.window=*/ 8, /*.step=*/ 4}) {
+        fmt::print("{:2}: GC {:.3f} CpG {:.3f}\n", w.position, w.gc_fraction(), w.cpg_density());
+    }
+
+    // same on a packed representation
+    auto packed = ivs::packed_sequence<ivs::dna5>{input};
+    fmt::print("packed histogram: {}\n", ivs::rank_histogram<ivs::dna5>(packed));
+}
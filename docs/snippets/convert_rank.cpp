@@ -0,0 +1,17 @@
+// SPDX-FileCopyrightText: 2006-2023, Knut Reinert & Freie Universität Berlin
+// SPDX-FileCopyrightText: 2016-2023, Knut Reinert & MPI für molekulare Genetik
+// SPDX-License-Identifier: CC0-1.0
+#include <fmt/format.h>
+#include <fmt/ranges.h>
+#include <ivsigma/ivsigma.h>
+
+int main()
+{
+    auto protein = ivs::convert_char_to_rank<ivs::aa27>(std::string{"MKVLAW*"});
+    auto reduced = ivs::convert_rank<ivs::aa27, ivs::aa10murphy>(protein);
+    fmt::print("{} => {}\n", protein, reduced);
+
+    auto dna = ivs::convert_char_to_rank<ivs::dna5>(std::string{"ACNGT"});
+    fmt::print("{}\n", ivs::convert_rank<ivs::dna5, ivs::dna4>(dna));
+    fmt::print("{}\n", ivs::convert_rank<ivs::dna5, ivs::dna4, ivs::rank_conversion_policy::replace>(dna));
+}
@@ -0,0 +1,15 @@
+// SPDX-FileCopyrightText: 2006-2023, Knut Reinert & Freie Universität Berlin
+// SPDX-FileCopyrightText: 2016-2023, Knut Reinert & MPI für molekulare Genetik
+// SPDX-License-Identifier: CC0-1.0
+#include <ivsigma/ivsigma.h>
+#include <iostream>
+
+int main()
+{
+    auto input = ivs::convert_char_to_rank<ivs::dna5>(std::string{"GATTACCGTAGCTTAGCCATGCAGTTCGATCACACACACACACACACACACACACANNNNCCGTAGCTTAGCAAAAAAAAAAAAAAAAAAAAAA"});
+    auto masker = ivs::sdust_masker{/*.threshold=*/ 20, /*.window=*/ 64};
+    for (auto [begin, end] : masker.mask(input)) {
+        std::cout << '[' << begin << ", " << end << ") ";
+    }
+    std::cout << '\n';
+}
@@ -0,0 +1,20 @@
+// SPDX-FileCopyrightText: 2006-2023, Knut Reinert & Freie Universität Berlin
+// SPDX-FileCopyrightText: 2016-2023, Knut Reinert & MPI für molekulare Genetik
+// SPDX-License-Identifier: CC0-1.0
+#include <fmt/format.h>
+#include <fmt/ranges.h>
+#include <ivsigma/ivsigma.h>
+
+int main() {
+    // ivs::fastx_reader{"file.fa"} maps a file and provides the same interface
+    auto text   = std::string{">seq1\nACGT\nNNAC\n>seq2\nGGTT\n"};
+    auto parser = ivs::fastx_parser{text};
+
+    auto ranks = std::vector<uint8_t>{};
+    for (auto iter = begin(parser); iter != end(parser); ++iter) {
+        auto const& record = *iter;
+        ranks.clear();
+        ivs::convert_lines_to_rank<ivs::dna5>(record.sequence, ranks);
+        fmt::print("{} (line breaks: {}) => {}\n", record.name, record.line_breaks, ranks);
+    }
+}
@@ -0,0 +1,18 @@
+// SPDX-FileCopyrightText: 2006-2023, Knut Reinert & Freie Universität Berlin
+// SPDX-FileCopyrightText: 2016-2023, Knut Reinert & MPI für molekulare Genetik
+// SPDX-License-Identifier: CC0-1.0
+#include <ivsigma/ivsigma.h>
+#include <iostream>
+
+int main()
+{
+    auto ranks     = ivs::convert_char_to_rank<ivs::dna5>(std::string{"ACGTNACGTACGTTTGCA"});
+    auto qualities = ivs::convert_char_to_rank<ivs::pthred42>(std::string{"IIIII5555+++++####"});
+    auto packed    = ivs::packed_sequence<ivs::dna5>{ranks};
+
+    // ivs::fastx_writer<ivs::dna5>{"out.fa"} writes into a file
+    auto writer = ivs::fastx_writer<ivs::dna5, ivs::pthred42>{std::cout, /*.line_width=*/ 8};
+    writer.write_fasta("seq1", ranks);
+    writer.write_fasta("seq2", packed);
+    writer.write_fastq("read1", ranks, qualities);
+}
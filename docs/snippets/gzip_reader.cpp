@@ -0,0 +1,26 @@
+// SPDX-FileCopyrightText: 2006-2023, Knut Reinert & Freie Universität Berlin
+// SPDX-FileCopyrightText: 2016-2023, Knut Reinert & MPI für molekulare Genetik
+// SPDX-License-Identifier: CC0-1.0
+#include <fmt/format.h>
+#include <fmt/ranges.h>
+#include <ivsigma/ivsigma.h>
+
+int main() {
+    // gzip compressed ">s\nACGTACGTACGTACGTNNNN\n"
+    auto data = std::vector<uint8_t>{
+        0x1f, 0x8b, 0x08, 0x00, 0x00, 0x00, 0x00, 0x00, 0x02, 0x03, 0xb3, 0x2b, 0xe6, 0x72, 0x74, 0x76,
+        0x0f, 0x41, 0xc6, 0x7e, 0x40, 0xc0, 0x05, 0x00, 0x75, 0x35, 0x37, 0x04, 0x18, 0x00, 0x00, 0x00,
+    };
+    auto compressed = std::span{reinterpret_cast<char const*>(data.data()), data.size()};
+    fmt::print("gzip: {}, bgzf: {}\n", ivs::is_gzip(compressed), ivs::is_bgzf(compressed));
+
+    // files can be read via ivs::gzip_fastx_reader{"file.fa.gz"}
+    auto reader = ivs::gzip_reader{compressed, /*.threads=*/ 4, /*.buffers=*/ 8};
+    auto chunk  = std::vector<char>{};
+    while (reader.next(chunk)) {
+        auto parser = ivs::fastx_parser{chunk};
+        for (auto iter = begin(parser); iter != end(parser); ++iter) {
+            fmt::print("{} => {}\n", (*iter).name, ivs::convert_char_to_rank<ivs::dna5>((*iter).sequence));
+        }
+    }
+}
@@ -0,0 +1,20 @@
+// SPDX-FileCopyrightText: 2006-2023, Knut Reinert & Freie Universität Berlin
+// SPDX-FileCopyrightText: 2016-2023, Knut Reinert & MPI für molekulare Genetik
+// SPDX-License-Identifier: CC0-1.0
+#include <ivsigma/ivsigma.h>
+#include <iostream>
+
+int main()
+{
+    std::vector<uint8_t> input = ivs::convert_char_to_rank<ivs::dna4>(std::string{"GGGCAAAGTTAC"});
+    for (auto c : ivs::homopolymer_compressed_view{input}) {
+        std::cout << ivs::dna4::rank_to_char(c);
+    }
+    std::cout << '\n';
+
+    auto encoding = ivs::homopolymer_compact_encoding<ivs::dna4>{input, /*._k=*/ 3};
+    for (auto iter = begin(encoding); iter != end(encoding); ++iter) {
+        std::cout << *iter << '@' << iter.kmer().position() << ' ';
+    }
+    std::cout << '\n';
+}
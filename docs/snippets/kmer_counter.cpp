@@ -0,0 +1,26 @@
+// SPDX-FileCopyrightText: 2006-2023, Knut Reinert & Freie Universität Berlin
+// SPDX-FileCopyrightText: 2016-2023, Knut Reinert & MPI für molekulare Genetik
+// SPDX-License-Identifier: CC0-1.0
+#include <fmt/format.h>
+#include <fmt/ranges.h>
+#include <ivsigma/ivsigma.h>
+
+int main() {
+    auto reads = std::vector<std::vector<uint8_t>>{};
+    for (auto s : {"ACGTACGTTT", "TTACGTACGA", "GGGGCCCC"}) {
+        reads.push_back(ivs::convert_char_to_rank<ivs::dna4>(std::string{s}));
+    }
+
+    // expected number of distinct k-mers, the table does not grow
+    auto table = ivs::kmer_count_table{64};
+    ivs::count_kmers<ivs::dna4>(table, reads, /*.k=*/ 4, /*.threads=*/ 2);
+
+    fmt::print("distinct k-mers: {}\n", table.size());
+    fmt::print("histogram: {}\n", table.histogram());
+    for (auto [kmer, count] : table.kmers_above(3)) {
+        fmt::print("k-mer {} occurs {} times\n", kmer, count);
+    }
+    auto acgt  = ivs::convert_char_to_rank<ivs::dna4>(std::string{"ACGT"});
+    auto kmers = ivs::compact_encoding<ivs::dna4>{acgt, 4};
+    fmt::print("ACGT: {}\n", table.count(*begin(kmers)));
+}
@@ -0,0 +1,30 @@
+// SPDX-FileCopyrightText: 2006-2023, Knut Reinert & Freie Universität Berlin
+// SPDX-FileCopyrightText: 2016-2023, Knut Reinert & MPI für molekulare Genetik
+// SPDX-License-Identifier: CC0-1.0
+#include <filesystem>
+#include <fmt/format.h>
+#include <fmt/ranges.h>
+#include <ivsigma/ivsigma.h>
+
+int main() {
+    auto references = std::vector<std::vector<uint8_t>>{};
+    for (auto s : {"ACGTTGCATGCAGTCAGTTGACCA", "TTTTGCATGCAGTCAGAAAA"}) {
+        references.push_back(ivs::convert_char_to_rank<ivs::dna4>(std::string{s}));
+    }
+    auto index = ivs::minimizer_index<ivs::dna4>{references, {.k = 5, .window = 4}};
+    fmt::print("{} minimizers, {} hits\n", index.size(), index.hit_count());
+
+    // the index is persisted and opened via mmap
+    auto path = std::filesystem::temp_directory_path() / "example.idx";
+    index.save(path);
+    auto mapped = ivs::minimizer_index<ivs::dna4>{path};
+
+    auto query = ivs::convert_char_to_rank<ivs::dna4>(std::string{"CTGACTGCATGCA"});
+    mapped.for_each_hit(query, [](size_t qpos, bool reverse, std::span<ivs::minimizer_hit const> hits) {
+        for (auto hit : hits) {
+            auto strand = hit.reverse() == reverse ? '+' : '-';
+            fmt::print("query {} -> sequence {} position {} strand {}\n", qpos, hit.sequence, hit.position(), strand);
+        }
+    });
+    std::filesystem::remove(path);
+}
@@ -0,0 +1,25 @@
+// SPDX-FileCopyrightText: 2006-2023, Knut Reinert & Freie Universität Berlin
+// SPDX-FileCopyrightText: 2016-2023, Knut Reinert & MPI für molekulare Genetik
+// SPDX-License-Identifier: CC0-1.0
+#include <fmt/format.h>
+#include <ivsigma/ivsigma.h>
+
+int main()
+{
+    auto input = ivs::convert_char_to_rank<ivs::iupac>(std::string{"NNNNNNACGTTGCANNNNNNNNNNGATRACAGNN"});
+    auto seq   = ivs::n_compressed_sequence{input};
+    for (auto [begin, end] : seq.gaps) {
+        fmt::print("gap: [{}, {})\n", begin, end);
+    }
+    for (auto [position, rank] : seq.exceptions) {
+        fmt::print("exception: {} {}\n", position, ivs::iupac::rank_to_char(rank));
+    }
+    fmt::print("iupac: {}\n", seq.extract_char(10, 20));
+    fmt::print("dna5:  {}\n", seq.extract_char<ivs::dna5>(10, 20));
+
+    auto kmers = seq.kmers(/*.k=*/ 4);
+    for (auto iter = begin(kmers); iter != end(kmers); ++iter) {
+        fmt::print("{}:{} ", iter.position(), *iter);
+    }
+    fmt::print("\n");
+}
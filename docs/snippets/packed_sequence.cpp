@@ -0,0 +1,22 @@
+// SPDX-FileCopyrightText: 2006-2023, Knut Reinert & Freie Universität Berlin
+// SPDX-FileCopyrightText: 2016-2023, Knut Reinert & MPI für molekulare Genetik
+// SPDX-License-Identifier: CC0-1.0
+#include <fmt/format.h>
+#include <fmt/ranges.h>
+#include <ivsigma/ivsigma.h>
+
+int main()
+{
+    auto input  = ivs::convert_char_to_rank<ivs::dna4>(std::string{"ACGTTGCAACGT"});
+    auto packed = ivs::packed_sequence<ivs::dna4>{input};
+    fmt::print("{} ranks in {} word(s), rank 3: {}\n", packed.size(), packed.words.size(), packed[3]);
+
+    auto region = std::vector<uint8_t>(4);
+    packed.unpack(/*.offset=*/ 4, region);
+    fmt::print("region: {}\n", region);
+
+    for (auto enc : ivs::compact_encoding<ivs::dna4, true, ivs::packed_span<ivs::dna4>>{packed, /*.k=*/ 3}) {
+        fmt::print("{} ", enc);
+    }
+    fmt::print("\n");
+}
@@ -0,0 +1,30 @@
+// SPDX-FileCopyrightText: 2006-2023, Knut Reinert & Freie Universität Berlin
+// SPDX-FileCopyrightText: 2016-2023, Knut Reinert & MPI für molekulare Genetik
+// SPDX-License-Identifier: CC0-1.0
+#include <filesystem>
+#include <fmt/format.h>
+#include <fmt/ranges.h>
+#include <ivsigma/ivsigma.h>
+
+int main() {
+    auto path = std::filesystem::temp_directory_path() / "example.ivs";
+
+    auto writer = ivs::packed_store_writer<ivs::dna5>{};
+    writer.add("chr1", ivs::convert_char_to_rank<ivs::dna5>(std::string{"ACGTNNACGTGGA"}));
+    writer.add("chrM", ivs::convert_char_to_rank<ivs::dna5>(std::string{"TTTAGGC"}));
+    writer.write(path);
+
+    // opening maps the file, nothing is parsed
+    auto store = ivs::packed_store<ivs::dna5>{path};
+    for (size_t i{0}; i < store.size(); ++i) {
+        fmt::print("{}: {} bases\n", store.name(i), store.length(i));
+    }
+    auto chr1 = *store.find("chr1");
+    fmt::print("chr1 [4, 10): {}\n", store.extract_char(chr1, 4, 6));
+    fmt::print("ranks: {}\n", store.extract(chr1, 4, 6));
+
+    // sequences are packed views into the mapping
+    auto seq = store.sequence(chr1);
+    fmt::print("packed words: {}\n", seq.words.size());
+    std::filesystem::remove(path);
+}
@@ -0,0 +1,23 @@
+// SPDX-FileCopyrightText: 2006-2023, Knut Reinert & Freie Universität Berlin
+// SPDX-FileCopyrightText: 2016-2023, Knut Reinert & MPI für molekulare Genetik
+// SPDX-License-Identifier: CC0-1.0
+#include <fmt/format.h>
+#include <fmt/ranges.h>
+#include <ivsigma/ivsigma.h>
+
+int main()
+{
+    using bins = ivs::quality_bin_alphabet<ivs::pthred42, ivs::illumina8_binning>;
+
+    auto quality = std::string{"IIIIIIHHHHGGF@@@@5+++#"};
+    fmt::print("binned:  {}\n", ivs::bin_quality_char<ivs::pthred42, ivs::illumina8_binning>(quality));
+
+    auto indices = ivs::quality_char_to_bin<ivs::pthred42, ivs::illumina8_binning>(quality);
+    fmt::print("indices: {}\n", indices);
+
+    auto packed = ivs::packed_sequence<bins>{indices};
+    fmt::print("packed: {} bits per value, {} word(s)\n", ivs::packed_bits<bins>, packed.words.size());
+
+    auto rle = ivs::run_length_sequence<bins>{indices};
+    fmt::print("runs: {}, restored: {}\n", rle.runs(), ivs::convert_rank_to_char<bins>(rle.unpack()));
+}
@@ -0,0 +1,17 @@
+// SPDX-FileCopyrightText: 2006-2023, Knut Reinert & Freie Universität Berlin
+// SPDX-FileCopyrightText: 2016-2023, Knut Reinert & MPI für molekulare Genetik
+// SPDX-License-Identifier: CC0-1.0
+#include <ivsigma/ivsigma.h>
+#include <iostream>
+
+int main()
+{
+    auto values    = ivs::convert_char_to_rank<ivs::dna4>(std::string{"ACGTTGCAACGTAGCT"});
+    auto qualities = ivs::convert_char_to_rank<ivs::pthred42>(std::string{"IIIIIII#IIIII5II"});
+
+    auto filter = ivs::kmer_quality_filter{/*.min_quality=*/ 10, /*.max_expected_errors=*/ 0.01};
+    auto view   = ivs::quality_filtered_compact_encoding<ivs::dna4, ivs::pthred42>{values, qualities, /*.k=*/ 4, filter};
+    for (auto iter = begin(view); iter != end(view); ++iter) {
+        std::cout << iter.position() << ": " << *iter << '\n';
+    }
+}
@@ -0,0 +1,19 @@
+// SPDX-FileCopyrightText: 2006-2023, Knut Reinert & Freie Universität Berlin
+// SPDX-FileCopyrightText: 2016-2023, Knut Reinert & MPI für molekulare Genetik
+// SPDX-License-Identifier: CC0-1.0
+#include <fmt/format.h>
+#include <fmt/ranges.h>
+#include <ivsigma/ivsigma.h>
+
+int main()
+{
+    auto quality = std::string{"IIIIHHGF@@5+#"};
+    fmt::print("ranks: {}\n", ivs::decode_phred<ivs::pthred42>(quality));
+
+    auto stats = ivs::compute_quality_statistics<ivs::pthred42>(quality);
+    fmt::print("mean: {:.2f}, min: {}, expected errors: {:.3f}\n", stats.mean(), stats.min, stats.expected_errors);
+
+    if (auto pos = ivs::validate_phred<ivs::pthred42>(std::string{"II~I"})) {
+        fmt::print("invalid char at position {}\n", *pos);
+    }
+}
@@ -0,0 +1,27 @@
+// SPDX-FileCopyrightText: 2006-2023, Knut Reinert & Freie Universität Berlin
+// SPDX-FileCopyrightText: 2016-2023, Knut Reinert & MPI für molekulare Genetik
+// SPDX-License-Identifier: CC0-1.0
+#include <fmt/format.h>
+#include <fmt/ranges.h>
+#include <ivsigma/ivsigma.h>
+
+int main() {
+    auto ranks = ivs::convert_char_to_rank<ivs::dna4>(std::string{"ACGTACGTTTACGTAC"});
+
+    // k-mers with their positions
+    auto kmers = std::vector<std::pair<uint64_t, size_t>>{};
+    auto encoding = ivs::compact_encoding<ivs::dna4>{ranks, 4};
+    for (auto iter = begin(encoding); iter != end(encoding); ++iter) {
+        kmers.emplace_back(*iter, iter.position());
+    }
+    ivs::radix_sort(std::span{kmers}, [](auto const& p) { return p.first; });
+    fmt::print("sorted: {}\n", kmers);
+
+    auto values = std::vector<uint64_t>{};
+    for (auto [kmer, pos] : kmers) values.push_back(kmer);
+    for (auto [kmer, count] : ivs::radix_sort_count(values)) {
+        fmt::print("{}: {}\n", kmer, count);
+    }
+    ivs::radix_sort_unique(values);
+    fmt::print("distinct: {}\n", values);
+}
@@ -0,0 +1,25 @@
+// SPDX-FileCopyrightText: 2006-2023, Knut Reinert & Freie Universität Berlin
+// SPDX-FileCopyrightText: 2016-2023, Knut Reinert & MPI für molekulare Genetik
+// SPDX-License-Identifier: CC0-1.0
+#include <ivsigma/ivsigma.h>
+#include <iostream>
+
+int main()
+{
+    auto batch = ivs::read_batch<ivs::dna5, ivs::pthred42>{};
+    batch.push_back(std::string_view{"ACGTTGCA"}, std::string_view{"IIIIII##"}, "read1");
+    batch.push_back(std::string_view{"GGATCC"},   std::string_view{"IIIIII"},   "read2");
+
+    // bulk functions work on all reads at once
+    auto complement = ivs::complement_rank<ivs::dna5>(batch.ranks);
+    std::cout << "complement: " << ivs::convert_rank_to_char<ivs::dna5>(complement) << '\n';
+
+    // k-mers never span two reads
+    auto kmers = batch.kmers(5);
+    for (auto iter = begin(kmers); iter != end(kmers); ++iter) {
+        auto [read, pos] = batch.locate(iter.position());
+        std::cout << batch.name(read) << " pos " << pos << ": " << *iter << '\n';
+    }
+
+    batch.clear(); // buffers are kept for the next batch
+}
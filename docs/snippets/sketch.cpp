@@ -0,0 +1,29 @@
+// SPDX-FileCopyrightText: 2006-2023, Knut Reinert & Freie Universität Berlin
+// SPDX-FileCopyrightText: 2016-2023, Knut Reinert & MPI für molekulare Genetik
+// SPDX-License-Identifier: CC0-1.0
+#include <fmt/format.h>
+#include <ivsigma/ivsigma.h>
+#include <random>
+
+int main() {
+    // a random genome and a copy with about 2% substitutions
+    auto rng = std::mt19937_64{42};
+    auto a = std::vector<uint8_t>(50'000);
+    for (auto& r : a) r = rng() % 4;
+    auto b = a;
+    for (auto& r : b) {
+        if (rng() % 50 == 0) r = (r + 1) % 4;
+    }
+
+    size_t const k = 21;
+    auto sa = ivs::frac_minhash_sketch{k, 100};
+    auto sb = ivs::frac_minhash_sketch{k, 100};
+    sa.insert(ivs::compact_encoding<ivs::dna4>{a, k});
+    sb.insert(ivs::compact_encoding<ivs::dna4>{b, k});
+    fmt::print("{} and {} hashes, ANI {:.3f}\n", sa.hashes().size(), sb.hashes().size(), ivs::containment_ani(sa, sb));
+
+    auto hll = ivs::hyperloglog{};
+    hll.insert(ivs::compact_encoding<ivs::dna4>{a, k});
+    hll.insert(ivs::compact_encoding<ivs::dna4>{b, k});
+    fmt::print("about {:.0f} distinct k-mers\n", hll.cardinality());
+}
@@ -0,0 +1,19 @@
+// SPDX-FileCopyrightText: 2006-2023, Knut Reinert & Freie Universität Berlin
+// SPDX-FileCopyrightText: 2016-2023, Knut Reinert & MPI für molekulare Genetik
+// SPDX-License-Identifier: CC0-1.0
+#include <ivsigma/ivsigma.h>
+#include <iostream>
+
+int main()
+{
+    auto input = std::string{"ACGTAGCtagctagctaGCTAGCT"};
+    auto [ranks, masked] = ivs::convert_char_to_rank_soft_masked<ivs::dna4>(input);
+    for (auto [begin, end] : masked) {
+        std::cout << "masked: [" << begin << ", " << end << ")\n";
+    }
+
+    auto view = ivs::masked_compact_encoding<ivs::dna4>{ranks, masked, /*.k=*/ 4};
+    for (auto iter = begin(view); iter != end(view); ++iter) {
+        std::cout << iter.position() << ": " << *iter << '\n';
+    }
+}
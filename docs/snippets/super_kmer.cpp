@@ -0,0 +1,40 @@
+// SPDX-FileCopyrightText: 2006-2023, Knut Reinert & Freie Universität Berlin
+// SPDX-FileCopyrightText: 2016-2023, Knut Reinert & MPI für molekulare Genetik
+// SPDX-License-Identifier: CC0-1.0
+#include <filesystem>
+#include <fmt/format.h>
+#include <fmt/ranges.h>
+#include <ivsigma/ivsigma.h>
+
+int main() {
+    auto dir = std::filesystem::temp_directory_path() / "super_kmer_example";
+    std::filesystem::create_directories(dir);
+    {
+        // 4 buckets, k = 8, minimizers of size 4
+        auto partitioner = ivs::super_kmer_partitioner<ivs::dna4>{dir, 4, 8, 4};
+        for (auto s : {"ACGTACGTTTGACCATGA", "TTTGACCATGACCA", "GGGGCCCCAAAATTTT"}) {
+            partitioner.add(ivs::convert_char_to_rank<ivs::dna4>(std::string{s}));
+        }
+        partitioner.flush();
+
+        for (size_t i{0}; i < partitioner.size(); ++i) {
+            auto reader = ivs::super_kmer_reader<ivs::dna4>{partitioner.bucket_path(i)};
+            fmt::print("bucket {}:", i);
+            for (auto super_kmer = ivs::packed_span<ivs::dna4>{}; reader.next(super_kmer);) {
+                fmt::print(" {}", ivs::convert_rank_to_char<ivs::dna4>(super_kmer.unpack()));
+            }
+            fmt::print("\n");
+        }
+
+        // memory is bounded by the largest bucket
+        auto frequent = std::vector<ivs::kmer_count>{};
+        partitioner.count_buckets([&](ivs::kmer_count_table const& table) {
+            auto f = table.kmers_above(2);
+            frequent.insert(frequent.end(), f.begin(), f.end());
+        });
+        for (auto [kmer, count] : frequent) {
+            fmt::print("k-mer {} occurs {} times\n", kmer, count);
+        }
+    }
+    std::filesystem::remove_all(dir);
+}
@@ -0,0 +1,17 @@
+// SPDX-FileCopyrightText: 2006-2023, Knut Reinert & Freie Universität Berlin
+// SPDX-FileCopyrightText: 2016-2023, Knut Reinert & MPI für molekulare Genetik
+// SPDX-License-Identifier: CC0-1.0
+#include <ivsigma/ivsigma.h>
+#include <iostream>
+
+int main()
+{
+    auto input = ivs::convert_char_to_rank<ivs::dna5>(std::string{"ATGGCCAANTAAGGTTGA"});
+
+    std::cout << ivs::convert_rank_to_char<ivs::aa27>(ivs::translate_rank(input)) << '\n';
+
+    auto frames = ivs::translate_rank_six_frame<ivs::aa27, ivs::genetic_code::vertebrate_mitochondrial>(input);
+    for (auto const& frame : frames) {
+        std::cout << ivs::convert_rank_to_char<ivs::aa27>(frame) << '\n';
+    }
+}
@@ -0,0 +1,21 @@
+// SPDX-FileCopyrightText: 2006-2023, Knut Reinert & Freie Universität Berlin
+// SPDX-FileCopyrightText: 2016-2023, Knut Reinert & MPI für molekulare Genetik
+// SPDX-License-Identifier: CC0-1.0
+#include <ivsigma/ivsigma.h>
+#include <iostream>
+
+int main()
+{
+    auto read    = std::string{"ACGTTGCAACGTAGCTTAGATCGGAAGAGCACACGT"};
+    auto quality = std::string{"IIIIIIIIIIIIIIIIIIIIIIIIIIIIIII5+###"};
+    auto values    = ivs::convert_char_to_rank<ivs::dna5>(read);
+    auto qualities = ivs::convert_char_to_rank<ivs::pthred42>(quality);
+
+    std::cout << "quality trimmed length: " << ivs::quality_trim_3prime(qualities, /*.threshold=*/ 20) << '\n';
+
+    auto trimmer = ivs::read_trimmer{};
+    trimmer.quality_threshold_3prime = 20;
+    trimmer.adapter = ivs::adapter_finder{ivs::convert_char_to_rank<ivs::dna5>(std::string{"AGATCGGAAGAGC"})};
+    auto [begin, end] = trimmer.trim(values, qualities);
+    std::cout << "keep [" << begin << ", " << end << "): " << read.substr(begin, end - begin) << '\n';
+}
@@ -0,0 +1,27 @@
+// SPDX-FileCopyrightText: 2006-2023, Knut Reinert & Freie Universität Berlin
+// SPDX-FileCopyrightText: 2016-2023, Knut Reinert & MPI für molekulare Genetik
+// SPDX-License-Identifier: CC0-1.0
+#include <fmt/format.h>
+#include <fmt/ranges.h>
+#include <ivsigma/ivsigma.h>
+
+int main() {
+    // .2bit file with a single sequence "chr1": ACGTNNacgtGGA
+    auto data = std::vector<uint8_t>{
+        0x43, 0x27, 0x41, 0x1a, 0x00, 0x00, 0x00, 0x00, 0x01, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+        0x04, 0x63, 0x68, 0x72, 0x31, 0x19, 0x00, 0x00, 0x00, 0x0d, 0x00, 0x00, 0x00, 0x01, 0x00, 0x00,
+        0x00, 0x04, 0x00, 0x00, 0x00, 0x02, 0x00, 0x00, 0x00, 0x01, 0x00, 0x00, 0x00, 0x06, 0x00, 0x00,
+        0x00, 0x04, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x9c, 0x09, 0xcf, 0x80,
+    };
+    // files are opened via ivs::twobit_file{"hg38.2bit"}
+    auto file = ivs::twobit_file{std::span{reinterpret_cast<char const*>(data.data()), data.size()}};
+    auto seq  = *file.find("chr1");
+
+    fmt::print("{}: {}\n", seq.name, seq.extract_char(0, seq.size(), /*.soft_masked=*/ true));
+    fmt::print("dna5 ranks of [2, 8): {}\n", seq.extract(2, 6));
+
+    auto kmers = seq.kmers(3);
+    for (auto iter = begin(kmers); iter != end(kmers); ++iter) {
+        fmt::print("pos {}: {}\n", iter.position(), *iter);
+    }
+}
@@ -0,0 +1,140 @@
+// SPDX-FileCopyrightText: 2006-2023, Knut Reinert & Freie Universität Berlin
+// SPDX-FileCopyrightText: 2016-2023, Knut Reinert & MPI für molekulare Genetik
+// SPDX-License-Identifier: BSD-3-Clause
+#pragma once
+
+#include "compact_encoding.h"
+#include "nucliotides.h"
+#include "utility.h"
+
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <utility>
+#include <vector>
+
+namespace ivs {
+
+/*! \brief Converts dna4 ranks into both bisulfite converted strands in a single pass
+ *
+ * \param in dna4 ranks
+ * \param top dna3bs ranks, C->T converted top strand (must have same size as in)
+ * \param bottom dna3bs_ga ranks, G->A converted bottom strand (must have same size as in)
+ */
+template <uint8_t Unknown = 255>
+void convert_rank_bisulfite(std::span<uint8_t const> in, std::span<uint8_t> top, std::span<uint8_t> bottom) {
+    assert(in.size() == top.size());
+    assert(in.size() == bottom.size());
+    auto const& topTable    = detail::rank_to_rank_table<dna4, dna3bs,    rank_conversion_policy::unknown, Unknown>;
+    auto const& bottomTable = detail::rank_to_rank_table<dna4, dna3bs_ga, rank_conversion_policy::unknown, Unknown>;
+    for (size_t i{0}; i < in.size(); ++i) {
+        top[i]    = topTable[in[i]];
+        bottom[i] = bottomTable[in[i]];
+    }
+}
+
+/*! \brief Converts dna4 ranks into both bisulfite converted strands in a single pass
+ *
+ * \param in dna4 ranks
+ * \return pair of dna3bs (top strand) and dna3bs_ga (bottom strand) ranks
+ */
+template <uint8_t Unknown = 255>
+auto convert_rank_bisulfite(std::span<uint8_t const> in) -> std::pair<std::vector<uint8_t>, std::vector<uint8_t>> {
+    auto out = std::pair<std::vector<uint8_t>, std::vector<uint8_t>>{};
+    out.first.resize(in.size());
+    out.second.resize(in.size());
+    convert_rank_bisulfite<Unknown>(in, out.first, out.second);
+    return out;
+}
+
+/*! \brief K-mers of both bisulfite converted strands, computed in a single traversal of dna4 ranks
+ *
+ * Each element is a pair of the encoding of the k-mer in dna3bs (C->T, top strand)
+ * and in dna3bs_ga (G->A, bottom strand). The encodings match those of
+ * `compact_encoding<dna3bs>` and `compact_encoding<dna3bs_ga>` over the converted sequences.
+ * No canonical k-mers are taken, since the converted alphabets have no complement.
+ */
+struct bisulfite_compact_encoding {
+    std::span<uint8_t const> values;
+    size_t const k;
+    size_t const seed;
+
+    bisulfite_compact_encoding(std::span<uint8_t const> _values, size_t _k, size_t _seed = 0)
+        : values{_values}
+        , k{_k}
+        , seed{_seed}
+    {}
+
+    auto size() const -> size_t {
+        if (values.size() < k) return 0;
+        return values.size() - k + 1;
+    }
+
+    struct iterator {
+        bisulfite_compact_encoding const* ptr;
+
+        detail::compact_encoding_gadget<dna3bs::size()>    topHash;
+        detail::compact_encoding_gadget<dna3bs_ga::size()> bottomHash;
+        size_t pos{};
+
+        iterator(bisulfite_compact_encoding const& hash)
+            : ptr{&hash}
+            , topHash{ptr->k}
+            , bottomHash{ptr->k}
+        {
+            if (ptr->values.size() < ptr->k) {
+                pos = ptr->values.size();
+                return;
+            }
+            for (size_t i{0}; i < ptr->k; ++i) {
+                topHash.nextRight(0, topRank(ptr->values[i]));
+                bottomHash.nextRight(0, bottomRank(ptr->values[i]));
+            }
+            pos = ptr->k-1;
+        }
+
+        auto operator*() const -> std::pair<size_t, size_t> {
+            return {topHash.value() ^ ptr->seed, bottomHash.value() ^ ptr->seed};
+        }
+
+        /*! \brief Position of the first value of the current k-mer
+         */
+        auto position() const -> size_t {
+            return pos + 1 - ptr->k;
+        }
+
+        auto operator++() -> iterator& {
+            pos += 1;
+            if (pos >= ptr->values.size()) {
+                return *this;
+            }
+            auto rmValue  = ptr->values[pos-ptr->k];
+            auto addValue = ptr->values[pos];
+            topHash.nextRight(topRank(rmValue), topRank(addValue));
+            bottomHash.nextRight(bottomRank(rmValue), bottomRank(addValue));
+            return *this;
+        }
+
+        bool operator==(std::nullptr_t) const {
+            return pos >= ptr->values.size();
+        }
+
+    private:
+        static auto topRank(uint8_t r) -> uint8_t {
+            return convert_rank<dna4, dna3bs>(r);
+        }
+        static auto bottomRank(uint8_t r) -> uint8_t {
+            return convert_rank<dna4, dna3bs_ga>(r);
+        }
+    };
+
+    friend auto begin(bisulfite_compact_encoding const& index) -> iterator {
+        return iterator{index};
+    }
+    friend auto end(bisulfite_compact_encoding const&) -> std::nullptr_t {
+        return nullptr;
+    }
+};
+
+}
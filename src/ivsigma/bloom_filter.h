@@ -0,0 +1,245 @@
+// SPDX-FileCopyrightText: 2006-2023, Knut Reinert & Freie Universität Berlin
+// SPDX-FileCopyrightText: 2016-2023, Knut Reinert & MPI für molekulare Genetik
+// SPDX-License-Identifier: BSD-3-Clause
+#pragma once
+
+#include "concepts.h"
+#include "kmer_counter.h"
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <bit>
+#include <cassert>
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+namespace ivs {
+
+/*! \brief Bloom filter over k-mers (e.g. values of compact_encoding or winnowing_minimizer)
+ *
+ * Blocked layout: all bits of a k-mer lie in one block of 512 bits (a cache line),
+ * so inserting and querying touches a single cache line.
+ * Inserting is thread safe (bits are set atomically), queries may run concurrently with inserts.
+ */
+struct blocked_bloom_filter {
+    static constexpr size_t block_words = 8;
+
+    /*!
+     * \param bits size of the filter in bits, rounded up to full blocks
+     * \param hash_count number of bits set per k-mer (1 to 7)
+     */
+    blocked_bloom_filter(size_t bits, size_t hash_count)
+        : hashes{hash_count}
+        , blocks(std::max<size_t>(1, (bits + block_words * 64 - 1) / (block_words * 64)))
+    {
+        assert(hash_count >= 1 and hash_count <= 7);
+        assert(reinterpret_cast<uintptr_t>(blocks.data()) % 64 == 0);
+    }
+
+    //! Size in bits
+    auto size() const noexcept -> size_t { return blocks.size() * block_words * 64; }
+    auto hash_count() const noexcept -> size_t { return hashes; }
+
+    void insert(uint64_t kmer) noexcept {
+        auto h      = detail::mix_kmer(kmer);
+        auto& block = blocks[h % blocks.size()];
+        for_each_bit(h, [&](size_t bit) {
+            std::atomic_ref{block.words[bit / 64]}.fetch_or(uint64_t{1} << (bit % 64), std::memory_order_relaxed);
+        });
+    }
+
+    /*! \brief Inserts many k-mers, prefetching their blocks
+     */
+    void insert(std::span<uint64_t const> kmers) noexcept {
+        static constexpr size_t batch = 16;
+        auto hash = std::array<uint64_t, batch>{};
+        for (size_t i{0}; i < kmers.size(); i += batch) {
+            auto n = std::min(batch, kmers.size() - i);
+            for (size_t j{0}; j < n; ++j) {
+                hash[j] = detail::mix_kmer(kmers[i+j]);
+                detail::prefetch_write(&blocks[hash[j] % blocks.size()]);
+            }
+            for (size_t j{0}; j < n; ++j) {
+                auto& block = blocks[hash[j] % blocks.size()];
+                for_each_bit(hash[j], [&](size_t bit) {
+                    std::atomic_ref{block.words[bit / 64]}.fetch_or(uint64_t{1} << (bit % 64), std::memory_order_relaxed);
+                });
+            }
+        }
+    }
+
+    /*! \brief Inserts all k-mers of a k-mer view, e.g. a compact_encoding
+     */
+    template <kmer_view_c Kmers>
+        requires (!std::convertible_to<Kmers const&, std::span<uint64_t const>>)
+    void insert(Kmers const& kmers) {
+        for (auto kmer : kmers) {
+            insert(static_cast<uint64_t>(kmer));
+        }
+    }
+
+    //! false if the k-mer was never inserted, true if it was inserted or by chance
+    auto contains(uint64_t kmer) const noexcept -> bool {
+        auto h      = detail::mix_kmer(kmer);
+        auto& block = blocks[h % blocks.size()];
+        auto mask   = std::array<uint64_t, block_words>{};
+        for_each_bit(h, [&](size_t bit) {
+            mask[bit / 64] |= uint64_t{1} << (bit % 64);
+        });
+        bool res{true};
+        for (size_t i{0}; i < block_words; ++i) {
+            res &= (std::atomic_ref{const_cast<uint64_t&>(block.words[i])}.load(std::memory_order_relaxed) & mask[i]) == mask[i];
+        }
+        return res;
+    }
+
+    /*! \brief Number of k-mers of a k-mer view that are contained in the filter
+     */
+    template <kmer_view_c Kmers>
+    auto count(Kmers const& kmers) const -> size_t {
+        size_t c{0};
+        for (auto kmer : kmers) {
+            c += contains(static_cast<uint64_t>(kmer));
+        }
+        return c;
+    }
+
+private:
+    //! One cache line, allocated on a cache line boundary
+    struct alignas(64) cache_line {
+        std::array<uint64_t, block_words> words{};
+    };
+    static_assert(sizeof(cache_line) == 64);
+
+    size_t                  hashes;
+    std::vector<cache_line> blocks;
+
+    //! Derives the bit positions inside of a block from the upper bits of the hash
+    template <typename F>
+    void for_each_bit(uint64_t h, F&& f) const {
+        auto bits = detail::mix_kmer(h ^ 0x9e37'79b9'7f4a'7c15ull);
+        for (size_t i{0}; i < hashes; ++i) {
+            f(static_cast<size_t>(bits & (block_words * 64 - 1)));
+            bits >>= 9;
+        }
+    }
+};
+
+/*! \brief Bloom filters of many bins, all queried at once
+ *
+ * All bins share the same size and hash functions, the bits of all bins at the same position are stored
+ * next to each other. Querying a k-mer ANDs hash_count rows of `bins` bits, answering for all bins
+ * with a few memory accesses. Inserting into different bins from different threads is safe.
+ */
+struct interleaved_bloom_filter {
+    /*!
+     * \param bins number of bins (e.g. reference sequences or groups of them)
+     * \param bin_size size of the Bloom filter of each bin in bits
+     * \param hash_count number of hash functions
+     */
+    interleaved_bloom_filter(size_t bins, size_t bin_size, size_t hash_count)
+        : binCount{bins}
+        , binSize{std::max<size_t>(bin_size, 1)}
+        , hashes{hash_count}
+        , rowWords{(bins + 63) / 64}
+        , words(binSize * rowWords)
+    {
+        assert(bins > 0);
+        assert(hash_count >= 1 and hash_count <= 8);
+    }
+
+    auto bins() const noexcept -> size_t { return binCount; }
+    auto bin_size() const noexcept -> size_t { return binSize; }
+    auto hash_count() const noexcept -> size_t { return hashes; }
+
+    /*! \brief Inserts a k-mer into a bin
+     */
+    void insert(size_t bin, uint64_t kmer) noexcept {
+        assert(bin < binCount);
+        for_each_row(kmer, [&](size_t row) {
+            auto& word = words[row * rowWords + bin / 64];
+            std::atomic_ref{word}.fetch_or(uint64_t{1} << (bin % 64), std::memory_order_relaxed);
+        });
+    }
+
+    /*! \brief Inserts all k-mers of a k-mer view (e.g. a compact_encoding) into a bin
+     */
+    template <kmer_view_c Kmers>
+    void insert(size_t bin, Kmers const& kmers) {
+        for (auto kmer : kmers) {
+            insert(bin, static_cast<uint64_t>(kmer));
+        }
+    }
+
+    /*! \brief Bins which (probably) contain the k-mer
+     *
+     * \param out one bit per bin (must have (bins() + 63) / 64 words)
+     */
+    void query(uint64_t kmer, std::span<uint64_t> out) const noexcept {
+        assert(out.size() == rowWords);
+        auto rows = std::array<size_t, 8>{};
+        size_t n{0};
+        for_each_row(kmer, [&](size_t row) { rows[n++] = row * rowWords; });
+        std::ranges::fill(out, ~uint64_t{0});
+        for (size_t h{0}; h < n; ++h) {
+            auto const* row = words.data() + rows[h];
+            for (size_t w{0}; w < rowWords; ++w) {
+                out[w] &= row[w];
+            }
+        }
+        if (binCount % 64 != 0) out.back() &= (uint64_t{1} << (binCount % 64)) - 1;
+    }
+
+    /*! \brief Counts for every bin how many k-mers of a k-mer view it contains
+     *
+     * \param kmers k-mer view, e.g. compact_encoding or winnowing_minimizer of a read
+     * \param counts number of k-mers per bin (must have size bins()), counts are added
+     */
+    template <kmer_view_c Kmers>
+    void count(Kmers const& kmers, std::span<uint32_t> counts) const {
+        assert(counts.size() == binCount);
+        auto result = std::vector<uint64_t>(rowWords);
+        for (auto kmer : kmers) {
+            query(static_cast<uint64_t>(kmer), result);
+            for (size_t w{0}; w < rowWords; ++w) {
+                for (auto bits = result[w]; bits != 0; bits &= bits - 1) {
+                    counts[w * 64 + static_cast<size_t>(std::countr_zero(bits))] += 1;
+                }
+            }
+        }
+    }
+
+    /*! \brief Counts for every bin how many k-mers of a k-mer view it contains
+     *
+     * \return number of k-mers per bin
+     */
+    template <kmer_view_c Kmers>
+    auto count(Kmers const& kmers) const -> std::vector<uint32_t> {
+        auto counts = std::vector<uint32_t>(binCount);
+        count(kmers, counts);
+        return counts;
+    }
+
+private:
+    size_t                binCount;
+    size_t                binSize;
+    size_t                hashes;
+    size_t                rowWords;
+    std::vector<uint64_t> words;
+
+    //! Rows of a k-mer via double hashing
+    template <typename F>
+    void for_each_row(uint64_t kmer, F&& f) const {
+        auto h1 = detail::mix_kmer(kmer);
+        auto h2 = detail::mix_kmer(h1) | 1;
+        for (size_t i{0}; i < hashes; ++i) {
+            f(static_cast<size_t>((h1 + i * h2) % binSize));
+        }
+    }
+};
+
+}
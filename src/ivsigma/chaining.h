@@ -0,0 +1,308 @@
+// SPDX-FileCopyrightText: 2006-2023, Knut Reinert & Freie Universität Berlin
+// SPDX-FileCopyrightText: 2016-2023, Knut Reinert & MPI für molekulare Genetik
+// SPDX-License-Identifier: BSD-3-Clause
+#pragma once
+
+#include "interval.h"
+#include "minimizer_index.h"
+#include "radix_sort.h"
+
+#include <algorithm>
+#include <bit>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <numeric>
+#include <span>
+#include <utility>
+#include <vector>
+
+namespace ivs {
+
+/*! \brief Matching minimizers between a query and reference sequences, stored as structure of arrays
+ *
+ * Query positions of reverse anchors are mirrored (query_length - position - span),
+ * so anchors of both strands are colinear with increasing query and reference positions.
+ */
+struct anchors {
+    size_t                query_length{}; //!< length of the query
+    size_t                span{};         //!< number of values covered by each anchor, e.g. k of the minimizers
+    std::vector<uint32_t> sequence;       //!< reference sequence
+    std::vector<uint8_t>  reverse;        //!< 1 if query and reference are on different strands
+    std::vector<int32_t>  reference;      //!< position in the reference
+    std::vector<int32_t>  query;          //!< position in the query, mirrored for reverse anchors
+
+    auto size() const noexcept -> size_t { return query.size(); }
+
+    void clear() noexcept {
+        sequence.clear();
+        reverse.clear();
+        reference.clear();
+        query.clear();
+    }
+
+    /*! \brief Adds an anchor
+     *
+     * Positions must be smaller than 2^31 (as guaranteed by minimizer_index).
+     * \param query_position position in the query (not mirrored)
+     */
+    void push_back(uint32_t seq, bool rev, size_t reference_position, size_t query_position) {
+        assert(query_position + span <= query_length);
+        sequence.push_back(seq);
+        reverse.push_back(rev);
+        reference.push_back(static_cast<int32_t>(reference_position));
+        query.push_back(static_cast<int32_t>(rev ? query_length - query_position - span : query_position));
+    }
+
+    /*! \brief Sorts anchors by sequence, strand, reference and query position (as required by chaining)
+     */
+    void sort(size_t threads = 1) {
+        auto order = std::vector<uint32_t>(size());
+        std::iota(order.begin(), order.end(), 0);
+        // stable LSD passes from the least significant field to the most significant one
+        radix_sort(std::span{order}, [&](uint32_t i) { return static_cast<uint32_t>(query[i]); }, threads);
+        radix_sort(std::span{order}, [&](uint32_t i) { return static_cast<uint32_t>(reference[i]); }, threads);
+        radix_sort(std::span{order}, [&](uint32_t i) { return uint64_t{sequence[i]} << 1 | reverse[i]; }, threads);
+        permute(sequence, order);
+        permute(reverse, order);
+        permute(reference, order);
+        permute(query, order);
+    }
+
+private:
+    template <typename T>
+    static void permute(std::vector<T>& values, std::span<uint32_t const> order) {
+        auto res = std::vector<T>(values.size());
+        for (size_t i{0}; i < order.size(); ++i) {
+            res[i] = values[order[i]];
+        }
+        values = std::move(res);
+    }
+};
+
+/*! \brief Collects the anchors of a query from a minimizer_index
+ *
+ * \param out anchors of the query, sorted
+ */
+template <alphabet_c Alphabet, bool UseCanonicalKmers>
+void collect_anchors(minimizer_index<Alphabet, UseCanonicalKmers> const& index, std::span<uint8_t const> query, anchors& out) {
+    out.clear();
+    out.query_length = query.size();
+    out.span         = index.k();
+    index.for_each_hit(query, [&](size_t pos, bool reverse, std::span<minimizer_hit const> hits) {
+        for (auto hit : hits) {
+            out.push_back(hit.sequence, hit.reverse() != reverse, hit.position(), pos);
+        }
+    });
+    out.sort();
+}
+
+/*! \brief Parameters of chain_anchors and chain_anchors_colinear
+ */
+struct chaining_options {
+    int32_t max_gap{5000};      //!< largest distance between two chained anchors, in query and in reference
+    int32_t bandwidth{500};     //!< largest difference between the query and the reference distance
+    size_t  max_lookback{50};   //!< number of preceding anchors considered by chain_anchors
+    int32_t min_score{40};      //!< smallest score of a reported chain
+    size_t  min_anchors{3};     //!< smallest number of anchors of a reported chain
+};
+
+/*! \brief A chain of colinear anchors
+ */
+struct chain {
+    uint32_t              sequence{};  //!< reference sequence
+    bool                  reverse{};   //!< query and reference are on different strands
+    int32_t               score{};
+    interval              query{};     //!< covered query interval (not mirrored)
+    interval              reference{}; //!< covered reference interval
+    std::vector<uint32_t> anchors;     //!< indices of the anchors, increasing
+};
+
+}
+
+namespace ivs::detail {
+
+/**
+ * Gap cost of minimap2: 0.01 * span * gap + 0.5 * log2(gap + 1).
+ * log2 is rounded down via the exponent of a float, keeping the function vectorizable.
+ */
+constexpr auto chain_gap_cost(int32_t gap, int32_t span) noexcept -> int32_t {
+    auto log2 = (std::bit_cast<int32_t>(static_cast<float>(gap + 1)) >> 23) - 127;
+    return static_cast<int32_t>(0.01f * static_cast<float>(span) * static_cast<float>(gap) + 0.5f * static_cast<float>(log2));
+}
+
+/**
+ * Extracts chains from the scores and predecessors of all anchors.
+ * Anchors are visited by decreasing score, each anchor is used by at most one chain;
+ * a chain reaching an anchor of a better chain is cut there and scored without the shared prefix.
+ */
+inline auto backtrack_chains(anchors const& a, std::span<int32_t const> score, std::span<int64_t const> parent, chaining_options const& options) -> std::vector<chain> {
+    auto order = std::vector<uint32_t>(a.size());
+    std::iota(order.begin(), order.end(), 0);
+    std::ranges::stable_sort(order, std::greater{}, [&](uint32_t i) { return score[i]; });
+
+    auto used   = std::vector<bool>(a.size());
+    auto chains = std::vector<chain>{};
+    for (auto last : order) {
+        if (used[last]) continue;
+        auto c = chain{};
+        int64_t i = last;
+        for (; i >= 0 and !used[i]; i = parent[i]) {
+            used[i] = true;
+            c.anchors.push_back(static_cast<uint32_t>(i));
+        }
+        c.score = score[last] - (i >= 0 ? score[i] : 0);
+        if (c.score < options.min_score or c.anchors.size() < options.min_anchors) continue;
+
+        std::ranges::reverse(c.anchors);
+        auto first = c.anchors.front();
+        c.sequence  = a.sequence[last];
+        c.reverse   = a.reverse[last];
+        c.reference = {static_cast<size_t>(a.reference[first]), static_cast<size_t>(a.reference[last]) + a.span};
+        auto qb     = static_cast<size_t>(a.query[first]);
+        auto qe     = static_cast<size_t>(a.query[last]) + a.span;
+        c.query     = c.reverse ? interval{a.query_length - qe, a.query_length - qb} : interval{qb, qe};
+        chains.push_back(std::move(c));
+    }
+    // cut chains may have lost their position
+    std::ranges::stable_sort(chains, std::greater{}, &chain::score);
+    return chains;
+}
+
+/**
+ * Fenwick tree over positions, reporting the maximum (score, anchor) of a prefix
+ */
+struct max_fenwick_tree {
+    std::vector<std::pair<int32_t, int64_t>> tree;
+
+    explicit max_fenwick_tree(size_t n)
+        : tree(n + 1, {0, -1})
+    {}
+
+    void update(size_t pos, std::pair<int32_t, int64_t> v) {
+        for (auto i{pos + 1}; i < tree.size(); i += i & (~i + 1)) {
+            tree[i] = std::max(tree[i], v);
+        }
+    }
+
+    //! Maximum over positions [0, pos)
+    auto query(size_t pos) const -> std::pair<int32_t, int64_t> {
+        auto res = std::pair<int32_t, int64_t>{0, -1};
+        for (auto i{pos}; i > 0; i -= i & (~i + 1)) {
+            res = std::max(res, tree[i]);
+        }
+        return res;
+    }
+};
+
+}
+
+namespace ivs {
+
+/*! \brief Chains anchors via dynamic programming with gap costs (as minimap2)
+ *
+ * The score of anchor i is f(i) = max(span, max_j f(j) + min(dq, dr, span) - gap_cost(|dq - dr|))
+ * over up to max_lookback preceding anchors j on the same sequence and strand,
+ * with 0 < dq, dr <= max_gap and |dq - dr| <= bandwidth.
+ * The scores of all predecessors of an anchor are computed branch free over the arrays of `a`
+ * (vectorized by the compiler), before the best one is selected.
+ *
+ * \param a anchors, sorted via anchors::sort
+ * \return chains sorted by decreasing score
+ */
+inline auto chain_anchors(anchors const& a, chaining_options const& options = {}) -> std::vector<chain> {
+    auto n      = a.size();
+    auto span   = static_cast<int32_t>(a.span);
+    auto score  = std::vector<int32_t>(n);
+    auto parent = std::vector<int64_t>(n, -1);
+    auto cand   = std::vector<int32_t>(options.max_lookback);
+
+    size_t group{0}; // first anchor on the same sequence and strand
+    for (size_t i{0}; i < n; ++i) {
+        if (a.sequence[i] != a.sequence[group] or a.reverse[i] != a.reverse[group]) group = i;
+        score[i] = span;
+
+        // predecessors in reach
+        auto lo = i - std::min(i - group, options.max_lookback);
+        while (lo < i and a.reference[i] - a.reference[lo] > options.max_gap) ++lo;
+        auto count = i - lo;
+        if (count == 0) continue;
+
+        auto ti        = a.reference[i];
+        auto qi        = a.query[i];
+        auto maxGap    = options.max_gap;
+        auto bandwidth = options.bandwidth;
+        auto const* t  = a.reference.data() + lo;
+        auto const* q  = a.query.data() + lo;
+        auto const* f  = score.data() + lo;
+        auto* out      = cand.data();
+        for (size_t j{0}; j < count; ++j) {
+            auto dr    = ti - t[j];                                   // in [0, max_gap]
+            auto dq    = std::min(std::max(qi - q[j], -1), maxGap + 1);
+            auto gap   = std::max(dr - dq, dq - dr);
+            auto match = std::min(std::min(dr, dq), span);
+            bool valid = (dr > 0) & (dq > 0) & (dq <= maxGap) & (gap <= bandwidth);
+            auto sc    = f[j] + match - detail::chain_gap_cost(gap, span);
+            // select via masks, a conditional would keep gcc from vectorizing (float conversions may trap)
+            auto mask  = -static_cast<int32_t>(valid);
+            out[j]     = (sc & mask) | (std::numeric_limits<int32_t>::min() & ~mask);
+        }
+        auto best = std::ranges::max_element(cand.begin(), cand.begin() + static_cast<std::ptrdiff_t>(count));
+        if (*best > score[i]) {
+            score[i]  = *best;
+            parent[i] = static_cast<int64_t>(lo) + (best - cand.begin());
+        }
+    }
+    return detail::backtrack_chains(a, score, parent, options);
+}
+
+/*! \brief Chains anchors by the heaviest colinear subset, O(n log n)
+ *
+ * Faster than chain_anchors, without gap costs: each chain consists of anchors with strictly increasing query and
+ * reference positions and its score is span times the number of anchors. Chains are split where consecutive anchors
+ * are more than max_gap apart in the reference; bandwidth and max_lookback are ignored.
+ *
+ * \param a anchors, sorted via anchors::sort
+ * \return chains sorted by decreasing score
+ */
+inline auto chain_anchors_colinear(anchors const& a, chaining_options const& options = {}) -> std::vector<chain> {
+    auto n      = a.size();
+    auto span   = static_cast<int32_t>(a.span);
+    auto score  = std::vector<int32_t>(n);
+    auto parent = std::vector<int64_t>(n, -1);
+
+    for (size_t first{0}; first < n;) {
+        // segment of anchors on the same sequence and strand without large reference gaps
+        auto last = first + 1;
+        while (last < n and a.sequence[last] == a.sequence[first] and a.reverse[last] == a.reverse[first]
+               and a.reference[last] - a.reference[last-1] <= options.max_gap) {
+            ++last;
+        }
+
+        // query positions compressed to ranks
+        auto qs = std::vector<int32_t>(a.query.begin() + first, a.query.begin() + last);
+        std::ranges::sort(qs);
+        auto [e, end] = std::ranges::unique(qs);
+        qs.erase(e, end);
+        auto rank = [&](int32_t q) { return static_cast<size_t>(std::ranges::lower_bound(qs, q) - qs.begin()); };
+
+        auto tree = detail::max_fenwick_tree{qs.size()};
+        for (auto i{first}; i < last;) {
+            // anchors with equal reference position must not chain with each other
+            auto j = i;
+            for (; j < last and a.reference[j] == a.reference[i]; ++j) {
+                auto [best, p] = tree.query(rank(a.query[j]));
+                score[j]  = best + span;
+                parent[j] = p;
+            }
+            for (; i < j; ++i) {
+                tree.update(rank(a.query[i]), {score[i], static_cast<int64_t>(i)});
+            }
+        }
+        first = last;
+    }
+    return detail::backtrack_chains(a, score, parent, options);
+}
+
+}
@@ -5,9 +5,11 @@
 
 #include "concepts.h"
 
+#include <algorithm>
 #include <cassert>
 #include <cstdint>
 #include <cmath>
+#include <ranges>
 #include <span>
 
 namespace ivs::detail {
@@ -53,43 +55,55 @@ struct compact_encoding_gadget {
     }
 };
 
-template <alphabet_c Alphabet, bool UseCanonicalKmers>
+template <alphabet_c Alphabet, bool UseCanonicalKmers, std::ranges::forward_range Values = std::span<uint8_t const>>
 struct compact_encoding {
-    std::span<uint8_t const> values;
+    Values values;
     size_t const k;
     size_t const seed;
 
-   compact_encoding(std::span<uint8_t const> _values, size_t _k, size_t _seed = 0)
+   compact_encoding(Values _values, size_t _k, size_t _seed = 0)
         : values{_values}
         , k{_k}
         , seed{_seed}
     {}
 
     auto size() const -> size_t {
-        if (values.size() < k) return 0;
-        return values.size() - k + 1;
+        auto len = static_cast<size_t>(std::ranges::distance(values));
+        if (len < k) return 0;
+        return len - k + 1;
     }
 
     struct iterator {
+        using ValuesIter = std::ranges::iterator_t<Values const>;
+
         compact_encoding const* ptr;
 
         compact_encoding_gadget<Alphabet::size()> fwdHash;
         compact_encoding_gadget<Alphabet::size()> bwdHash;
         size_t minHash{};
-        size_t pos{};
+        size_t pos{};      // index of the last value of the current k-mer
+        ValuesIter first;  // first value of the current k-mer
+        ValuesIter last;   // last value of the current k-mer
+        bool atEnd{};
 
         iterator(compact_encoding const& hash)
             : ptr{&hash}
             , fwdHash{ptr->k}
             , bwdHash{ptr->k}
+            , first{std::ranges::begin(ptr->values)}
+            , last{first}
         {
-            if (ptr->k <= ptr->size()) {
-                for (size_t i{0}; i < ptr->k; ++i) {
-                    auto addValue = ptr->values[i];
-                    fwdHash.nextRight(0, addValue);
-                    if constexpr (alphabet_with_complement_c<Alphabet>) {
-                        bwdHash.nextLeft(0, Alphabet::complement_rank(addValue));
-                    }
+            auto sentinel = std::ranges::end(ptr->values);
+            for (size_t i{0}; i < ptr->k; ++i) {
+                if (i > 0) ++last;
+                if (last == sentinel) {
+                    atEnd = true;
+                    return;
+                }
+                auto addValue = *last;
+                fwdHash.nextRight(0, addValue);
+                if constexpr (alphabet_with_complement_c<Alphabet>) {
+                    bwdHash.nextLeft(0, Alphabet::complement_rank(addValue));
                 }
             }
             pos = ptr->k-1;
@@ -102,16 +116,30 @@ struct compact_encoding {
         auto operator*() const -> size_t {
             return minHash;
         }
+
+        /*! \brief Position of the first value of the current k-mer
+         */
+        auto position() const -> size_t {
+            return pos + 1 - ptr->k;
+        }
+
+        /*! \brief Iterator to the first value of the current k-mer
+         */
+        auto kmer() const -> ValuesIter {
+            return first;
+        }
+
         auto operator++() -> iterator& {
             pos += 1;
-            if (pos >= ptr->values.size()) {
+            ++last;
+            if (last == std::ranges::end(ptr->values)) {
+                atEnd = true;
                 return *this;
             }
 
-            assert(pos < ptr->values.size());
-
-            auto rmValue  = ptr->values[pos-ptr->k];
-            auto addValue = ptr->values[pos];
+            auto rmValue  = *first;
+            auto addValue = *last;
+            ++first;
             fwdHash.nextRight(rmValue, addValue);
             if constexpr (alphabet_with_complement_c<Alphabet> and UseCanonicalKmers) {
                 bwdHash.nextLeft(Alphabet::complement_rank(rmValue), Alphabet::complement_rank(addValue));
@@ -122,7 +150,7 @@ struct compact_encoding {
             return *this;
         }
         bool operator==(std::nullptr_t) const {
-            return pos >= ptr->values.size();
+            return atEnd;
         }
     };
 
@@ -137,7 +165,7 @@ struct compact_encoding {
 
 namespace ivs {
 
-template <alphabet_c Alphabet, bool UseCanonicalKmers=true>
-using compact_encoding = detail::compact_encoding<Alphabet, UseCanonicalKmers>;
+template <alphabet_c Alphabet, bool UseCanonicalKmers=true, std::ranges::forward_range Values = std::span<uint8_t const>>
+using compact_encoding = detail::compact_encoding<Alphabet, UseCanonicalKmers, Values>;
 
 }
@@ -0,0 +1,243 @@
+// SPDX-FileCopyrightText: 2006-2023, Knut Reinert & Freie Universität Berlin
+// SPDX-FileCopyrightText: 2016-2023, Knut Reinert & MPI für molekulare Genetik
+// SPDX-License-Identifier: BSD-3-Clause
+#pragma once
+
+#include "concepts.h"
+#include "packed_sequence.h"
+
+#include <array>
+#include <bit>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <ranges>
+#include <span>
+
+namespace ivs {
+
+/*! \brief Counts how often each rank occurs
+ *
+ * Uses several independent counter tables to avoid dependencies between
+ * consecutive increments of the same counter.
+ *
+ * \tparam Alphabet describes the used alphabet
+ * \param in rank input
+ * \return number of occurrences per rank, invalid ranks are not counted
+ */
+template <alphabet_c Alphabet>
+auto rank_histogram(std::span<uint8_t const> in) -> std::array<size_t, Alphabet::size()> {
+    auto tables = std::array<std::array<size_t, 256>, 4>{};
+    size_t i{0};
+    for (; i + 4 <= in.size(); i += 4) {
+        tables[0][in[i+0]] += 1;
+        tables[1][in[i+1]] += 1;
+        tables[2][in[i+2]] += 1;
+        tables[3][in[i+3]] += 1;
+    }
+    for (; i < in.size(); ++i) {
+        tables[0][in[i]] += 1;
+    }
+    auto res = std::array<size_t, Alphabet::size()>{};
+    for (size_t r{0}; r < res.size(); ++r) {
+        res[r] = tables[0][r] + tables[1][r] + tables[2][r] + tables[3][r];
+    }
+    return res;
+}
+
+/*! \brief Counts how often each rank occurs in a packed sequence
+ *
+ * For small alphabets whole words are compared against each rank and counted via popcount.
+ *
+ * \tparam Alphabet describes the used alphabet
+ * \param in packed rank input
+ * \return number of occurrences per rank
+ */
+template <alphabet_c Alphabet>
+auto rank_histogram(packed_span<Alphabet> in) -> std::array<size_t, Alphabet::size()> {
+    using Layout = typename packed_span<Alphabet>::Layout;
+    auto res = std::array<size_t, Alphabet::size()>{};
+
+    if constexpr (Alphabet::size() <= 8) {
+        // bit set at the lowest bit of every field
+        constexpr auto lowBits = []() {
+            uint64_t v{};
+            for (size_t j{0}; j < Layout::ranks_per_word; ++j) {
+                v |= uint64_t{1} << (j * Layout::bits);
+            }
+            return v;
+        }();
+        auto countWord = [&](uint64_t word, uint64_t fields) {
+            for (size_t r{0}; r < res.size(); ++r) {
+                // all bits of a field are zero, if the field equals r
+                auto x = word ^ (lowBits * r);
+                auto y = x;
+                for (size_t b{1}; b < Layout::bits; ++b) {
+                    y |= x >> b;
+                }
+                res[r] += std::popcount(~y & fields);
+            }
+        };
+        auto fullWords = in.size() / Layout::ranks_per_word;
+        for (size_t w{0}; w < fullWords; ++w) {
+            countWord(in.words[w], lowBits);
+        }
+        auto rest = in.size() % Layout::ranks_per_word;
+        if (rest > 0) {
+            auto fields = lowBits & ((uint64_t{1} << (rest * Layout::bits)) - 1);
+            countWord(in.words[fullWords], fields);
+        }
+    } else {
+        for (auto r : in) {
+            if (r < res.size()) {
+                res[r] += 1;
+            }
+        }
+    }
+    return res;
+}
+
+/*! \brief Composition of a window of a sequence
+ */
+template <alphabet_c Alphabet>
+struct window_composition {
+    std::array<size_t, Alphabet::size()> counts{}; //!< occurrences of each rank
+    size_t position{};                             //!< position of the first value of the window
+    size_t length{};                               //!< number of values in the window
+    size_t cpg{};                                  //!< number of CG dinucleotides in the window
+
+    /*! \brief Number of occurrences of a symbol (0 if not part of the alphabet)
+     */
+    auto count(char c) const -> size_t {
+        auto r = Alphabet::char_to_rank(c);
+        if (r >= counts.size()) return 0;
+        return counts[r];
+    }
+
+    /*! \brief Fraction of C and G among all A, C, G and T
+     */
+    auto gc_fraction() const -> double {
+        auto gc  = count('C') + count('G');
+        auto all = gc + count('A') + count('T');
+        if (all == 0) return 0.;
+        return static_cast<double>(gc) / all;
+    }
+
+    /*! \brief Number of CG dinucleotides per dinucleotide of the window
+     */
+    auto cpg_density() const -> double {
+        if (length < 2) return 0.;
+        return static_cast<double>(cpg) / (length - 1);
+    }
+
+    /*! \brief Ratio of observed to expected CG dinucleotides
+     */
+    auto cpg_observed_expected() const -> double {
+        auto expected = count('C') * count('G');
+        if (expected == 0) return 0.;
+        return static_cast<double>(cpg) * length / expected;
+    }
+};
+
+/*! \brief Composition of sliding windows over a sequence
+ *
+ * Reports the composition of every window of size `window`, starting every `step` positions.
+ * Each position is updated in O(1). Only complete windows are reported.
+ * Accepts any forward range of ranks, e.g. a `std::span<uint8_t const>` or a `packed_span`.
+ */
+template <alphabet_c Alphabet, std::ranges::forward_range Values = std::span<uint8_t const>>
+struct sliding_composition {
+    Values values;
+    size_t const window;
+    size_t const step;
+
+    sliding_composition(Values _values, size_t _window, size_t _step = 1)
+        : values{_values}
+        , window{_window}
+        , step{_step}
+    {
+        assert(window > 0);
+        assert(step > 0);
+    }
+
+    struct iterator {
+        using ValuesIter = std::ranges::iterator_t<Values const>;
+
+        static constexpr uint8_t rankC  = Alphabet::char_to_rank('C');
+        static constexpr uint8_t rankG  = Alphabet::char_to_rank('G');
+        static constexpr bool    hasCpG = rankC < Alphabet::size() and rankG < Alphabet::size();
+
+        sliding_composition const* ptr;
+        window_composition<Alphabet> stats{};
+        ValuesIter first;
+        ValuesIter last;  // one behind the window
+        uint8_t    lastValue{255};
+        bool       atEnd{};
+
+        iterator(sliding_composition const& composition)
+            : ptr{&composition}
+            , first{std::ranges::begin(ptr->values)}
+            , last{first}
+        {
+            stats.length = ptr->window;
+            for (size_t i{0}; i < ptr->window; ++i) {
+                if (!add()) return;
+            }
+        }
+
+        auto operator*() const -> window_composition<Alphabet> const& {
+            return stats;
+        }
+
+        auto operator++() -> iterator& {
+            for (size_t i{0}; i < ptr->step; ++i) {
+                if (!add()) return *this;
+                remove();
+            }
+            stats.position += ptr->step;
+            return *this;
+        }
+
+        bool operator==(std::nullptr_t) const {
+            return atEnd;
+        }
+
+    private:
+        auto add() -> bool {
+            if (last == std::ranges::end(ptr->values)) {
+                atEnd = true;
+                return false;
+            }
+            auto v = static_cast<uint8_t>(*last);
+            ++last;
+            if (v < stats.counts.size()) {
+                stats.counts[v] += 1;
+            }
+            if (hasCpG and lastValue == rankC and v == rankG) {
+                stats.cpg += 1;
+            }
+            lastValue = v;
+            return true;
+        }
+
+        void remove() {
+            auto v = static_cast<uint8_t>(*first);
+            ++first;
+            if (v < stats.counts.size()) {
+                stats.counts[v] -= 1;
+            }
+            if (hasCpG and v == rankC and *first == rankG) {
+                stats.cpg -= 1;
+            }
+        }
+    };
+
+    friend auto begin(sliding_composition const& composition) -> iterator {
+        return iterator{composition};
+    }
+    friend auto end(sliding_composition const&) -> std::nullptr_t {
+        return nullptr;
+    }
+};
+
+}
@@ -27,5 +27,15 @@ concept alphabet_with_complement_c = requires(Alphabet) {
     { Alphabet::complement_char(char{}) } -> std::same_as<char>;
 };
 
+/*! \brief Sequence of k-mer values, e.g. a compact_encoding, a winnowing_minimizer or a std::vector<uint64_t>
+ *
+ * Excludes single k-mers, so overloads taking one uint64_t are picked for any integer argument.
+ */
+template <typename Kmers>
+concept kmer_view_c = requires(Kmers const& kmers) {
+    static_cast<uint64_t>(*begin(kmers));
+    { begin(kmers) == end(kmers) } -> std::convertible_to<bool>;
+};
+
 
 }
@@ -0,0 +1,195 @@
+// SPDX-FileCopyrightText: 2006-2023, Knut Reinert & Freie Universität Berlin
+// SPDX-FileCopyrightText: 2016-2023, Knut Reinert & MPI für molekulare Genetik
+// SPDX-License-Identifier: BSD-3-Clause
+#pragma once
+
+#include "compact_encoding.h"
+#include "interval.h"
+#include "nucliotides.h"
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <span>
+#include <vector>
+
+namespace ivs {
+
+/*! \brief Symmetric DUST (SDUST) low complexity masker
+ *
+ * Implements the algorithm of Morgulis et al. (2006) in linear time.
+ * Triplets are scored via a 3-mer `compact_encoding<dna4>`. Ranks 0-3 are
+ * interpreted as A, C, G and T (as in dna4, dna5 and iupac), any other
+ * rank (e.g. N) separates the input into independent pieces.
+ * Buffers are kept between calls, so a masker should be reused.
+ */
+struct sdust_masker {
+    size_t threshold{20};
+    size_t window{64};
+
+private:
+    static constexpr int wordLength = 3;
+    static constexpr int words      = 64;
+
+    struct perfect_interval {
+        int64_t start;
+        int64_t finish;
+        int64_t r;
+        int64_t l;
+    };
+
+    int64_t T{};
+    int64_t W{};
+
+    std::deque<uint8_t>           w;     // triplets of the current window
+    std::vector<perfect_interval> P;     // sorted by descending start and then by ascending finish
+    std::array<int64_t, words>    cv{};
+    std::array<int64_t, words>    cw{};
+    int64_t                       rv{};
+    int64_t                       rw{};
+    int64_t                       L{};
+
+public:
+    sdust_masker() = default;
+    sdust_masker(size_t _threshold, size_t _window)
+        : threshold{_threshold}
+        , window{_window}
+    {}
+
+    /*! \brief Computes low complexity intervals
+     *
+     * \param in nucleotide ranks
+     * \param out sorted, non overlapping masked intervals
+     */
+    void mask(std::span<uint8_t const> in, std::vector<interval>& out) {
+        T = threshold;
+        W = window;
+        out.clear();
+        size_t pos{0};
+        while (pos < in.size()) {
+            while (pos < in.size() and in[pos] >= 4) ++pos;
+            auto runEnd = pos;
+            while (runEnd < in.size() and in[runEnd] < 4) ++runEnd;
+            maskRun(in.subspan(pos, runEnd - pos), pos, out);
+            pos = runEnd;
+        }
+    }
+
+    /*! \brief Computes low complexity intervals
+     *
+     * \param in nucleotide ranks
+     * \return sorted, non overlapping masked intervals
+     */
+    auto mask(std::span<uint8_t const> in) -> std::vector<interval> {
+        auto out = std::vector<interval>{};
+        mask(in, out);
+        return out;
+    }
+
+private:
+    void maskRun(std::span<uint8_t const> run, size_t offset, std::vector<interval>& res) {
+        w.clear();
+        P.clear();
+        cv.fill(0);
+        cw.fill(0);
+        rv = rw = L = 0;
+
+        auto encoding = compact_encoding<dna4, /*UseCanonicalKmers=*/false>{run, wordLength};
+        for (auto iter = begin(encoding); iter != end(encoding); ++iter) {
+            auto l     = static_cast<int64_t>(iter.pos) + 1; // number of bases seen
+            auto start = std::max<int64_t>(l - W, 0) + static_cast<int64_t>(offset);
+            saveMaskedRegions(res, start);
+            shiftWindow(*iter);
+            if (rw * 10 > L * T) {
+                findPerfect(start);
+            }
+        }
+        // clear up unsaved perfect intervals
+        auto l     = static_cast<int64_t>(run.size());
+        auto start = std::max<int64_t>(l - W + 1, 0) + static_cast<int64_t>(offset) + 1;
+        while (!P.empty()) {
+            saveMaskedRegions(res, start++);
+        }
+    }
+
+    void shiftWindow(uint8_t t) {
+        if (static_cast<int64_t>(w.size()) >= W - wordLength + 1) {
+            auto s = w.front();
+            w.pop_front();
+            rw -= --cw[s];
+            if (L > static_cast<int64_t>(w.size())) {
+                --L;
+                rv -= --cv[s];
+            }
+        }
+        w.push_back(t);
+        ++L;
+        rw += cw[t]++;
+        rv += cv[t]++;
+        if (cv[t] * 10 > T * 2) {
+            uint8_t s;
+            do {
+                s = w[w.size() - L];
+                rv -= --cv[s];
+                --L;
+            } while (s != t);
+        }
+    }
+
+    void saveMaskedRegions(std::vector<interval>& res, int64_t start) {
+        if (P.empty() or P.back().start >= start) return;
+        auto const& p = P.back();
+        if (!res.empty() and p.start <= static_cast<int64_t>(res.back().end)) {
+            res.back().end = std::max<size_t>(res.back().end, p.finish);
+        } else {
+            res.push_back({static_cast<size_t>(p.start), static_cast<size_t>(p.finish)});
+        }
+        // remove perfect intervals that have fallen out of the window
+        auto i = static_cast<int64_t>(P.size()) - 1;
+        for (; i >= 0 and P[i].start < start; --i);
+        P.resize(i + 1);
+    }
+
+    void findPerfect(int64_t start) {
+        auto c = cv;
+        auto r = rv;
+        int64_t maxR{0}, maxL{0};
+        auto size = static_cast<int64_t>(w.size());
+        for (auto i = size - L - 1; i >= 0; --i) {
+            auto t = w[i];
+            r += c[t]++;
+            auto newR = r;
+            auto newL = size - i - 1;
+            if (newR * 10 > T * newL) {
+                size_t j{0};
+                for (; j < P.size() and P[j].start >= i + start; ++j) { // find insertion position
+                    auto const& p = P[j];
+                    if (maxR == 0 or p.r * maxL > maxR * p.l) {
+                        maxR = p.r;
+                        maxL = p.l;
+                    }
+                }
+                if (maxR == 0 or newR * maxL >= maxR * newL) {
+                    maxR = newR;
+                    maxL = newL;
+                    P.insert(P.begin() + j, {i + start, size + (wordLength - 1) + start, newR, newL});
+                }
+            }
+        }
+    }
+};
+
+/*! \brief Computes low complexity intervals with the SDUST algorithm
+ *
+ * \param in nucleotide ranks (see sdust_masker)
+ * \param threshold score threshold
+ * \param window window size
+ * \return sorted, non overlapping masked intervals
+ */
+inline auto sdust(std::span<uint8_t const> in, size_t threshold = 20, size_t window = 64) -> std::vector<interval> {
+    return sdust_masker{threshold, window}.mask(in);
+}
+
+}
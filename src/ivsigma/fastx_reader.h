@@ -0,0 +1,511 @@
+// SPDX-FileCopyrightText: 2006-2023, Knut Reinert & Freie Universität Berlin
+// SPDX-FileCopyrightText: 2016-2023, Knut Reinert & MPI für molekulare Genetik
+// SPDX-License-Identifier: BSD-3-Clause
+#pragma once
+
+#include "concepts.h"
+#include "qualities.h"
+#include "read_batch.h"
+#include "utility.h"
+
+#include <algorithm>
+#include <cassert>
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <limits>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#if defined(_WIN32) || defined(__EMSCRIPTEN__) || !__has_include(<sys/mman.h>)
+#define IVS_MAPPED_FILE_FALLBACK 1
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace ivs {
+
+/*! \brief Expected access pattern of a mapped file, passed to the kernel via madvise
+ */
+enum class map_advice {
+    sequential, //!< read ahead aggressively
+    random,     //!< no read ahead
+    huge_pages, //!< back the mapping by huge pages, if supported
+};
+
+/*! \brief A read only file mapped into memory
+ *
+ * Uses mmap where available. On platforms without mmap (Windows, emscripten) the
+ * file is read into memory instead.
+ */
+struct mapped_file {
+    mapped_file() = default;
+
+    /*!
+     * \param path file to map, throws std::runtime_error if it can not be opened
+     * \param advice expected access pattern
+     */
+    explicit mapped_file(std::filesystem::path const& path, [[maybe_unused]] map_advice advice = map_advice::sequential) {
+#ifdef IVS_MAPPED_FILE_FALLBACK
+        auto ifs = std::ifstream{path, std::ios::binary};
+        if (!ifs) throw std::runtime_error{"can not open " + path.string()};
+        buffer.assign(std::istreambuf_iterator<char>{ifs}, std::istreambuf_iterator<char>{});
+        ptr  = buffer.data();
+        size = buffer.size();
+#else
+        auto fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0) throw std::runtime_error{"can not open " + path.string()};
+        struct stat st{};
+        if (::fstat(fd, &st) != 0) {
+            ::close(fd);
+            throw std::runtime_error{"can not stat " + path.string()};
+        }
+        size = static_cast<size_t>(st.st_size);
+        if (size > 0) {
+            auto addr = ::mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+            if (addr == MAP_FAILED) {
+                ::close(fd);
+                throw std::runtime_error{"can not map " + path.string()};
+            }
+            if (advice == map_advice::sequential) {
+                ::madvise(addr, size, MADV_SEQUENTIAL);
+            } else if (advice == map_advice::random) {
+                ::madvise(addr, size, MADV_RANDOM);
+            } else {
+#ifdef MADV_HUGEPAGE
+                ::madvise(addr, size, MADV_HUGEPAGE);
+#endif
+            }
+            ptr = static_cast<char const*>(addr);
+        }
+        ::close(fd);
+#endif
+    }
+
+    mapped_file(mapped_file const&) = delete;
+    mapped_file(mapped_file&& other) noexcept {
+        *this = std::move(other);
+    }
+    auto operator=(mapped_file const&) -> mapped_file& = delete;
+    auto operator=(mapped_file&& other) noexcept -> mapped_file& {
+        if (this != &other) {
+            unmap();
+#ifdef IVS_MAPPED_FILE_FALLBACK
+            buffer = std::move(other.buffer);
+            ptr    = buffer.data();
+#else
+            ptr    = other.ptr;
+#endif
+            size   = other.size;
+            other.ptr  = nullptr;
+            other.size = 0;
+        }
+        return *this;
+    }
+    ~mapped_file() {
+        unmap();
+    }
+
+    auto data() const noexcept -> std::span<char const> {
+        return {ptr, size};
+    }
+
+private:
+    char const* ptr{};
+    size_t      size{};
+#ifdef IVS_MAPPED_FILE_FALLBACK
+    std::vector<char> buffer;
+#endif
+
+    void unmap() noexcept {
+#ifndef IVS_MAPPED_FILE_FALLBACK
+        if (ptr) ::munmap(const_cast<char*>(ptr), size);
+#endif
+        ptr  = nullptr;
+        size = 0;
+    }
+};
+
+namespace detail {
+
+/*! \brief Calls f for each line of in, without the line breaks ('\n' or "\r\n")
+ */
+template <typename F>
+void for_each_line(std::span<char const> in, F&& f) {
+    auto first = in.data();
+    auto last  = in.data() + in.size();
+    while (first != last) {
+        auto nl  = static_cast<char const*>(std::memchr(first, '\n', static_cast<size_t>(last - first)));
+        auto end = nl ? nl : last;
+        auto len = static_cast<size_t>(end - first);
+        if (len > 0 and first[len-1] == '\r') --len;
+        if (len > 0) f(std::span<char const>{first, len});
+        first = nl ? nl + 1 : last;
+    }
+}
+
+//! Removes trailing line breaks
+inline auto trim_line_breaks(std::span<char const> in) -> std::span<char const> {
+    auto len = in.size();
+    while (len > 0 and (in[len-1] == '\n' or in[len-1] == '\r')) --len;
+    return in.first(len);
+}
+
+}
+
+/*! \brief Converts a multi line string to ranks, skipping line breaks
+ *
+ * Each line is converted directly into out, no intermediate copy is made.
+ *
+ * \tparam Alphabet describes the used alphabet
+ * \param in string with line breaks
+ * \param out ranks are appended to out
+ */
+template <alphabet_c Alphabet, uint8_t Unknown = 255>
+void convert_lines_to_rank(std::span<char const> in, std::vector<uint8_t>& out) {
+    detail::for_each_line(in, [&](std::span<char const> line) {
+        auto pos = out.size();
+        out.resize(pos + line.size());
+        convert_char_to_rank<Alphabet, Unknown>(line, std::span{out}.subspan(pos));
+    });
+}
+
+/*! \brief Decodes a multi line quality string, skipping line breaks
+ *
+ * \tparam Alphabet describes the used quality alphabet
+ * \param in quality string with line breaks
+ * \param out quality ranks are appended to out
+ * \return true if all chars were valid quality chars
+ */
+template <quality_alphabet_c Alphabet, uint8_t Unknown = 255>
+auto decode_phred_lines(std::span<char const> in, std::vector<uint8_t>& out) -> bool {
+    bool valid{true};
+    detail::for_each_line(in, [&](std::span<char const> line) {
+        auto pos = out.size();
+        out.resize(pos + line.size());
+        valid &= decode_phred<Alphabet, Unknown>(line, std::span{out}.subspan(pos));
+    });
+    return valid;
+}
+
+/*! \brief A single FASTA or FASTQ record
+ *
+ * All members point into the parsed buffer. `sequence` and `quality` are the raw text
+ * of the record, they contain line breaks if `line_breaks` is set.
+ */
+struct fastx_record {
+    std::string_view      name;            //!< header line without '>' or '@'
+    std::span<char const> sequence;        //!< raw sequence text
+    std::span<char const> quality;         //!< raw quality text, empty for FASTA records
+    bool                  line_breaks{};   //!< sequence or quality span multiple lines
+
+    /*! \brief Sequence without line breaks
+     *
+     * \param buffer used to store the sequence, only if it has line breaks
+     * \return view into the parsed buffer, or into buffer
+     */
+    auto sequence_chars(std::vector<char>& buffer) const -> std::span<char const> {
+        if (!line_breaks) return sequence;
+        buffer.clear();
+        detail::for_each_line(sequence, [&](std::span<char const> line) {
+            buffer.insert(buffer.end(), line.begin(), line.end());
+        });
+        return buffer;
+    }
+};
+
+/*! \brief Iterates over the records of a reader providing `next(fastx_record&)`
+ */
+template <typename Source>
+struct fastx_iterator {
+    Source*      ptr;
+    fastx_record record;
+    bool         valid;
+
+    fastx_iterator(Source& source)
+        : ptr{&source}
+    {
+        valid = ptr->next(record);
+    }
+
+    auto operator*() const -> fastx_record const& {
+        return record;
+    }
+
+    auto operator++() -> fastx_iterator& {
+        valid = ptr->next(record);
+        return *this;
+    }
+
+    bool operator==(std::nullptr_t) const {
+        return !valid;
+    }
+};
+
+/*! \brief Parses FASTA and FASTQ records from a buffer
+ *
+ * The format is detected per record by its first char ('>' or '@'), a buffer should not mix both formats.
+ * Lines are found via memchr, no data is copied. Throws std::runtime_error on malformed input.
+ * If `last_chunk` is false, data is treated as prefix of a larger text and records
+ * that might continue behind the end of data are not reported.
+ */
+struct fastx_parser {
+    std::span<char const> data;
+    size_t                pos{};       //!< begin of the next record
+    bool                  last_chunk{true}; //!< data contains the end of the text
+
+    fastx_parser() = default;
+    explicit fastx_parser(std::span<char const> _data, bool _last_chunk = true)
+        : data{_data}
+        , last_chunk{_last_chunk}
+    {
+        skip_empty_lines();
+    }
+
+    /*! \brief Continues with new data after next returned false on an incomplete record
+     *
+     * The new data must start with the incomplete record (the old data from pos on) followed by more text,
+     * the part of the record that was already scanned is not scanned again.
+     */
+    void resume_with(std::span<char const> _data, bool _last_chunk) {
+        data       = _data;
+        pos        = 0;
+        last_chunk = _last_chunk;
+        skip_empty_lines();
+    }
+
+    /*! \brief Parses the next record
+     *
+     * \param record is overwritten by the next record
+     * \return false if the end of data was reached (or the next record is incomplete, if not last_chunk)
+     */
+    auto next(fastx_record& record) -> bool {
+        if (pos >= data.size()) return false;
+        bool complete{};
+        if (data[pos] == '>') {
+            complete = parse_fasta(record);
+        } else if (data[pos] == '@') {
+            complete = parse_fastq(record);
+        } else {
+            throw std::runtime_error{"expected '>' or '@' at position " + std::to_string(pos)};
+        }
+        if (!complete) return false;
+        skip_empty_lines();
+        return true;
+    }
+
+    using iterator = fastx_iterator<fastx_parser>;
+
+    friend auto begin(fastx_parser& parser) -> iterator {
+        return iterator{parser};
+    }
+    friend auto end(fastx_parser&) -> std::nullptr_t {
+        return nullptr;
+    }
+
+private:
+    /** State of a partially scanned record, offsets are relative to pos */
+    struct scan_state {
+        size_t offset{};     // scanning continues here
+        size_t length{};     // fastq: length of the sequence
+        size_t lines{};      // fastq: number of sequence and quality lines
+        size_t seqEnd{};     // fastq: end of the sequence lines, 0 while still scanning them
+        size_t qualBegin{};  // fastq: begin of the quality lines
+        size_t qualLength{}; // fastq: length of the qualities
+    };
+    scan_state resume{};
+
+    auto find(char c, size_t from) const -> size_t {
+        if (from >= data.size()) return data.size();
+        auto p = static_cast<char const*>(std::memchr(data.data() + from, c, data.size() - from));
+        return p ? static_cast<size_t>(p - data.data()) : data.size();
+    }
+
+    // end of the line starting at from, without the line break
+    auto line_end(size_t from) const -> size_t {
+        return find('\n', from);
+    }
+
+    void skip_empty_lines() {
+        while (pos < data.size() and (data[pos] == '\n' or data[pos] == '\r')) ++pos;
+    }
+
+    auto header(size_t& p) const -> std::string_view {
+        auto e = line_end(p);
+        auto name = std::string_view{data.data() + p + 1, e - p - 1};
+        if (!name.empty() and name.back() == '\r') name.remove_suffix(1);
+        p = std::min(e + 1, data.size());
+        return name;
+    }
+
+    auto parse_fasta(fastx_record& record) -> bool {
+        auto p = pos;
+        record.name = header(p);
+        // '>' can only start a header, a line break in front of it ends the sequence
+        auto e = std::max(p, pos + resume.offset);
+        while (true) {
+            e = find('>', e);
+            if (e == data.size() or data[e-1] == '\n') break;
+            ++e;
+        }
+        if (!last_chunk and e == data.size()) {
+            resume.offset = e - pos;
+            return false;
+        }
+        record.sequence    = detail::trim_line_breaks(data.subspan(p, e - p));
+        record.quality     = {};
+        record.line_breaks = std::memchr(record.sequence.data(), '\n', record.sequence.size()) != nullptr;
+        pos    = e;
+        resume = {};
+        return true;
+    }
+
+    auto parse_fastq(fastx_record& record) -> bool {
+        auto p = pos;
+        record.name = header(p);
+
+        auto seqBegin   = p;
+        auto length     = resume.length;
+        auto lines      = resume.lines;
+        auto seqEnd     = resume.seqEnd == 0 ? size_t{0} : pos + resume.seqEnd;
+        auto qualBegin  = pos + resume.qualBegin;
+        auto qualLength = resume.qualLength;
+        p = std::max(p, pos + resume.offset);
+
+        // remembers how far the record was scanned, only complete lines are scanned
+        auto incomplete = [&](size_t at) {
+            resume = {at - pos, length, lines, seqEnd == 0 ? 0 : seqEnd - pos, qualBegin - pos, qualLength};
+            return false;
+        };
+
+        if (seqEnd == 0) {
+            // sequence lines until a line starting with '+'
+            while (p < data.size() and data[p] != '+') {
+                auto e = line_end(p);
+                if (!last_chunk and e == data.size()) return incomplete(p);
+                length += e - p - (e > p and data[e-1] == '\r');
+                lines  += 1;
+                p = std::min(e + 1, data.size());
+            }
+            if (p >= data.size()) {
+                if (!last_chunk) return incomplete(p);
+                throw std::runtime_error{"missing '+' line of record " + std::string{record.name}};
+            }
+            // skip '+' line
+            auto e = line_end(p);
+            if (!last_chunk and e == data.size()) return incomplete(p);
+            seqEnd    = p;
+            p         = std::min(e + 1, data.size());
+            qualBegin = p;
+        }
+
+        // quality lines until as many chars as the sequence are read ('@' is a valid quality char)
+        while (qualLength < length and p < data.size()) {
+            auto e = line_end(p);
+            if (!last_chunk and e == data.size()) return incomplete(p);
+            qualLength += e - p - (e > p and data[e-1] == '\r');
+            lines      += 1;
+            p = std::min(e + 1, data.size());
+        }
+        if (!last_chunk and qualLength < length) return incomplete(p);
+        if (qualLength != length) {
+            throw std::runtime_error{"sequence and quality length differ in record " + std::string{record.name}};
+        }
+        record.sequence    = detail::trim_line_breaks(data.subspan(seqBegin, seqEnd - seqBegin));
+        record.quality     = detail::trim_line_breaks(data.subspan(qualBegin, p - qualBegin));
+        record.line_breaks = lines > 2;
+        pos    = p;
+        resume = {};
+        return true;
+    }
+};
+
+/*! \brief Reads FASTA and FASTQ files via a memory mapping
+ *
+ * Records are views into the mapping and stay valid as long as the reader exists.
+ */
+struct fastx_reader {
+    mapped_file  file;
+    fastx_parser parser;
+
+    explicit fastx_reader(std::filesystem::path const& path)
+        : file{path}
+        , parser{file.data()}
+    {}
+
+    auto next(fastx_record& record) -> bool {
+        return parser.next(record);
+    }
+
+    friend auto begin(fastx_reader& reader) -> fastx_parser::iterator {
+        return begin(reader.parser);
+    }
+    friend auto end(fastx_reader&) -> std::nullptr_t {
+        return nullptr;
+    }
+};
+
+/*! \brief Converts a record and appends it to a read batch
+ *
+ * Multi line sequences and qualities are converted line by line directly into the batch.
+ * Throws std::runtime_error on invalid quality chars, on a quality of different length than the sequence
+ * and on mixing records with and without qualities; the batch is left unchanged.
+ */
+template <alphabet_c Alphabet, quality_alphabet_c QualityAlphabet>
+void append_record(read_batch<Alphabet, QualityAlphabet>& batch, fastx_record const& record) {
+    if (!record.line_breaks) {
+        batch.push_back(record.sequence, record.quality, record.name);
+        return;
+    }
+    auto begin = batch.offsets.back();
+    auto fail  = [&](std::string const& message) {
+        batch.ranks.resize(begin);
+        batch.qualities.resize(std::min(batch.qualities.size(), begin));
+        throw std::runtime_error{message + std::string{record.name}};
+    };
+    convert_lines_to_rank<Alphabet>(record.sequence, batch.ranks);
+    if (!record.quality.empty()) {
+        if (batch.qualities.size() != begin) fail("reads with and without qualities mixed at read ");
+        if (!decode_phred_lines<QualityAlphabet>(record.quality, batch.qualities)) fail("invalid quality char in read ");
+        if (batch.qualities.size() != batch.ranks.size()) fail("sequence and quality length differ in read ");
+    } else if (!batch.qualities.empty() and batch.ranks.size() != begin) {
+        fail("reads with and without qualities mixed at read ");
+    }
+    batch.offsets.push_back(batch.ranks.size());
+    batch.names.insert(batch.names.end(), record.name.begin(), record.name.end());
+    batch.name_offsets.push_back(batch.names.size());
+}
+
+/*! \brief Replaces the content of a read batch by the next records of a reader
+ *
+ * \param source reader of the records, e.g. fastx_parser or fastx_reader
+ * \param batch cleared and filled, allocated memory is reused
+ * \param max_reads maximal number of reads
+ * \param max_bases no further reads are added once this many bases were read
+ * \return number of reads in the batch, 0 if the parser is exhausted
+ */
+template <typename Source, alphabet_c Alphabet, quality_alphabet_c QualityAlphabet>
+    requires requires(Source& s, fastx_record& r) {
+        { s.next(r) } -> std::same_as<bool>;
+    }
+auto read_batch_from(Source& source, read_batch<Alphabet, QualityAlphabet>& batch, size_t max_reads, size_t max_bases = std::numeric_limits<size_t>::max()) -> size_t {
+    batch.clear();
+    auto record = fastx_record{};
+    while (batch.size() < max_reads and batch.total_length() < max_bases and source.next(record)) {
+        append_record(batch, record);
+    }
+    return batch.size();
+}
+
+}
@@ -0,0 +1,227 @@
+// SPDX-FileCopyrightText: 2006-2023, Knut Reinert & Freie Universität Berlin
+// SPDX-FileCopyrightText: 2016-2023, Knut Reinert & MPI für molekulare Genetik
+// SPDX-License-Identifier: BSD-3-Clause
+#pragma once
+
+#include "concepts.h"
+#include "packed_sequence.h"
+#include "qualities.h"
+#include "read_batch.h"
+
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <limits>
+#include <ostream>
+#include <span>
+#include <stdexcept>
+#include <string_view>
+#include <vector>
+
+namespace ivs {
+
+/*! \brief Writes FASTA and FASTQ records from rank space
+ *
+ * Ranks are converted to chars directly into a large output buffer, line breaks are inserted
+ * while converting. The buffer is written in one piece once it is full, or on `flush`.
+ * Failed writes throw std::runtime_error.
+ *
+ * \tparam Alphabet alphabet of the sequences, e.g. dna5
+ * \tparam QualityAlphabet alphabet of the qualities
+ */
+template <alphabet_c Alphabet, quality_alphabet_c QualityAlphabet = pthred94>
+struct fastx_writer {
+    size_t line_width{80}; //!< number of chars per FASTA line, 0 disables line breaks
+
+    /*!
+     * \param path output file, throws std::runtime_error if it can not be opened
+     * \param _line_width number of chars per FASTA line, 0 disables line breaks
+     * \param buffer_size size of the output buffer
+     */
+    explicit fastx_writer(std::filesystem::path const& path, size_t _line_width = 80, size_t buffer_size = size_t{1} << 20)
+        : line_width{_line_width}
+        , file{path, std::ios::binary}
+        , out{&file}
+    {
+        if (!file) throw std::runtime_error{"can not open " + path.string()};
+        buffer.resize(std::max<size_t>(buffer_size, 1024));
+    }
+
+    /*!
+     * \param _out output stream, must outlive the writer
+     * \param _line_width number of chars per FASTA line, 0 disables line breaks
+     * \param buffer_size size of the output buffer
+     */
+    explicit fastx_writer(std::ostream& _out, size_t _line_width = 80, size_t buffer_size = size_t{1} << 20)
+        : line_width{_line_width}
+        , out{&_out}
+    {
+        buffer.resize(std::max<size_t>(buffer_size, 1024));
+    }
+
+    fastx_writer(fastx_writer const&) = delete;
+    auto operator=(fastx_writer const&) -> fastx_writer& = delete;
+
+    //! Flushes the buffer, call flush() before to be notified of write errors
+    ~fastx_writer() {
+        try {
+            flush();
+        } catch (std::runtime_error const&) {}
+    }
+
+    /*! \brief Writes a FASTA record
+     *
+     * \param name name of the record (without '>')
+     * \param ranks ranks of the sequence
+     */
+    void write_fasta(std::string_view name, std::span<uint8_t const> ranks) {
+        header('>', name);
+        lines(ranks, line_width);
+    }
+
+    /*! \brief Writes a FASTA record of packed ranks
+     */
+    void write_fasta(std::string_view name, packed_span<Alphabet> ranks) {
+        header('>', name);
+        packed_lines(ranks, line_width);
+    }
+
+    /*! \brief Writes a FASTQ record
+     *
+     * \param name name of the record (without '@')
+     * \param ranks ranks of the sequence
+     * \param qualities quality ranks (must have same size as ranks)
+     */
+    void write_fastq(std::string_view name, std::span<uint8_t const> ranks, std::span<uint8_t const> qualities) {
+        assert(ranks.size() == qualities.size());
+        header('@', name);
+        lines(ranks, 0);
+        put("+\n");
+        quality_line(qualities);
+    }
+
+    /*! \brief Writes a FASTQ record of packed ranks
+     */
+    void write_fastq(std::string_view name, packed_span<Alphabet> ranks, std::span<uint8_t const> qualities) {
+        assert(ranks.size() == qualities.size());
+        header('@', name);
+        packed_lines(ranks, 0);
+        put("+\n");
+        quality_line(qualities);
+    }
+
+    /*! \brief Writes all reads of a batch, as FASTQ if the batch has qualities, otherwise as FASTA
+     */
+    void write(read_batch<Alphabet, QualityAlphabet> const& batch) {
+        for (size_t i{0}; i < batch.size(); ++i) {
+            if (batch.has_qualities()) {
+                write_fastq(batch.name(i), batch.sequence(i), batch.quality(i));
+            } else {
+                write_fasta(batch.name(i), batch.sequence(i));
+            }
+        }
+    }
+
+    /*! \brief Writes the buffer to the output, throws std::runtime_error on failure
+     */
+    void flush() {
+        if (used > 0) write_buffer();
+        out->flush();
+        if (!*out) throw std::runtime_error{"can not write fastx output"};
+    }
+
+private:
+    std::ofstream     file;
+    std::ostream*     out;
+    std::vector<char> buffer;
+    size_t            used{};
+
+    //! Ensures n chars fit into the buffer, n must not exceed the buffer size
+    void reserve(size_t n) {
+        assert(n <= buffer.size());
+        if (used + n > buffer.size()) write_buffer();
+    }
+
+    void write_buffer() {
+        out->write(buffer.data(), static_cast<std::streamsize>(used));
+        used = 0;
+        if (!*out) throw std::runtime_error{"can not write fastx output"};
+    }
+
+    void put(std::string_view s) {
+        while (!s.empty()) {
+            reserve(std::min(s.size(), buffer.size()));
+            auto n = std::min(s.size(), buffer.size() - used);
+            std::ranges::copy(s.substr(0, n), buffer.data() + used);
+            used += n;
+            s.remove_prefix(n);
+        }
+    }
+
+    void header(char marker, std::string_view name) {
+        reserve(1);
+        buffer[used++] = marker;
+        put(name);
+        put("\n");
+    }
+
+    /*! \brief Converts ranks and inserts a line break every width chars
+     *
+     * \param column number of chars already written to the current line
+     */
+    void convert(std::span<uint8_t const> ranks, size_t width, size_t& column) {
+        if (width == 0) width = std::numeric_limits<size_t>::max();
+        while (!ranks.empty()) {
+            auto n = std::min({ranks.size(), width - column, buffer.size() - 1});
+            reserve(n + 1);
+            auto dst = buffer.data() + used;
+            for (size_t i{0}; i < n; ++i) {
+                dst[i] = Alphabet::rank_to_char(ranks[i]);
+            }
+            used   += n;
+            column += n;
+            ranks   = ranks.subspan(n);
+            if (column == width) {
+                buffer[used++] = '\n';
+                column = 0;
+            }
+        }
+    }
+
+    void lines(std::span<uint8_t const> ranks, size_t width) {
+        size_t column{0};
+        convert(ranks, width, column);
+        if (column > 0 or ranks.empty()) put("\n");
+    }
+
+    void packed_lines(packed_span<Alphabet> ranks, size_t width) {
+        auto block = std::array<uint8_t, 4096>{};
+        size_t column{0};
+        for (size_t i{0}; i < ranks.size(); i += block.size()) {
+            auto n = std::min(block.size(), ranks.size() - i);
+            ranks.unpack(i, std::span{block}.first(n));
+            convert(std::span{block}.first(n), width, column);
+        }
+        if (column > 0 or ranks.empty()) put("\n");
+    }
+
+    void quality_line(std::span<uint8_t const> qualities) {
+        while (!qualities.empty()) {
+            auto n = std::min(qualities.size(), buffer.size());
+            reserve(n);
+            auto dst = buffer.data() + used;
+            for (size_t i{0}; i < n; ++i) {
+                dst[i] = QualityAlphabet::rank_to_char(qualities[i]);
+            }
+            used     += n;
+            qualities = qualities.subspan(n);
+        }
+        put("\n");
+    }
+};
+
+}
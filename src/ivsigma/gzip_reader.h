@@ -0,0 +1,669 @@
+// SPDX-FileCopyrightText: 2006-2023, Knut Reinert & Freie Universität Berlin
+// SPDX-FileCopyrightText: 2016-2023, Knut Reinert & MPI für molekulare Genetik
+// SPDX-License-Identifier: BSD-3-Clause
+#pragma once
+
+#include "fastx_reader.h"
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cassert>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <exception>
+#include <limits>
+#include <mutex>
+#include <optional>
+#include <span>
+#include <stdexcept>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace ivs {
+namespace detail {
+
+//! CRC-32 as used by gzip, computed 8 bytes at a time (slicing by 8)
+struct crc32 {
+    static constexpr std::array<std::array<uint32_t, 256>, 8> tables{[]() {
+        auto t = std::array<std::array<uint32_t, 256>, 8>{};
+        for (uint32_t i{0}; i < 256; ++i) {
+            auto c = i;
+            for (size_t j{0}; j < 8; ++j) {
+                c = (c & 1) ? (0xedb8'8320u ^ (c >> 1)) : (c >> 1);
+            }
+            t[0][i] = c;
+        }
+        for (size_t k{1}; k < 8; ++k) {
+            for (size_t i{0}; i < 256; ++i) {
+                t[k][i] = (t[k-1][i] >> 8) ^ t[0][t[k-1][i] & 0xff];
+            }
+        }
+        return t;
+    }()};
+
+    static auto compute(std::span<char const> in, uint32_t crc = 0) noexcept -> uint32_t {
+        crc = ~crc;
+        auto p = reinterpret_cast<uint8_t const*>(in.data());
+        auto n = in.size();
+        for (; n >= 8; n -= 8, p += 8) {
+            auto lo = crc ^ (uint32_t{p[0]} | uint32_t{p[1]} << 8 | uint32_t{p[2]} << 16 | uint32_t{p[3]} << 24);
+            crc = tables[7][lo & 0xff] ^ tables[6][(lo >> 8) & 0xff] ^ tables[5][(lo >> 16) & 0xff] ^ tables[4][lo >> 24]
+                ^ tables[3][p[4]] ^ tables[2][p[5]] ^ tables[1][p[6]] ^ tables[0][p[7]];
+        }
+        for (; n > 0; --n, ++p) {
+            crc = tables[0][(crc ^ *p) & 0xff] ^ (crc >> 8);
+        }
+        return ~crc;
+    }
+};
+
+/*! \brief Canonical huffman code of deflate
+ *
+ * Codes up to FastBits bits are decoded by a single table lookup,
+ * longer codes are decoded bit by bit.
+ */
+struct huffman_code {
+    static constexpr size_t FastBits = 10;
+
+    std::array<uint16_t, 16>            count{};  // number of codes of each length
+    std::array<uint16_t, 320>           symbol{}; // symbols ordered by code
+    std::array<uint16_t, 1 << FastBits> fast{};   // symbol << 4 | length, 0 if the code is longer
+
+    //! returns false if the lengths are over-subscribed
+    auto build(std::span<uint8_t const> lengths) -> bool {
+        count.fill(0);
+        fast.fill(0);
+        for (auto l : lengths) ++count[l];
+        count[0] = 0;
+        int left{1};
+        for (size_t len{1}; len < 16; ++len) {
+            left = (left << 1) - count[len];
+            if (left < 0) return false;
+        }
+        auto offsets = std::array<uint16_t, 16>{};
+        for (size_t len{1}; len < 15; ++len) {
+            offsets[len+1] = offsets[len] + count[len];
+        }
+        for (size_t s{0}; s < lengths.size(); ++s) {
+            if (lengths[s] != 0) symbol[offsets[lengths[s]]++] = static_cast<uint16_t>(s);
+        }
+        uint32_t code{0};
+        size_t   index{0};
+        for (size_t len{1}; len <= FastBits; ++len) {
+            for (size_t i{0}; i < count[len]; ++i, ++code, ++index) {
+                uint32_t rev{0};
+                for (size_t b{0}; b < len; ++b) {
+                    rev |= ((code >> b) & 1) << (len - 1 - b);
+                }
+                for (auto j = rev; j < fast.size(); j += 1u << len) {
+                    fast[j] = static_cast<uint16_t>(symbol[index] << 4 | len);
+                }
+            }
+            code <<= 1;
+        }
+        return true;
+    }
+};
+
+/*! \brief Decoder of raw deflate streams (RFC 1951)
+ *
+ * Throws std::runtime_error on corrupt input.
+ */
+struct inflater {
+    std::span<uint8_t const> in;
+    size_t                   pos{};    // next byte of in to load into bits
+    uint64_t                 bits{};
+    size_t                   bitCount{};
+
+    explicit inflater(std::span<uint8_t const> _in) : in{_in} {}
+
+    //! Number of bytes of in that were consumed
+    auto consumed() const noexcept -> size_t {
+        return pos - bitCount / 8;
+    }
+
+    /*! \brief Decompresses a single deflate stream
+     *
+     * \param out decompressed data is appended
+     * \param flush called with the oldest data whenever more than flushSize bytes are buffered in out,
+     *        all but the last 32KiB (the deflate window) are handed over and removed from out
+     */
+    template <typename Flush>
+    void inflate(std::vector<char>& out, size_t flushSize, Flush&& flush) {
+        auto start = out.size();
+        size_t n   = start;
+        bool last{false};
+        while (!last) {
+            last = get(1);
+            auto type = get(2);
+            if (type == 0) {
+                stored(out, n);
+                if (n - start > flushSize + window) flush_window(out, n, start, flush);
+            } else if (type == 1) {
+                codes(out, n, start, fixed_codes().first, fixed_codes().second, flushSize, flush);
+            } else if (type == 2) {
+                auto [lit, dist] = dynamic_codes();
+                codes(out, n, start, lit, dist, flushSize, flush);
+            } else {
+                throw std::runtime_error{"invalid deflate block type"};
+            }
+        }
+        out.resize(n);
+        if (consumed() > in.size()) throw std::runtime_error{"unexpected end of deflate stream"};
+    }
+
+    void inflate(std::vector<char>& out) {
+        inflate(out, std::numeric_limits<size_t>::max() / 2, [](std::span<char const>) {});
+    }
+
+private:
+    static constexpr size_t window = 32768;
+
+    static constexpr std::array<uint16_t, 29> lengthBase  {3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31, 35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258};
+    static constexpr std::array<uint8_t,  29> lengthExtra {0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2, 3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0};
+    static constexpr std::array<uint16_t, 30> distBase    {1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193, 257, 385, 513, 769, 1025, 1537, 2049, 3073, 4097, 6145, 8193, 12289, 16385, 24577};
+    static constexpr std::array<uint8_t,  30> distExtra   {0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6, 7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13};
+
+    // ensures at least 56 bits are available, reading past the end of in yields zeros
+    void refill() {
+        if (std::endian::native == std::endian::little and pos + 8 <= in.size()) {
+            uint64_t v;
+            std::memcpy(&v, in.data() + pos, 8);
+            bits |= v << bitCount;
+            pos  += (63 - bitCount) / 8;
+            bitCount |= 56;
+            return;
+        }
+        while (bitCount <= 56) {
+            if (pos > in.size() + 8) throw std::runtime_error{"unexpected end of deflate stream"};
+            uint64_t v = pos < in.size() ? in[pos] : 0;
+            bits |= v << bitCount;
+            pos      += 1;
+            bitCount += 8;
+        }
+    }
+
+    auto get(size_t n) -> uint32_t {
+        if (bitCount < n) refill();
+        auto v = static_cast<uint32_t>(bits & ((uint64_t{1} << n) - 1));
+        bits    >>= n;
+        bitCount -= n;
+        return v;
+    }
+
+    auto decode(huffman_code const& h) -> uint16_t {
+        if (bitCount < 15) refill();
+        auto e = h.fast[bits & ((1u << huffman_code::FastBits) - 1)];
+        if (e != 0) {
+            bits    >>= (e & 15);
+            bitCount -= (e & 15);
+            return e >> 4;
+        }
+        int code{0}, first{0}, index{0};
+        for (size_t len{1}; len < 16; ++len) {
+            code |= static_cast<int>((bits >> (len - 1)) & 1);
+            int c = h.count[len];
+            if (code - c < first) {
+                bits    >>= len;
+                bitCount -= len;
+                return h.symbol[index + (code - first)];
+            }
+            index += c;
+            first += c;
+            first <<= 1;
+            code  <<= 1;
+        }
+        throw std::runtime_error{"invalid huffman code"};
+    }
+
+    static void reserve(std::vector<char>& out, size_t n) {
+        if (out.size() < n) out.resize(std::max(n, out.size() * 2));
+    }
+
+    void stored(std::vector<char>& out, size_t& n) {
+        get(bitCount % 8);
+        auto len  = get(16);
+        auto nlen = get(16);
+        if ((len ^ 0xffff) != nlen) throw std::runtime_error{"invalid stored deflate block"};
+        // hand back buffered bytes
+        pos     -= bitCount / 8;
+        bits     = 0;
+        bitCount = 0;
+        if (pos + len > in.size()) throw std::runtime_error{"unexpected end of deflate stream"};
+        reserve(out, n + len);
+        std::memcpy(out.data() + n, in.data() + pos, len);
+        n   += len;
+        pos += len;
+    }
+
+    static auto fixed_codes() -> std::pair<huffman_code, huffman_code> const& {
+        static auto const codes = []() {
+            auto lengths = std::array<uint8_t, 288>{};
+            std::fill(lengths.begin(),       lengths.begin() + 144, 8);
+            std::fill(lengths.begin() + 144, lengths.begin() + 256, 9);
+            std::fill(lengths.begin() + 256, lengths.begin() + 280, 7);
+            std::fill(lengths.begin() + 280, lengths.end(),         8);
+            auto res = std::pair<huffman_code, huffman_code>{};
+            res.first.build(lengths);
+            auto dist = std::array<uint8_t, 30>{};
+            dist.fill(5);
+            res.second.build(dist);
+            return res;
+        }();
+        return codes;
+    }
+
+    auto dynamic_codes() -> std::pair<huffman_code, huffman_code> {
+        static constexpr std::array<uint8_t, 19> order{16, 17, 18, 0, 8, 7, 9, 6, 10, 5, 11, 4, 12, 3, 13, 2, 14, 1, 15};
+        auto nlen  = get(5) + 257;
+        auto ndist = get(5) + 1;
+        auto ncode = get(4) + 4;
+        if (nlen > 286 or ndist > 30) throw std::runtime_error{"invalid dynamic deflate block"};
+
+        auto lengths = std::array<uint8_t, 320>{};
+        for (size_t i{0}; i < ncode; ++i) {
+            lengths[order[i]] = static_cast<uint8_t>(get(3));
+        }
+        auto lencode = huffman_code{};
+        if (!lencode.build(std::span{lengths}.first(19))) throw std::runtime_error{"invalid dynamic deflate block"};
+
+        lengths.fill(0);
+        for (size_t i{0}; i < nlen + ndist;) {
+            auto sym = decode(lencode);
+            if (sym < 16) {
+                lengths[i++] = static_cast<uint8_t>(sym);
+                continue;
+            }
+            uint8_t value{0};
+            size_t  repeat{};
+            if (sym == 16) {
+                if (i == 0) throw std::runtime_error{"invalid dynamic deflate block"};
+                value  = lengths[i-1];
+                repeat = 3 + get(2);
+            } else if (sym == 17) {
+                repeat = 3 + get(3);
+            } else {
+                repeat = 11 + get(7);
+            }
+            if (i + repeat > nlen + ndist) throw std::runtime_error{"invalid dynamic deflate block"};
+            std::fill_n(lengths.begin() + i, repeat, value);
+            i += repeat;
+        }
+        if (lengths[256] == 0) throw std::runtime_error{"missing end of block code"};
+
+        auto res = std::pair<huffman_code, huffman_code>{};
+        if (!res.first.build(std::span{lengths}.first(nlen))
+            or !res.second.build(std::span{lengths}.subspan(nlen, ndist))) {
+            throw std::runtime_error{"invalid dynamic deflate block"};
+        }
+        return res;
+    }
+
+    // hands all but the last window bytes to flush
+    template <typename Flush>
+    static void flush_window(std::vector<char>& out, size_t& n, size_t start, Flush& flush) {
+        flush(std::span<char const>{out.data() + start, n - start - window});
+        std::memmove(out.data() + start, out.data() + n - window, window);
+        n = start + window;
+    }
+
+    template <typename Flush>
+    void codes(std::vector<char>& out, size_t& n, size_t start, huffman_code const& lit, huffman_code const& dist, size_t flushSize, Flush& flush) {
+        while (true) {
+            if (n - start > flushSize + window) [[unlikely]] flush_window(out, n, start, flush);
+            reserve(out, n + 258);
+            auto sym = decode(lit);
+            if (sym < 256) {
+                out[n++] = static_cast<char>(sym);
+                continue;
+            }
+            if (sym == 256) return;
+            sym -= 257;
+            if (sym >= 29) throw std::runtime_error{"invalid length code"};
+            size_t len = lengthBase[sym] + get(lengthExtra[sym]);
+            auto dsym = decode(dist);
+            if (dsym >= 30) throw std::runtime_error{"invalid distance code"};
+            size_t d = distBase[dsym] + get(distExtra[dsym]);
+            if (d > n - start) throw std::runtime_error{"distance too far back"};
+            auto dst = out.data() + n;
+            auto src = dst - d;
+            if (d >= len) {
+                std::memcpy(dst, src, len);
+            } else {
+                for (size_t i{0}; i < len; ++i) dst[i] = src[i];
+            }
+            n += len;
+        }
+    }
+};
+
+//! Header of a gzip member
+struct gzip_header {
+    size_t size{};      //!< size of the header in bytes
+    size_t bgzf_size{}; //!< total size of the member as given by the BGZF extra field, 0 if missing
+};
+
+/*! \brief Parses the header of a gzip member
+ *
+ * \return std::nullopt if data does not start with a gzip header
+ */
+inline auto parse_gzip_header(std::span<uint8_t const> data) -> std::optional<gzip_header> {
+    if (data.size() < 10 or data[0] != 0x1f or data[1] != 0x8b or data[2] != 8) return std::nullopt;
+    auto flags = data[3];
+    auto res   = gzip_header{10, 0};
+    if (flags & 4) { // FEXTRA
+        if (data.size() < 12) return std::nullopt;
+        size_t xlen = data[10] | (data[11] << 8);
+        if (data.size() < 12 + xlen) return std::nullopt;
+        for (size_t p{12}; p + 4 <= 12 + xlen;) {
+            size_t slen = data[p+2] | (data[p+3] << 8);
+            if (data[p] == 'B' and data[p+1] == 'C' and slen == 2 and p + 6 <= 12 + xlen) {
+                res.bgzf_size = (data[p+4] | (data[p+5] << 8)) + 1;
+            }
+            p += 4 + slen;
+        }
+        res.size += 2 + xlen;
+    }
+    for (auto flag : {8, 16}) { // FNAME and FCOMMENT, zero terminated
+        if (flags & flag) {
+            while (res.size < data.size() and data[res.size] != 0) ++res.size;
+            if (res.size == data.size()) return std::nullopt;
+            ++res.size;
+        }
+    }
+    if (flags & 2) res.size += 2; // FHCRC
+    if (res.size > data.size()) return std::nullopt;
+    return res;
+}
+
+/*! \brief Decompresses a single gzip member, checking CRC-32 and size
+ *
+ * \param out decompressed data is appended
+ * \param flush see inflater::inflate
+ * \return size of the member in bytes
+ */
+template <typename Flush>
+auto inflate_gzip_member(std::span<uint8_t const> data, std::vector<char>& out, size_t flushSize, Flush&& flush) -> size_t {
+    auto header = parse_gzip_header(data);
+    if (!header) throw std::runtime_error{"invalid gzip header"};
+    auto body  = data.subspan(header->size);
+    auto state = inflater{body};
+    uint32_t crc{0};
+    size_t   total{0};
+    auto start = out.size();
+    state.inflate(out, flushSize, [&](std::span<char const> chunk) {
+        crc    = crc32::compute(chunk, crc);
+        total += chunk.size();
+        flush(chunk);
+    });
+    auto rest = std::span<char const>{out.data() + start, out.size() - start};
+    crc    = crc32::compute(rest, crc);
+    total += rest.size();
+
+    auto p = header->size + state.consumed();
+    if (p + 8 > data.size()) throw std::runtime_error{"missing gzip trailer"};
+    auto read32 = [&](size_t i) {
+        return uint32_t{data[i]} | uint32_t{data[i+1]} << 8 | uint32_t{data[i+2]} << 16 | uint32_t{data[i+3]} << 24;
+    };
+    if (read32(p) != crc) throw std::runtime_error{"gzip crc mismatch"};
+    if (read32(p+4) != static_cast<uint32_t>(total)) throw std::runtime_error{"gzip size mismatch"};
+    return p + 8;
+}
+
+}
+
+/*! \brief Checks if data starts with a gzip header
+ */
+inline auto is_gzip(std::span<char const> data) -> bool {
+    auto bytes = std::span{reinterpret_cast<uint8_t const*>(data.data()), data.size()};
+    return detail::parse_gzip_header(bytes).has_value();
+}
+
+/*! \brief Checks if data consists of BGZF blocks (gzip members with a BC extra field)
+ */
+inline auto is_bgzf(std::span<char const> data) -> bool {
+    auto bytes = std::span{reinterpret_cast<uint8_t const*>(data.data()), data.size()};
+    if (bytes.empty()) return false;
+    for (size_t p{0}; p < bytes.size();) {
+        auto header = detail::parse_gzip_header(bytes.subspan(p));
+        if (!header or header->bgzf_size == 0 or p + header->bgzf_size > bytes.size()) return false;
+        p += header->bgzf_size;
+    }
+    return true;
+}
+
+/*! \brief Decompresses gzip data (all members) in a single thread
+ */
+inline auto inflate_gzip(std::span<char const> data) -> std::vector<char> {
+    auto bytes = std::span{reinterpret_cast<uint8_t const*>(data.data()), data.size()};
+    auto out   = std::vector<char>{};
+    for (size_t p{0}; p < bytes.size();) {
+        p += detail::inflate_gzip_member(bytes.subspan(p), out, std::numeric_limits<size_t>::max() / 2, [](std::span<char const>) {});
+    }
+    return out;
+}
+
+/*! \brief Decompresses gzip data into ordered chunks
+ *
+ * BGZF data is split into jobs of consecutive blocks which are decompressed by a pool of threads.
+ * Plain gzip data is decompressed by a single background thread.
+ * At most `buffers` decompressed chunks exist at any time, `next` hands them out in order.
+ */
+struct gzip_reader {
+    /*!
+     * \param data compressed data, must stay valid while the reader exists
+     * \param threads number of decompression threads (only used for BGZF)
+     * \param buffers number of decompressed chunks that may be buffered
+     * \param chunk_size approximate size of a chunk (compressed size for BGZF, decompressed for gzip)
+     */
+    explicit gzip_reader(std::span<char const> data, size_t threads = std::max(1u, std::thread::hardware_concurrency()), size_t buffers = 0, size_t chunk_size = size_t{1} << 20)
+        : bytes{reinterpret_cast<uint8_t const*>(data.data()), data.size()}
+    {
+        if (buffers == 0) buffers = 2 * threads;
+        slots.resize(std::max<size_t>(buffers, 1));
+        if (is_bgzf(data)) {
+            for (size_t p{0}; p < bytes.size();) {
+                auto begin = p;
+                while (p < bytes.size() and p - begin < chunk_size) {
+                    p += detail::parse_gzip_header(bytes.subspan(p))->bgzf_size;
+                }
+                jobs.emplace_back(begin, p);
+            }
+            jobCount = jobs.size();
+            for (size_t i{0}; i < std::max<size_t>(threads, 1); ++i) {
+                workers.emplace_back([this]() { bgzf_worker(); });
+            }
+        } else {
+            if (!bytes.empty() and !is_gzip(data)) throw std::runtime_error{"not gzip compressed"};
+            jobCount = std::numeric_limits<size_t>::max();
+            workers.emplace_back([this, chunk_size]() { gzip_worker(chunk_size); });
+        }
+    }
+
+    gzip_reader(gzip_reader const&) = delete;
+    auto operator=(gzip_reader const&) -> gzip_reader& = delete;
+
+    ~gzip_reader() {
+        {
+            auto lock = std::unique_lock{mutex};
+            stop = true;
+        }
+        cv.notify_all();
+        for (auto& w : workers) w.join();
+    }
+
+    /*! \brief Next chunk of decompressed data
+     *
+     * \param chunk is swapped with the next chunk, its previous memory is reused by the reader
+     * \return false if all data was decompressed
+     */
+    auto next(std::vector<char>& chunk) -> bool {
+        auto lock = std::unique_lock{mutex};
+        cv.wait(lock, [&]() { return consumed >= jobCount or slots[consumed % slots.size()].ready; });
+        if (consumed >= jobCount) return false;
+        auto& slot = slots[consumed % slots.size()];
+        if (slot.error) std::rethrow_exception(slot.error);
+        std::swap(chunk, slot.data);
+        slot.ready = false;
+        ++consumed;
+        lock.unlock();
+        cv.notify_all();
+        return true;
+    }
+
+private:
+    struct slot {
+        std::vector<char>  data;
+        std::exception_ptr error;
+        bool               ready{};
+    };
+
+    std::span<uint8_t const>              bytes;
+    std::vector<std::pair<size_t, size_t>> jobs;         // compressed range of each BGZF job
+    size_t                                jobCount{};    // number of chunks, known at the end for gzip
+    size_t                                nextJob{};
+    size_t                                consumed{};
+    std::vector<slot>                     slots;
+    std::mutex                            mutex;
+    std::condition_variable               cv;
+    bool                                  stop{};
+    std::vector<std::thread>              workers;
+
+    // waits until chunk i may be written, returns false if the reader is destroyed
+    auto acquire(std::unique_lock<std::mutex>& lock, size_t i) -> bool {
+        cv.wait(lock, [&]() { return stop or i < consumed + slots.size(); });
+        return !stop;
+    }
+
+    void publish(size_t i, std::exception_ptr error = {}) {
+        {
+            auto lock = std::unique_lock{mutex};
+            slots[i % slots.size()].error = error;
+            slots[i % slots.size()].ready = true;
+        }
+        cv.notify_all();
+    }
+
+    void bgzf_worker() {
+        while (true) {
+            auto lock = std::unique_lock{mutex};
+            if (nextJob >= jobs.size()) return;
+            auto i = nextJob++;
+            if (!acquire(lock, i)) return;
+            auto& out = slots[i % slots.size()].data;
+            lock.unlock();
+
+            out.clear();
+            std::exception_ptr error;
+            try {
+                auto [begin, end] = jobs[i];
+                for (auto p = begin; p < end;) {
+                    p += detail::inflate_gzip_member(bytes.subspan(p, end - p), out, std::numeric_limits<size_t>::max() / 2, [](std::span<char const>) {});
+                }
+            } catch (...) {
+                error = std::current_exception();
+            }
+            publish(i, error);
+        }
+    }
+
+    void gzip_worker(size_t chunk_size) {
+        size_t i{0};
+        auto window = std::vector<char>{};
+        // hands a piece of decompressed data to the next slot
+        auto emit = [&](std::span<char const> piece) {
+            {
+                auto lock = std::unique_lock{mutex};
+                if (!acquire(lock, i)) throw std::exception{};
+            }
+            auto& out = slots[i % slots.size()].data;
+            out.assign(piece.begin(), piece.end());
+            publish(i);
+            ++i;
+        };
+        try {
+            for (size_t p{0}; p < bytes.size();) {
+                window.clear();
+                p += detail::inflate_gzip_member(bytes.subspan(p), window, chunk_size, emit);
+                if (!window.empty()) emit(window);
+            }
+        } catch (...) {
+            auto lock = std::unique_lock{mutex};
+            if (stop) return;
+            if (!acquire(lock, i)) return;
+            lock.unlock();
+            publish(i, std::current_exception());
+            ++i;
+        }
+        {
+            auto lock = std::unique_lock{mutex};
+            jobCount = i;
+        }
+        cv.notify_all();
+    }
+};
+
+/*! \brief Reads gzip or BGZF compressed FASTA and FASTQ files
+ *
+ * The file is mapped and decompressed by a gzip_reader. Records are views into an internal buffer,
+ * they stay valid until the next call of `next`. Records crossing a chunk boundary are moved in
+ * front of the next chunk, the parser continues scanning where it stopped.
+ */
+struct gzip_fastx_reader {
+    /*!
+     * \param path compressed file
+     * \param threads number of decompression threads (only used for BGZF)
+     * \param buffers number of decompressed chunks that may be buffered
+     * \param chunk_size approximate size of a chunk, see gzip_reader
+     */
+    explicit gzip_fastx_reader(std::filesystem::path const& path, size_t threads = std::max(1u, std::thread::hardware_concurrency()), size_t buffers = 0, size_t chunk_size = size_t{1} << 20)
+        : file{path}
+        , gzip{file.data(), threads, buffers, chunk_size}
+    {}
+
+    /*! \brief Parses the next record
+     *
+     * \param record is overwritten by the next record
+     * \return false if the end of the file was reached
+     */
+    auto next(fastx_record& record) -> bool {
+        while (!parser.next(record)) {
+            if (eof) {
+                if (parser.pos < text.size()) throw std::runtime_error{"incomplete record at end of file"};
+                return false;
+            }
+            // keep the incomplete record and append the next chunk
+            text.erase(text.begin(), text.begin() + static_cast<std::ptrdiff_t>(parser.pos));
+            if (!gzip.next(chunk)) {
+                eof = true;
+            } else if (text.empty()) {
+                std::swap(text, chunk);
+            } else {
+                text.insert(text.end(), chunk.begin(), chunk.end());
+            }
+            parser.resume_with(text, eof);
+        }
+        return true;
+    }
+
+    friend auto begin(gzip_fastx_reader& reader) -> fastx_iterator<gzip_fastx_reader> {
+        return fastx_iterator<gzip_fastx_reader>{reader};
+    }
+    friend auto end(gzip_fastx_reader&) -> std::nullptr_t {
+        return nullptr;
+    }
+
+private:
+    mapped_file       file;
+    gzip_reader       gzip;
+    std::vector<char> chunk;
+    std::vector<char> text;
+    fastx_parser      parser{text, false};
+    bool              eof{};
+};
+
+}
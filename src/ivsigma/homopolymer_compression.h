@@ -0,0 +1,160 @@
+// SPDX-FileCopyrightText: 2006-2023, Knut Reinert & Freie Universität Berlin
+// SPDX-FileCopyrightText: 2016-2023, Knut Reinert & MPI für molekulare Genetik
+// SPDX-License-Identifier: BSD-3-Clause
+#pragma once
+
+#include "compact_encoding.h"
+#include "winnowing_minimizer.h"
+
+#include <algorithm>
+#include <cassert>
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <ranges>
+#include <span>
+#include <vector>
+
+namespace ivs {
+
+/*! \brief A view collapsing runs of equal ranks (homopolymer compression)
+ *
+ * Each run of equal ranks is represented by a single rank. The view is computed
+ * lazily in a single pass and never allocates. Its iterators remember the
+ * original coordinates, which allows mapping k-mers and minimizers back.
+ */
+struct homopolymer_compressed_view : std::ranges::view_interface<homopolymer_compressed_view> {
+    std::span<uint8_t const> values;
+
+    homopolymer_compressed_view() = default;
+
+    template <typename Range>
+        requires std::convertible_to<Range const&, std::span<uint8_t const>>
+    homopolymer_compressed_view(Range const& _values)
+        : values{_values}
+    {}
+
+    struct iterator {
+        using value_type      = uint8_t;
+        using difference_type = std::ptrdiff_t;
+
+        uint8_t const* base{};
+        uint8_t const* runBegin{};
+        uint8_t const* runEnd{};
+        uint8_t const* seqEnd{};
+
+        iterator() = default;
+        iterator(std::span<uint8_t const> values)
+            : base{values.data()}
+            , runBegin{values.data()}
+            , runEnd{values.data()}
+            , seqEnd{values.data() + values.size()}
+        {
+            findRunEnd();
+        }
+
+        auto operator*() const -> uint8_t {
+            return *runBegin;
+        }
+
+        /*! \brief Original position of the first rank of the current run
+         */
+        auto position() const -> size_t {
+            return runBegin - base;
+        }
+
+        /*! \brief Number of ranks in the original sequence that the current run covers
+         */
+        auto run_length() const -> size_t {
+            return runEnd - runBegin;
+        }
+
+        auto operator++() -> iterator& {
+            runBegin = runEnd;
+            findRunEnd();
+            return *this;
+        }
+        auto operator++(int) -> iterator {
+            auto r = *this;
+            ++*this;
+            return r;
+        }
+
+        bool operator==(iterator const& other) const {
+            return runBegin == other.runBegin;
+        }
+        bool operator==(std::default_sentinel_t) const {
+            return runBegin == seqEnd;
+        }
+
+    private:
+        void findRunEnd() {
+            if (runBegin == seqEnd) return;
+            auto v = *runBegin;
+            runEnd = std::find_if(runBegin+1, seqEnd, [v](uint8_t c) {
+                return c != v;
+            });
+        }
+    };
+
+    auto begin() const -> iterator {
+        return iterator{values};
+    }
+    auto end() const -> std::default_sentinel_t {
+        return {};
+    }
+};
+static_assert(std::ranges::forward_range<homopolymer_compressed_view>, "Unit test: is supposed to model a forward range");
+
+/*! \brief Compresses runs of equal ranks into a single rank
+ *
+ * \param in rank input
+ * \param out compressed ranks (must have at least the size of in)
+ * \param positions original position of each compressed rank (must have at least the size of in, or be empty to skip)
+ * \return number of compressed ranks
+ */
+inline auto compress_homopolymers(std::span<uint8_t const> in, std::span<uint8_t> out, std::span<size_t> positions = {}) -> size_t {
+    assert(in.size() <= out.size());
+    assert(positions.empty() or in.size() <= positions.size());
+    size_t n{0};
+    for (size_t i{0}; i < in.size(); ++i) {
+        if (i > 0 and in[i] == in[i-1]) continue;
+        out[n] = in[i];
+        if (!positions.empty()) {
+            positions[n] = i;
+        }
+        ++n;
+    }
+    return n;
+}
+
+/*! \brief Compresses runs of equal ranks into a single rank
+ *
+ * \param in rank input
+ * \return compressed ranks
+ */
+inline auto compress_homopolymers(std::span<uint8_t const> in) -> std::vector<uint8_t> {
+    auto out = std::vector<uint8_t>{};
+    out.resize(in.size());
+    out.resize(compress_homopolymers(in, out));
+    return out;
+}
+
+/*! \brief K-mers over a homopolymer compressed rank sequence
+ *
+ * Use `iterator::kmer().position()` to retrieve original coordinates,
+ * `iterator::position()` is the position in the compressed sequence.
+ */
+template <alphabet_c Alphabet, bool UseCanonicalKmers=true>
+using homopolymer_compact_encoding = compact_encoding<Alphabet, UseCanonicalKmers, homopolymer_compressed_view>;
+
+/*! \brief Minimizers over a homopolymer compressed rank sequence
+ *
+ * Use `iterator::kmer().position()` to retrieve original coordinates,
+ * `iterator::position()` is the position in the compressed sequence.
+ */
+template <alphabet_c Alphabet, bool DuplicatesAllowed=true, bool UseCanonicalKmers=true>
+using homopolymer_winnowing_minimizer = winnowing_minimizer<Alphabet, DuplicatesAllowed, UseCanonicalKmers, homopolymer_compressed_view>;
+
+}
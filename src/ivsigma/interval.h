@@ -0,0 +1,27 @@
+// SPDX-FileCopyrightText: 2006-2023, Knut Reinert & Freie Universität Berlin
+// SPDX-FileCopyrightText: 2016-2023, Knut Reinert & MPI für molekulare Genetik
+// SPDX-License-Identifier: BSD-3-Clause
+#pragma once
+
+#include <cstddef>
+
+namespace ivs {
+
+/*! \brief A half open interval [begin, end) of positions
+ */
+struct interval {
+    size_t begin{};
+    size_t end{};
+
+    auto size() const noexcept -> size_t {
+        return end - begin;
+    }
+
+    auto contains(size_t pos) const noexcept -> bool {
+        return begin <= pos and pos < end;
+    }
+
+    friend bool operator==(interval const&, interval const&) = default;
+};
+
+}
@@ -2,8 +2,34 @@
 // SPDX-FileCopyrightText: 2016-2023, Knut Reinert & MPI für molekulare Genetik
 // SPDX-License-Identifier: BSD-3-Clause
 #include "aminoacids.h"
+#include "bisulfite.h"
+#include "bloom_filter.h"
+#include "chaining.h"
 #include "compact_encoding.h"
+#include "composition.h"
+#include "dust.h"
+#include "fastx_reader.h"
+#include "fastx_writer.h"
+#include "gzip_reader.h"
+#include "homopolymer_compression.h"
+#include "interval.h"
+#include "kmer_counter.h"
+#include "minimizer_index.h"
+#include "n_compressed_sequence.h"
 #include "nucliotides.h"
+#include "packed_sequence.h"
+#include "packed_store.h"
 #include "qualities.h"
+#include "quality_binning.h"
+#include "quality_filter.h"
+#include "radix_sort.h"
+#include "read_batch.h"
+#include "run_length_sequence.h"
+#include "sketch.h"
+#include "soft_mask.h"
+#include "super_kmer.h"
+#include "translation.h"
+#include "trimming.h"
+#include "twobit.h"
 #include "utility.h"
 #include "winnowing_minimizer.h"
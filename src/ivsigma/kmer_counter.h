@@ -0,0 +1,295 @@
+// SPDX-FileCopyrightText: 2006-2023, Knut Reinert & Freie Universität Berlin
+// SPDX-FileCopyrightText: 2016-2023, Knut Reinert & MPI für molekulare Genetik
+// SPDX-License-Identifier: BSD-3-Clause
+#pragma once
+
+#include "compact_encoding.h"
+#include "concepts.h"
+#include "read_batch.h"
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <ranges>
+#include <span>
+#include <stdexcept>
+#include <thread>
+#include <variant>
+#include <vector>
+
+namespace ivs::detail {
+
+//! Finalizer of MurmurHash3, spreads compact encodings over all bits
+constexpr auto mix_kmer(uint64_t v) noexcept -> uint64_t {
+    v ^= v >> 33;
+    v *= 0xff51'afd7'ed55'8ccdull;
+    v ^= v >> 33;
+    v *= 0xc4ce'b9fe'1a85'ec53ull;
+    v ^= v >> 33;
+    return v;
+}
+
+inline void prefetch_write([[maybe_unused]] void const* ptr) noexcept {
+#if defined(__GNUC__) || defined(__clang__)
+    __builtin_prefetch(ptr, 1);
+#endif
+}
+
+inline void prefetch_read([[maybe_unused]] void const* ptr) noexcept {
+#if defined(__GNUC__) || defined(__clang__)
+    __builtin_prefetch(ptr, 0);
+#endif
+}
+
+/**
+ * Runs 'op(state, first, last)' on chunks covering [0, n) on a number of threads.
+ * Chunks are handed out via an atomic counter. Each thread creates its own state via 'init()'
+ * and passes it to 'done(state)' after its last chunk.
+ * If any call throws, no further chunks are handed out and the first exception is rethrown
+ * after all threads finished.
+ */
+template <typename Init, typename Op, typename Done>
+void parallel_for(size_t n, size_t threads, size_t chunk, Init&& init, Op&& op, Done&& done) {
+    threads = std::max<size_t>(1, std::min(threads, (n + chunk - 1) / chunk));
+    auto next  = std::atomic<size_t>{0};
+    auto mutex = std::mutex{};
+    auto error = std::exception_ptr{};
+    auto work = [&]() {
+        try {
+            auto state = init();
+            for (auto first = next.fetch_add(chunk); first < n; first = next.fetch_add(chunk)) {
+                op(state, first, std::min(n, first + chunk));
+            }
+            done(state);
+        } catch (...) {
+            next.store(n);
+            auto lock = std::lock_guard{mutex};
+            if (!error) error = std::current_exception();
+        }
+    };
+    if (threads == 1) {
+        work();
+    } else {
+        auto pool = std::vector<std::thread>{};
+        for (size_t t{0}; t < threads; ++t) {
+            pool.emplace_back(work);
+        }
+        for (auto& t : pool) {
+            t.join();
+        }
+    }
+    if (error) std::rethrow_exception(error);
+}
+
+/**
+ * Runs 'op(first, last)' on chunks covering [0, n) on a number of threads, see above.
+ */
+template <typename Op>
+void parallel_for(size_t n, size_t threads, size_t chunk, Op&& op) {
+    parallel_for(n, threads, chunk,
+                 []() { return std::monostate{}; },
+                 [&](std::monostate, size_t first, size_t last) { op(first, last); },
+                 [](std::monostate) {});
+}
+
+}
+
+namespace ivs {
+
+struct kmer_count {
+    uint64_t kmer;
+    uint64_t count;
+
+    bool operator==(kmer_count const&) const = default;
+};
+
+/*! \brief Concurrent hash table counting k-mers (e.g. values of compact_encoding)
+ *
+ * Open addressing with linear probing. Empty slots are claimed via compare-and-swap and counts are
+ * incremented atomically, any number of threads can insert at the same time without locks.
+ * Batched inserts hash a block of k-mers first and prefetch their slots before inserting them.
+ * The table does not grow, inserting more distinct k-mers than the table can hold throws a std::runtime_error.
+ * Reading (count, histogram, ...) while other threads insert is safe, but may miss concurrent inserts.
+ */
+struct kmer_count_table {
+    /*!
+     * \param expected_kmers expected number of distinct k-mers, the table holds at least twice as many slots
+     */
+    explicit kmer_count_table(size_t expected_kmers)
+        : mask{std::bit_ceil(std::max<size_t>(64, expected_kmers * 2)) - 1}
+        , slots{std::make_unique<slot[]>(mask + 1)}
+    {}
+
+    //! Number of slots
+    auto capacity() const noexcept -> size_t { return mask + 1; }
+
+    //! Number of distinct k-mers
+    auto size() const noexcept -> size_t {
+        return used.load(std::memory_order_relaxed) + (emptyKeyCount.load(std::memory_order_relaxed) > 0);
+    }
+
+    /*! \brief Adds n to the count of a k-mer, thread safe
+     */
+    void insert(uint64_t kmer, uint64_t n = 1) {
+        insert_at(kmer, detail::mix_kmer(kmer) & mask, n);
+    }
+
+    /*! \brief Counts all k-mers of a batch, thread safe
+     */
+    void insert(std::span<uint64_t const> kmers) {
+        static constexpr size_t block = 16;
+        auto pos = std::array<size_t, block>{};
+        while (!kmers.empty()) {
+            auto n = std::min(block, kmers.size());
+            for (size_t i{0}; i < n; ++i) {
+                pos[i] = detail::mix_kmer(kmers[i]) & mask;
+                detail::prefetch_write(&slots[pos[i]]);
+            }
+            for (size_t i{0}; i < n; ++i) {
+                insert_at(kmers[i], pos[i], 1);
+            }
+            kmers = kmers.subspan(n);
+        }
+    }
+
+    /*! \brief Count of a k-mer, 0 if it was never inserted
+     */
+    auto count(uint64_t kmer) const noexcept -> uint64_t {
+        if (kmer == empty) return emptyKeyCount.load(std::memory_order_relaxed);
+        auto pos = detail::mix_kmer(kmer) & mask;
+        for (size_t probe{0}; probe <= mask; ++probe) {
+            auto const& s = slots[pos];
+            auto key = s.key.load(std::memory_order_acquire);
+            if (key == kmer) return s.count.load(std::memory_order_relaxed);
+            if (key == empty) return 0;
+            pos = (pos + 1) & mask;
+        }
+        return 0;
+    }
+
+    /*! \brief Calls 'f(kmer, count)' for every k-mer in table order
+     */
+    template <typename F>
+    void for_each(F&& f) const {
+        if (auto c = emptyKeyCount.load(std::memory_order_relaxed); c > 0) {
+            f(empty, c);
+        }
+        for (size_t i{0}; i <= mask; ++i) {
+            auto key = slots[i].key.load(std::memory_order_acquire);
+            if (key != empty) f(key, slots[i].count.load(std::memory_order_relaxed));
+        }
+    }
+
+    /*! \brief Histogram of counts
+     *
+     * \param max_count counts larger than max_count are added to the last entry
+     * \return entry c is the number of distinct k-mers occurring c times
+     */
+    auto histogram(size_t max_count = 10'000) const -> std::vector<uint64_t> {
+        auto hist = std::vector<uint64_t>{};
+        for_each([&](uint64_t, uint64_t c) {
+            auto i = std::min<uint64_t>(c, max_count);
+            if (i >= hist.size()) hist.resize(i + 1);
+            hist[i] += 1;
+        });
+        return hist;
+    }
+
+    /*! \brief All k-mers with a count of at least min_count, sorted by k-mer
+     */
+    auto kmers_above(uint64_t min_count) const -> std::vector<kmer_count> {
+        auto res = std::vector<kmer_count>{};
+        for_each([&](uint64_t kmer, uint64_t c) {
+            if (c >= min_count) res.push_back({kmer, c});
+        });
+        std::ranges::sort(res, {}, &kmer_count::kmer);
+        return res;
+    }
+
+private:
+    static constexpr uint64_t empty = ~uint64_t{0};
+
+    struct slot {
+        std::atomic<uint64_t> key{empty};
+        std::atomic<uint64_t> count{0};
+    };
+
+    size_t                  mask;
+    std::unique_ptr<slot[]> slots;
+    std::atomic<size_t>     used{0};
+    std::atomic<uint64_t>   emptyKeyCount{0}; // count of the k-mer that collides with the empty marker
+
+    void insert_at(uint64_t kmer, size_t pos, uint64_t n) {
+        if (kmer == empty) {
+            emptyKeyCount.fetch_add(n, std::memory_order_relaxed);
+            return;
+        }
+        for (size_t probe{0}; probe <= mask; ++probe) {
+            auto& s  = slots[pos];
+            auto key = s.key.load(std::memory_order_acquire);
+            if (key == empty) {
+                if (s.key.compare_exchange_strong(key, kmer, std::memory_order_acq_rel)) {
+                    used.fetch_add(1, std::memory_order_relaxed);
+                    s.count.fetch_add(n, std::memory_order_relaxed);
+                    return;
+                }
+                // key now holds the k-mer of the thread that claimed the slot
+            }
+            if (key == kmer) {
+                s.count.fetch_add(n, std::memory_order_relaxed);
+                return;
+            }
+            pos = (pos + 1) & mask;
+        }
+        throw std::runtime_error{"kmer_count_table is full"};
+    }
+};
+
+/*! \brief Counts the k-mers of many sequences on multiple threads
+ *
+ * Threads take chunks of sequences, encode them via compact_encoding and insert their k-mers in batches.
+ *
+ * \tparam Alphabet alphabet of the sequences
+ * \param table k-mers are added to this table
+ * \param sequences random access range of rank sequences (e.g. std::vector<std::vector<uint8_t>>)
+ * \param k size of the k-mers
+ * \param threads number of threads
+ */
+template <alphabet_c Alphabet, bool UseCanonicalKmers=true, std::ranges::random_access_range Sequences>
+void count_kmers(kmer_count_table& table, Sequences const& sequences, size_t k, size_t threads = std::max(1u, std::thread::hardware_concurrency())) {
+    auto n = static_cast<size_t>(std::ranges::size(sequences));
+    detail::parallel_for(n, threads, 64, [&](size_t first, size_t last) {
+        auto buffer = std::array<uint64_t, 1024>{};
+        size_t used{0};
+        for (auto i{first}; i < last; ++i) {
+            auto encoding = compact_encoding<Alphabet, UseCanonicalKmers>{std::span<uint8_t const>{sequences[i]}, k};
+            for (auto iter = begin(encoding); iter != end(encoding); ++iter) {
+                buffer[used++] = *iter;
+                if (used == buffer.size()) {
+                    table.insert(buffer);
+                    used = 0;
+                }
+            }
+        }
+        table.insert(std::span{buffer}.first(used));
+    });
+}
+
+/*! \brief Counts the k-mers of all reads of a batch on multiple threads
+ *
+ * K-mers never span two reads.
+ */
+template <alphabet_c Alphabet, bool UseCanonicalKmers=true, quality_alphabet_c QualityAlphabet>
+void count_kmers(kmer_count_table& table, read_batch<Alphabet, QualityAlphabet> const& batch, size_t k, size_t threads = std::max(1u, std::thread::hardware_concurrency())) {
+    auto reads = std::views::iota(size_t{0}, batch.size())
+               | std::views::transform([&](size_t i) { return batch.sequence(i); });
+    count_kmers<Alphabet, UseCanonicalKmers>(table, reads, k, threads);
+}
+
+}
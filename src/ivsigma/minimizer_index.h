@@ -0,0 +1,378 @@
+// SPDX-FileCopyrightText: 2006-2023, Knut Reinert & Freie Universität Berlin
+// SPDX-FileCopyrightText: 2016-2023, Knut Reinert & MPI für molekulare Genetik
+// SPDX-License-Identifier: BSD-3-Clause
+#pragma once
+
+#include "compact_encoding.h"
+#include "concepts.h"
+#include "fastx_reader.h"
+#include "kmer_counter.h"
+#include "packed_store.h"
+#include "radix_sort.h"
+#include "winnowing_minimizer.h"
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cassert>
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <limits>
+#include <mutex>
+#include <ranges>
+#include <span>
+#include <stdexcept>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace ivs {
+
+/*! \brief Occurrence of a minimizer in a reference sequence
+ */
+struct minimizer_hit {
+    uint32_t sequence; //!< index of the reference sequence
+    uint32_t value;    //!< position << 1 | strand
+
+    //! Position of the first value of the minimizer
+    auto position() const noexcept -> size_t { return value >> 1; }
+
+    //! true if the minimizer is the reverse complement of the reference at this position
+    auto reverse() const noexcept -> bool { return value & 1; }
+
+    bool operator==(minimizer_hit const&) const = default;
+};
+
+/*! \brief Parameters of a minimizer_index
+ */
+struct minimizer_index_options {
+    size_t k{15};                         //!< size of the minimizers
+    size_t window{10};                    //!< number of consecutive k-mers a minimizer is chosen from
+    size_t seed{0};                       //!< seed of the compact_encoding
+    size_t max_occurrences{std::numeric_limits<size_t>::max()}; //!< minimizers occurring more often are dropped
+    double drop_fraction{0.};             //!< drops up to this fraction of distinct minimizers, the most frequent ones
+    size_t threads{std::max(1u, std::thread::hardware_concurrency())}; //!< threads used for building
+};
+
+}
+
+namespace ivs::detail {
+
+/**
+ * File layout of a minimizer_index, all values are little endian:
+ * header | directory | keys | offsets | hits
+ * Every array starts at a 64 byte boundary.
+ * - keys: sorted mixed minimizers (mix_kmer is a bijection)
+ * - directory: the keys of bucket b (top bucket_bits bits of the key) are keys[directory[b], directory[b+1])
+ * - offsets: the hits of keys[i] are hits[offsets[i], offsets[i+1])
+ * - hits: minimizer_hit, sorted by sequence and position
+ */
+struct minimizer_index_header {
+    std::array<char, 8> magic;
+    uint64_t            alphabet;    // alphabet_fingerprint
+    uint32_t            k;
+    uint32_t            window;
+    uint64_t            seed;
+    uint32_t            canonical;
+    uint32_t            bucket_bits;
+    uint64_t            keys;        // number of distinct minimizers
+    uint64_t            hits;        // number of hits
+    uint64_t            dropped;     // number of dropped minimizers
+};
+static_assert(sizeof(minimizer_index_header) == 64);
+
+inline constexpr auto minimizer_index_magic = std::array<char, 8>{'I', 'V', 'S', 'M', 'I', 'N', 'I', '\0'};
+
+struct minimizer_index_layout {
+    size_t directory, keys, offsets, hits, size; // offsets in bytes
+
+    explicit minimizer_index_layout(minimizer_index_header const& h) {
+        auto align = [](size_t v) { return (v + 63) / 64 * 64; };
+        directory = sizeof(h);
+        keys      = align(directory + ((size_t{1} << h.bucket_bits) + 1) * sizeof(uint64_t));
+        offsets   = align(keys + h.keys * sizeof(uint64_t));
+        hits      = align(offsets + (h.keys + 1) * sizeof(uint64_t));
+        size      = align(hits + h.hits * sizeof(minimizer_hit));
+    }
+};
+
+/**
+ * Encodes the k-mer starting at ranks[0] in forward direction, as compact_encoding does.
+ */
+template <alphabet_c Alphabet>
+auto forward_kmer(std::span<uint8_t const> ranks, size_t k) -> uint64_t {
+    uint64_t v{0};
+    for (size_t i{0}; i < k; ++i) {
+        v = v * Alphabet::size() + ranks[i];
+    }
+    return v;
+}
+
+}
+
+namespace ivs {
+
+/*! \brief Index of the positions of all minimizers of a set of reference sequences
+ *
+ * Minimizers (see winnowing_minimizer) are mapped to their hits (sequence, position and strand).
+ * Hits are stored in one sorted array, grouped by minimizer; a directory over the top bits of the hashed minimizers
+ * finds the group of a minimizer with one or two memory accesses.
+ * The whole index is a single block of memory with the same layout as the file written by `save`,
+ * opening a saved index maps it into memory without parsing.
+ * All query functions are const and can be used by many threads at once.
+ *
+ * \tparam Alphabet alphabet of the reference sequences
+ */
+template <alphabet_c Alphabet, bool UseCanonicalKmers=true>
+struct minimizer_index {
+    /*! \brief Builds the index over a set of sequences on multiple threads
+     *
+     * \param sequences random access range of rank sequences (e.g. std::vector<std::vector<uint8_t>>),
+     *        at most 2^32 sequences each shorter than 2^31
+     * \param options parameters of the minimizers and the frequency filter
+     */
+    template <std::ranges::random_access_range Sequences>
+        requires std::convertible_to<std::ranges::range_reference_t<Sequences const>, std::span<uint8_t const>>
+    minimizer_index(Sequences const& sequences, minimizer_index_options const& options = {}) {
+        build(sequences, options);
+    }
+
+    /*! \brief Opens an index written by `save`
+     *
+     * Throws std::runtime_error if the file is not a minimizer index of Alphabet,
+     * or if its directory or offsets are out of bounds.
+     * \param advice expected access pattern, e.g. map_advice::huge_pages
+     */
+    explicit minimizer_index(std::filesystem::path const& path, map_advice advice = map_advice::random)
+        : file{path, advice}
+    {
+        attach(file.data());
+    }
+
+    minimizer_index(minimizer_index const&) = delete;
+    minimizer_index(minimizer_index&&) noexcept = default;
+    auto operator=(minimizer_index const&) -> minimizer_index& = delete;
+    auto operator=(minimizer_index&&) noexcept -> minimizer_index& = default;
+
+    //! Size of the minimizers
+    auto k() const noexcept -> size_t { return header.k; }
+    auto window() const noexcept -> size_t { return header.window; }
+    auto seed() const noexcept -> size_t { return header.seed; }
+
+    //! Number of distinct minimizers
+    auto size() const noexcept -> size_t { return keys.size(); }
+
+    //! Number of hits of all minimizers
+    auto hit_count() const noexcept -> size_t { return hits.size(); }
+
+    //! Number of distinct minimizers removed by the frequency filter
+    auto dropped() const noexcept -> size_t { return header.dropped; }
+
+    /*! \brief Hits of a minimizer, sorted by sequence and position
+     */
+    auto lookup(uint64_t minimizer) const noexcept -> std::span<minimizer_hit const> {
+        auto key = detail::mix_kmer(minimizer);
+        return find(key, bucket(key));
+    }
+
+    /*! \brief Looks up many minimizers at once
+     *
+     * Directory entries of a block of minimizers are prefetched before they are resolved.
+     * \param out hits of each minimizer (must have same size as minimizers)
+     */
+    void lookup(std::span<uint64_t const> minimizers, std::span<std::span<minimizer_hit const>> out) const noexcept {
+        assert(minimizers.size() == out.size());
+        static constexpr size_t block = 16;
+        auto keyBlock    = std::array<uint64_t, block>{};
+        auto bucketBlock = std::array<size_t, block>{};
+        for (size_t i{0}; i < minimizers.size(); i += block) {
+            auto n = std::min(block, minimizers.size() - i);
+            for (size_t j{0}; j < n; ++j) {
+                keyBlock[j]    = detail::mix_kmer(minimizers[i+j]);
+                bucketBlock[j] = bucket(keyBlock[j]);
+                detail::prefetch_read(&directory[bucketBlock[j]]);
+            }
+            for (size_t j{0}; j < n; ++j) {
+                out[i+j] = find(keyBlock[j], bucketBlock[j]);
+            }
+        }
+    }
+
+    /*! \brief Calls 'f(position, reverse, hits)' for every minimizer of a query that occurs in the index
+     *
+     * A hit lies on the same strand as the query if hit.reverse() == reverse.
+     * \param query ranks of the query
+     */
+    template <typename F>
+    void for_each_hit(std::span<uint8_t const> query, F&& f) const {
+        auto minimizers = winnowing_minimizer<Alphabet, true, UseCanonicalKmers>{query, header.k, header.window, header.seed};
+        for (auto iter = begin(minimizers); iter != end(minimizers); ++iter) {
+            auto h = lookup(*iter);
+            if (h.empty()) continue;
+            auto pos     = iter.position();
+            bool reverse = (detail::forward_kmer<Alphabet>(query.subspan(pos), header.k) ^ header.seed) != *iter;
+            f(pos, reverse, h);
+        }
+    }
+
+    /*! \brief Writes the index into a file, which can be opened via minimizer_index{path}
+     */
+    void save(std::filesystem::path const& path) const {
+        auto ofs = std::ofstream{path, std::ios::binary};
+        if (!ofs) throw std::runtime_error{"can not open " + path.string()};
+        ofs.write(bytes.data(), static_cast<std::streamsize>(bytes.size()));
+        if (!ofs) throw std::runtime_error{"can not write " + path.string()};
+    }
+
+private:
+    std::vector<uint64_t>          storage;   // index built in memory
+    mapped_file                    file;      // index opened from a file
+    std::span<char const>          bytes;
+    detail::minimizer_index_header header{};
+    std::span<uint64_t const>      directory;
+    std::span<uint64_t const>      keys;
+    std::span<uint64_t const>      offsets;
+    std::span<minimizer_hit const> hits;
+
+    auto bucket(uint64_t key) const noexcept -> size_t {
+        if (header.bucket_bits == 0) return 0;
+        return key >> (64 - header.bucket_bits);
+    }
+
+    auto find(uint64_t key, size_t b) const noexcept -> std::span<minimizer_hit const> {
+        for (auto i = directory[b]; i < directory[b+1]; ++i) {
+            if (keys[i] == key) return hits.subspan(offsets[i], offsets[i+1] - offsets[i]);
+            if (keys[i] > key) break;
+        }
+        return {};
+    }
+
+    template <std::ranges::random_access_range Sequences>
+    void build(Sequences const& sequences, minimizer_index_options const& options) {
+        if constexpr (std::endian::native != std::endian::little) {
+            throw std::runtime_error{"minimizer_index requires a little endian machine"};
+        }
+        auto n = static_cast<size_t>(std::ranges::size(sequences));
+        if (n > std::numeric_limits<uint32_t>::max()) throw std::runtime_error{"too many sequences for a minimizer_index"};
+        for (size_t s{0}; s < n; ++s) {
+            if (std::ranges::size(sequences[s]) >= (size_t{1} << 31)) throw std::runtime_error{"sequence too long for a minimizer_index"};
+        }
+
+        // collect (key, sequence << 32 | position << 1 | strand) of all sequences
+        auto entries = std::vector<std::pair<uint64_t, uint64_t>>{};
+        auto mutex   = std::mutex{};
+        detail::parallel_for(n, options.threads, 16, [&](size_t first, size_t last) {
+            auto local = std::vector<std::pair<uint64_t, uint64_t>>{};
+            for (auto s{first}; s < last; ++s) {
+                auto ranks = std::span<uint8_t const>{sequences[s]};
+                auto minimizers = winnowing_minimizer<Alphabet, true, UseCanonicalKmers>{ranks, options.k, options.window, options.seed};
+                for (auto iter = begin(minimizers); iter != end(minimizers); ++iter) {
+                    auto pos     = iter.position();
+                    auto reverse = (detail::forward_kmer<Alphabet>(ranks.subspan(pos), options.k) ^ options.seed) != *iter;
+                    local.emplace_back(detail::mix_kmer(*iter), (uint64_t{s} << 32) | (pos << 1) | reverse);
+                }
+            }
+            auto lock = std::lock_guard{mutex};
+            entries.insert(entries.end(), local.begin(), local.end());
+        });
+        radix_sort(std::span{entries}, [](auto const& e) { return e.first; }, options.threads);
+
+        // group by key, hits of a group are sorted by sequence and position
+        auto groups = std::vector<std::pair<size_t, size_t>>{};
+        for (size_t i{0}; i < entries.size();) {
+            auto j = i + 1;
+            while (j < entries.size() and entries[j].first == entries[i].first) ++j;
+            std::ranges::sort(entries.begin() + i, entries.begin() + j, {}, &std::pair<uint64_t, uint64_t>::second);
+            groups.emplace_back(i, j);
+            i = j;
+        }
+
+        // frequency filter
+        auto maxOccurrences = options.max_occurrences;
+        if (options.drop_fraction > 0. and !groups.empty()) {
+            auto sizes = std::vector<size_t>{};
+            for (auto [b, e] : groups) sizes.push_back(e - b);
+            auto drop = std::min(sizes.size() - 1, static_cast<size_t>(options.drop_fraction * sizes.size()));
+            auto nth  = sizes.begin() + (sizes.size() - 1 - drop);
+            std::ranges::nth_element(sizes, nth);
+            maxOccurrences = std::min(maxOccurrences, *nth);
+        }
+
+        header.magic       = detail::minimizer_index_magic;
+        header.alphabet    = detail::alphabet_fingerprint<Alphabet>();
+        header.k           = static_cast<uint32_t>(options.k);
+        header.window      = static_cast<uint32_t>(options.window);
+        header.seed        = options.seed;
+        header.canonical   = UseCanonicalKmers;
+        for (auto [b, e] : groups) {
+            if (e - b > maxOccurrences) {
+                header.dropped += 1;
+            } else {
+                header.keys += 1;
+                header.hits += e - b;
+            }
+        }
+        header.bucket_bits = std::bit_width(header.keys);
+
+        auto layout = detail::minimizer_index_layout{header};
+        storage.resize(layout.size / sizeof(uint64_t));
+        auto data = reinterpret_cast<char*>(storage.data());
+        std::memcpy(data, &header, sizeof(header));
+
+        auto dir     = reinterpret_cast<uint64_t*>(data + layout.directory);
+        auto keyData = reinterpret_cast<uint64_t*>(data + layout.keys);
+        auto offData = reinterpret_cast<uint64_t*>(data + layout.offsets);
+        auto hitData = reinterpret_cast<minimizer_hit*>(data + layout.hits);
+        size_t key{0}, hit{0};
+        for (auto [b, e] : groups) {
+            if (e - b > maxOccurrences) continue;
+            keyData[key] = entries[b].first;
+            offData[key] = hit;
+            dir[bucket(entries[b].first) + 1] += 1;
+            for (auto i{b}; i < e; ++i) {
+                hitData[hit++] = {static_cast<uint32_t>(entries[i].second >> 32), static_cast<uint32_t>(entries[i].second)};
+            }
+            key += 1;
+        }
+        offData[key] = hit;
+        for (size_t b{1}; b <= (size_t{1} << header.bucket_bits); ++b) {
+            dir[b] += dir[b-1];
+        }
+        attach({data, layout.size});
+    }
+
+    void attach(std::span<char const> data) {
+        if constexpr (std::endian::native != std::endian::little) {
+            throw std::runtime_error{"minimizer_index requires a little endian machine"};
+        }
+        bytes = data;
+        if (bytes.size() < sizeof(header)) throw std::runtime_error{"not a minimizer index"};
+        std::memcpy(&header, bytes.data(), sizeof(header));
+        if (header.magic != detail::minimizer_index_magic) throw std::runtime_error{"not a minimizer index"};
+        if (header.alphabet != detail::alphabet_fingerprint<Alphabet>() or header.canonical != UseCanonicalKmers) {
+            throw std::runtime_error{"minimizer index was built with a different alphabet"};
+        }
+        if (header.bucket_bits > 40 or header.keys > bytes.size() or header.hits > bytes.size()
+            or detail::minimizer_index_layout{header}.size != bytes.size()) {
+            throw std::runtime_error{"corrupt minimizer index"};
+        }
+        auto layout = detail::minimizer_index_layout{header};
+        directory = {reinterpret_cast<uint64_t const*>(bytes.data() + layout.directory), (size_t{1} << header.bucket_bits) + 1};
+        keys      = {reinterpret_cast<uint64_t const*>(bytes.data() + layout.keys), header.keys};
+        offsets   = {reinterpret_cast<uint64_t const*>(bytes.data() + layout.offsets), header.keys + 1};
+        hits      = {reinterpret_cast<minimizer_hit const*>(bytes.data() + layout.hits), header.hits};
+        // lookups index keys and hits via directory and offsets, both must be non decreasing and bounded
+        auto bounded = [](std::span<uint64_t const> values, size_t size) {
+            return values.front() == 0 and values.back() == size and std::ranges::is_sorted(values);
+        };
+        if (!bounded(directory, keys.size()) or !bounded(offsets, hits.size())) {
+            throw std::runtime_error{"corrupt minimizer index"};
+        }
+    }
+};
+
+}
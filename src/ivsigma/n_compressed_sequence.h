@@ -0,0 +1,217 @@
+// SPDX-FileCopyrightText: 2006-2023, Knut Reinert & Freie Universität Berlin
+// SPDX-FileCopyrightText: 2016-2023, Knut Reinert & MPI für molekulare Genetik
+// SPDX-License-Identifier: BSD-3-Clause
+#pragma once
+
+#include "compact_encoding.h"
+#include "interval.h"
+#include "nucliotides.h"
+#include "packed_sequence.h"
+#include "soft_mask.h"
+#include "winnowing_minimizer.h"
+
+#include <algorithm>
+#include <cassert>
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <span>
+#include <string>
+#include <vector>
+
+namespace ivs {
+
+//! Range of a packed dna4 sequence, as consumed by the k-mer engines
+using packed_dna4_subrange = decltype(packed_span<dna4>{}.subspan(0, 0));
+
+/*! \brief compact_encoding over the bases of an n_compressed_sequence, skipping gaps and exceptions
+ */
+template <bool UseCanonicalKmers=true>
+using n_compressed_compact_encoding = masked_view<compact_encoding<dna4, UseCanonicalKmers, packed_dna4_subrange>>;
+
+/*! \brief winnowing_minimizer over the bases of an n_compressed_sequence, skipping gaps and exceptions
+ */
+template <bool DuplicatesAllowed=true, bool UseCanonicalKmers=true>
+using n_compressed_winnowing_minimizer = masked_view<winnowing_minimizer<dna4, DuplicatesAllowed, UseCanonicalKmers, packed_dna4_subrange>>;
+
+/*! \brief Nucleotide sequence with compressed runs of N
+ *
+ * Stores A, C, G and T as packed dna4 ranks (2 bits per position), runs of N
+ * as a sorted list of intervals and all remaining iupac ranks (e.g. R or Y)
+ * as a sorted list of exceptions. Gaps and exceptions occupy a placeholder `A`
+ * in the packed ranks, so positions are identical in all representations.
+ */
+struct n_compressed_sequence {
+    struct exception {
+        size_t  position{};
+        uint8_t rank{};    //!< iupac rank
+
+        friend bool operator==(exception const&, exception const&) = default;
+    };
+
+    packed_sequence<dna4>  bases;
+    std::vector<interval>  gaps;       //!< sorted runs of N
+    std::vector<exception> exceptions; //!< sorted positions of other non ACGT ranks
+
+    n_compressed_sequence() = default;
+
+    /*! \brief Compresses a sequence
+     *
+     * \param in iupac ranks (dna4 and dna5 ranks are valid iupac ranks)
+     */
+    n_compressed_sequence(std::span<uint8_t const> in) {
+        append(in);
+    }
+
+    auto size() const noexcept -> size_t { return bases.size(); }
+    auto empty() const noexcept -> bool { return bases.empty(); }
+
+    /*! \brief Appends iupac ranks to the end
+     */
+    void append(std::span<uint8_t const> in) {
+        auto offset = bases.size();
+        bases.append(in);
+        for (size_t i{0}; i < in.size(); ++i) {
+            if (in[i] < 4) continue;
+            bases.set(offset + i, 0);
+            if (in[i] != 4) {
+                exceptions.push_back({offset + i, in[i]});
+            } else if (!gaps.empty() and gaps.back().end == offset + i) {
+                gaps.back().end += 1;
+            } else {
+                gaps.push_back({offset + i, offset + i + 1});
+            }
+        }
+    }
+
+    void clear() noexcept {
+        bases.clear();
+        gaps.clear();
+        exceptions.clear();
+    }
+
+    /*! \brief Iupac rank at position i
+     *
+     * Random access in O(log g + log e) for g gaps and e exceptions.
+     */
+    auto operator[](size_t i) const -> uint8_t {
+        assert(i < size());
+        auto gap = std::ranges::upper_bound(gaps, i, {}, &interval::begin);
+        if (gap != gaps.begin() and std::prev(gap)->contains(i)) {
+            return 4;
+        }
+        auto ex = std::ranges::lower_bound(exceptions, i, {}, &exception::position);
+        if (ex != exceptions.end() and ex->position == i) {
+            return ex->rank;
+        }
+        return bases[i];
+    }
+
+    /*! \brief Extracts a region as ranks
+     *
+     * \tparam Alphabet iupac or dna5, for dna5 exceptions are reported as N
+     * \param offset first position of the region
+     * \param out ranks of the region (offset + out.size() must not exceed size())
+     */
+    template <alphabet_c Alphabet = iupac>
+        requires (std::same_as<Alphabet, iupac> or std::same_as<Alphabet, dna5>)
+    void extract(size_t offset, std::span<uint8_t> out) const {
+        assert(offset + out.size() <= size());
+        auto last = offset + out.size();
+        bases.unpack(offset, out);
+        auto gap = std::ranges::upper_bound(gaps, offset, {}, &interval::begin);
+        if (gap != gaps.begin()) --gap;
+        for (; gap != gaps.end() and gap->begin < last; ++gap) {
+            auto b = std::max(gap->begin, offset);
+            auto e = std::min(gap->end, last);
+            if (b < e) {
+                std::fill(out.begin() + (b - offset), out.begin() + (e - offset), uint8_t{4});
+            }
+        }
+        auto ex = std::ranges::lower_bound(exceptions, offset, {}, &exception::position);
+        for (; ex != exceptions.end() and ex->position < last; ++ex) {
+            if constexpr (std::same_as<Alphabet, dna5>) {
+                out[ex->position - offset] = 4;
+            } else {
+                out[ex->position - offset] = ex->rank;
+            }
+        }
+    }
+
+    /*! \brief Extracts a region as ranks
+     *
+     * \tparam Alphabet iupac or dna5, for dna5 exceptions are reported as N
+     * \param offset first position of the region
+     * \param length number of positions
+     * \return ranks of the region
+     */
+    template <alphabet_c Alphabet = iupac>
+        requires (std::same_as<Alphabet, iupac> or std::same_as<Alphabet, dna5>)
+    auto extract(size_t offset, size_t length) const -> std::vector<uint8_t> {
+        auto out = std::vector<uint8_t>{};
+        out.resize(length);
+        extract<Alphabet>(offset, out);
+        return out;
+    }
+
+    /*! \brief Extracts a region as chars
+     *
+     * \tparam Alphabet iupac or dna5, for dna5 exceptions are reported as N
+     * \param offset first position of the region
+     * \param length number of positions
+     * \return chars of the region
+     */
+    template <alphabet_c Alphabet = iupac>
+        requires (std::same_as<Alphabet, iupac> or std::same_as<Alphabet, dna5>)
+    auto extract_char(size_t offset, size_t length) const -> std::string {
+        auto ranks = extract<Alphabet>(offset, length);
+        auto out = std::string{};
+        out.resize(length);
+        for (size_t i{0}; i < length; ++i) {
+            out[i] = Alphabet::rank_to_char(ranks[i]);
+        }
+        return out;
+    }
+
+    /*! \brief Sorted, non overlapping intervals of all positions that are not A, C, G or T
+     */
+    auto unknown_intervals() const -> std::vector<interval> {
+        auto res = std::vector<interval>{};
+        res.reserve(gaps.size() + exceptions.size());
+        auto add = [&](interval v) {
+            if (!res.empty() and res.back().end == v.begin) {
+                res.back().end = v.end;
+            } else {
+                res.push_back(v);
+            }
+        };
+        auto ex = exceptions.begin();
+        for (auto const& gap : gaps) {
+            for (; ex != exceptions.end() and ex->position < gap.begin; ++ex) {
+                add({ex->position, ex->position + 1});
+            }
+            add(gap);
+        }
+        for (; ex != exceptions.end(); ++ex) {
+            add({ex->position, ex->position + 1});
+        }
+        return res;
+    }
+
+    /*! \brief K-mers of all stretches of A, C, G and T, positions refer to this sequence
+     */
+    template <bool UseCanonicalKmers=true>
+    auto kmers(size_t k, size_t seed = 0) const -> n_compressed_compact_encoding<UseCanonicalKmers> {
+        return {static_cast<packed_span<dna4>>(bases), unknown_intervals(), k, seed};
+    }
+
+    /*! \brief Minimizers of all stretches of A, C, G and T, positions refer to this sequence
+     */
+    template <bool DuplicatesAllowed=true, bool UseCanonicalKmers=true>
+    auto minimizers(size_t k, size_t window, size_t seed = 0) const -> n_compressed_winnowing_minimizer<DuplicatesAllowed, UseCanonicalKmers> {
+        return {static_cast<packed_span<dna4>>(bases), unknown_intervals(), k, window, seed};
+    }
+};
+
+}
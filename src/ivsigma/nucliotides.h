@@ -102,6 +102,16 @@ struct dna3bs : alphabet<rank_char_mappings<
 {};
 static_assert(alphabet_c<dna3bs>, "Unit test: is supposed to model an alphabet");
 
+// bisulfite converted bottom strand (G->A)
+//                                                       rank, symbol,   alts...
+struct dna3bs_ga : alphabet<rank_char_mappings<
+                                    rank_char_mapping<   0,    'A',   'a', 'G', 'g'>,
+                                    rank_char_mapping<   1,    'C',   'c'>,
+                                    rank_char_mapping<   2,    'T',   't', 'U', 'u'>
+                                >>
+{};
+static_assert(alphabet_c<dna3bs_ga>, "Unit test: is supposed to model an alphabet");
+
 struct d_dna2 : delimited_alphabet<dna2> {};
 static_assert(alphabet_c<d_dna2>, "Unit test: is supposed to model an alphabet");
 
@@ -123,4 +133,7 @@ static_assert(alphabet_c<d_rna5>, "Unit test: is supposed to model an alphabet")
 struct d_dna3bs : delimited_alphabet<dna3bs> {};
 static_assert(alphabet_c<d_dna3bs>, "Unit test: is supposed to model an alphabet");
 
+struct d_dna3bs_ga : delimited_alphabet<dna3bs_ga> {};
+static_assert(alphabet_c<d_dna3bs_ga>, "Unit test: is supposed to model an alphabet");
+
 }
@@ -0,0 +1,268 @@
+// SPDX-FileCopyrightText: 2006-2023, Knut Reinert & Freie Universität Berlin
+// SPDX-FileCopyrightText: 2016-2023, Knut Reinert & MPI für molekulare Genetik
+// SPDX-License-Identifier: BSD-3-Clause
+#pragma once
+
+#include "concepts.h"
+
+#include <algorithm>
+#include <bit>
+#include <cassert>
+#include <compare>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <ranges>
+#include <span>
+#include <vector>
+
+namespace ivs {
+
+/*! \brief Number of bits required to store a single rank of Alphabet
+ */
+template <alphabet_c Alphabet>
+constexpr size_t packed_bits = std::max<size_t>(1, std::bit_width(Alphabet::size()-1));
+
+}
+
+namespace ivs::detail {
+
+/**
+ * Layout of ranks inside of 64bit words.
+ * Ranks never cross word boundaries, the first rank is stored in the least significant bits.
+ */
+template <size_t Bits>
+struct packed_layout {
+    static_assert(Bits > 0 and Bits <= 8);
+
+    static constexpr size_t   bits           = Bits;
+    static constexpr size_t   ranks_per_word = 64 / Bits;
+    static constexpr uint64_t mask           = (uint64_t{1} << Bits) - 1;
+
+    static constexpr auto words(size_t length) noexcept -> size_t {
+        return (length + ranks_per_word - 1) / ranks_per_word;
+    }
+
+    static constexpr auto get(uint64_t const* data, size_t i) noexcept -> uint8_t {
+        return (data[i / ranks_per_word] >> ((i % ranks_per_word) * Bits)) & mask;
+    }
+
+    static constexpr void set(uint64_t* data, size_t i, uint8_t r) noexcept {
+        auto shift = (i % ranks_per_word) * Bits;
+        auto& word = data[i / ranks_per_word];
+        word = (word & ~(mask << shift)) | ((uint64_t{r} & mask) << shift);
+    }
+
+    /*! \brief Packs ranks into words, the words must be zero initialized
+     */
+    static constexpr void pack(std::span<uint8_t const> in, uint64_t* data, size_t offset = 0) noexcept {
+        size_t i{0};
+        // unaligned head
+        for (; i < in.size() and (offset + i) % ranks_per_word != 0; ++i) {
+            set(data, offset + i, in[i]);
+        }
+        // full words
+        for (; i + ranks_per_word <= in.size(); i += ranks_per_word) {
+            uint64_t word{};
+            for (size_t j{0}; j < ranks_per_word; ++j) {
+                word |= (uint64_t{in[i+j]} & mask) << (j * Bits);
+            }
+            data[(offset + i) / ranks_per_word] = word;
+        }
+        // tail
+        for (; i < in.size(); ++i) {
+            set(data, offset + i, in[i]);
+        }
+    }
+
+    /*! \brief Unpacks ranks starting at position offset
+     */
+    static constexpr void unpack(uint64_t const* data, size_t offset, std::span<uint8_t> out) noexcept {
+        size_t i{0};
+        for (; i < out.size() and (offset + i) % ranks_per_word != 0; ++i) {
+            out[i] = get(data, offset + i);
+        }
+        for (; i + ranks_per_word <= out.size(); i += ranks_per_word) {
+            auto word = data[(offset + i) / ranks_per_word];
+            for (size_t j{0}; j < ranks_per_word; ++j) {
+                out[i+j] = (word >> (j * Bits)) & mask;
+            }
+        }
+        for (; i < out.size(); ++i) {
+            out[i] = get(data, offset + i);
+        }
+    }
+};
+
+/**
+ * Random access iterator over packed ranks
+ */
+template <size_t Bits>
+struct packed_iterator {
+    using Layout            = packed_layout<Bits>;
+    using value_type        = uint8_t;
+    using difference_type   = std::ptrdiff_t;
+    using iterator_category = std::random_access_iterator_tag;
+
+    uint64_t const* data{};
+    size_t          pos{};
+
+    auto operator*() const -> uint8_t { return Layout::get(data, pos); }
+    auto operator[](difference_type n) const -> uint8_t { return Layout::get(data, pos + n); }
+
+    auto operator++() -> packed_iterator& { ++pos; return *this; }
+    auto operator--() -> packed_iterator& { --pos; return *this; }
+    auto operator++(int) -> packed_iterator { auto r = *this; ++pos; return r; }
+    auto operator--(int) -> packed_iterator { auto r = *this; --pos; return r; }
+    auto operator+=(difference_type n) -> packed_iterator& { pos += n; return *this; }
+    auto operator-=(difference_type n) -> packed_iterator& { pos -= n; return *this; }
+
+    friend auto operator+(packed_iterator i, difference_type n) -> packed_iterator { return i += n; }
+    friend auto operator+(difference_type n, packed_iterator i) -> packed_iterator { return i += n; }
+    friend auto operator-(packed_iterator i, difference_type n) -> packed_iterator { return i -= n; }
+    friend auto operator-(packed_iterator const& lhs, packed_iterator const& rhs) -> difference_type {
+        return static_cast<difference_type>(lhs.pos) - static_cast<difference_type>(rhs.pos);
+    }
+
+    friend bool operator==(packed_iterator const& lhs, packed_iterator const& rhs) { return lhs.pos == rhs.pos; }
+    friend auto operator<=>(packed_iterator const& lhs, packed_iterator const& rhs) { return lhs.pos <=> rhs.pos; }
+};
+
+}
+
+namespace ivs {
+
+/*! \brief A non owning view of bit packed ranks
+ *
+ * Each rank occupies `packed_bits<Alphabet>` bits, e.g. 2 bits for dna4 or 3 bits for dna5.
+ */
+template <alphabet_c Alphabet>
+struct packed_span {
+    using Layout   = detail::packed_layout<packed_bits<Alphabet>>;
+    using iterator = detail::packed_iterator<packed_bits<Alphabet>>;
+
+    std::span<uint64_t const> words;
+    size_t                    length{};
+
+    auto size() const noexcept -> size_t { return length; }
+    auto empty() const noexcept -> bool { return length == 0; }
+
+    auto operator[](size_t i) const noexcept -> uint8_t {
+        assert(i < length);
+        return Layout::get(words.data(), i);
+    }
+
+    auto begin() const noexcept -> iterator { return {words.data(), 0}; }
+    auto end() const noexcept -> iterator { return {words.data(), length}; }
+
+    /*! \brief A subrange of the packed sequence
+     */
+    auto subspan(size_t offset, size_t count) const noexcept {
+        assert(offset + count <= length);
+        return std::ranges::subrange{begin() + offset, begin() + offset + count};
+    }
+
+    /*! \brief Unpacks ranks starting at position offset
+     *
+     * \param offset first position to unpack
+     * \param out unpacked ranks (offset + out.size() must not exceed size())
+     */
+    void unpack(size_t offset, std::span<uint8_t> out) const noexcept {
+        assert(offset + out.size() <= length);
+        Layout::unpack(words.data(), offset, out);
+    }
+
+    /*! \brief Unpacks all ranks
+     */
+    auto unpack() const -> std::vector<uint8_t> {
+        auto out = std::vector<uint8_t>{};
+        out.resize(length);
+        unpack(0, out);
+        return out;
+    }
+};
+
+/*! \brief Bit packed ranks
+ *
+ * Each rank occupies `packed_bits<Alphabet>` bits, e.g. 2 bits for dna4 or 3 bits for dna5.
+ * Ranks never cross word boundaries, allowing O(1) random access.
+ */
+template <alphabet_c Alphabet>
+struct packed_sequence {
+    using Layout   = detail::packed_layout<packed_bits<Alphabet>>;
+    using iterator = detail::packed_iterator<packed_bits<Alphabet>>;
+
+    std::vector<uint64_t> words;
+    size_t                length{};
+
+    packed_sequence() = default;
+
+    /*! \brief Packs a rank sequence
+     *
+     * \param in ranks of Alphabet, invalid ranks are truncated
+     */
+    packed_sequence(std::span<uint8_t const> in) {
+        append(in);
+    }
+
+    auto size() const noexcept -> size_t { return length; }
+    auto empty() const noexcept -> bool { return length == 0; }
+
+    auto operator[](size_t i) const noexcept -> uint8_t {
+        assert(i < length);
+        return Layout::get(words.data(), i);
+    }
+
+    void set(size_t i, uint8_t r) noexcept {
+        assert(i < length);
+        Layout::set(words.data(), i, r);
+    }
+
+    void resize(size_t n) {
+        words.resize(Layout::words(n));
+        // clear unused bits, so packed ranks can be compared word wise
+        for (auto i{n}; i < std::min(length, words.size() * Layout::ranks_per_word); ++i) {
+            Layout::set(words.data(), i, 0);
+        }
+        length = n;
+    }
+
+    void push_back(uint8_t r) {
+        resize(length + 1);
+        set(length - 1, r);
+    }
+
+    /*! \brief Appends ranks to the end
+     */
+    void append(std::span<uint8_t const> in) {
+        auto offset = length;
+        resize(length + in.size());
+        Layout::pack(in, words.data(), offset);
+    }
+
+    void clear() noexcept {
+        words.clear();
+        length = 0;
+    }
+
+    auto begin() const noexcept -> iterator { return {words.data(), 0}; }
+    auto end() const noexcept -> iterator { return {words.data(), length}; }
+
+    operator packed_span<Alphabet>() const noexcept {
+        return {words, length};
+    }
+
+    /*! \brief Unpacks ranks starting at position offset
+     */
+    void unpack(size_t offset, std::span<uint8_t> out) const noexcept {
+        packed_span<Alphabet>{words, length}.unpack(offset, out);
+    }
+
+    /*! \brief Unpacks all ranks
+     */
+    auto unpack() const -> std::vector<uint8_t> {
+        return packed_span<Alphabet>{words, length}.unpack();
+    }
+};
+
+}
@@ -0,0 +1,294 @@
+// SPDX-FileCopyrightText: 2006-2023, Knut Reinert & Freie Universität Berlin
+// SPDX-FileCopyrightText: 2016-2023, Knut Reinert & MPI für molekulare Genetik
+// SPDX-License-Identifier: BSD-3-Clause
+#pragma once
+
+#include "concepts.h"
+#include "fastx_reader.h"
+#include "packed_sequence.h"
+
+#include <array>
+#include <bit>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <optional>
+#include <ostream>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace ivs::detail {
+
+/*! \brief Identifies an alphabet by its size and the chars of all ranks (FNV-1a)
+ */
+template <alphabet_c Alphabet>
+constexpr auto alphabet_fingerprint() -> uint64_t {
+    uint64_t h = 0xcbf2'9ce4'8422'2325ull;
+    auto add = [&](uint8_t v) {
+        h ^= v;
+        h *= 0x100'0000'01b3ull;
+    };
+    add(static_cast<uint8_t>(Alphabet::size()));
+    for (size_t r{0}; r < Alphabet::size(); ++r) {
+        add(static_cast<uint8_t>(Alphabet::rank_to_char(r)));
+    }
+    return h;
+}
+
+/**
+ * File layout of a packed_store, all values are little endian:
+ * header | entries | names | payloads
+ * Each payload consists of packed 64bit words (see packed_layout) and starts at a 64 byte boundary.
+ */
+struct packed_store_header {
+    std::array<char, 8> magic;
+    uint64_t            alphabet;     // alphabet_fingerprint
+    uint32_t            bits;         // bits per rank
+    uint32_t            version;
+    uint64_t            count;        // number of sequences
+    uint64_t            entries;      // offset of the entries
+    uint64_t            names;        // offset of the name arena
+    uint64_t            names_size;
+    uint64_t            file_size;
+};
+static_assert(sizeof(packed_store_header) == 64);
+
+struct packed_store_entry {
+    uint64_t payload;     // offset of the packed words
+    uint64_t length;      // number of ranks
+    uint64_t name;        // offset of the name inside of the name arena
+    uint64_t name_length;
+};
+static_assert(sizeof(packed_store_entry) == 32);
+
+inline constexpr auto packed_store_magic = std::array<char, 8>{'I', 'V', 'S', 'P', 'A', 'C', 'K', '\0'};
+
+}
+
+namespace ivs {
+
+/*! \brief Read only collection of packed sequences, memory mapped from a file
+ *
+ * Opening validates the header and the directory of sequences, no sequence data is parsed or copied.
+ * Sequences are returned as packed_span into the mapping, giving O(1) access to any region.
+ * All functions are const, a store can be used by many threads at once
+ * and the mapping is shared by all processes opening the same file.
+ * Files are written by packed_store_writer.
+ *
+ * \tparam Alphabet alphabet of the stored ranks, must match the alphabet of the file
+ */
+template <alphabet_c Alphabet>
+struct packed_store {
+    using Layout = detail::packed_layout<packed_bits<Alphabet>>;
+
+    /*!
+     * \param path file written by packed_store_writer
+     * \param advice expected access pattern, e.g. map_advice::huge_pages
+     */
+    explicit packed_store(std::filesystem::path const& path, map_advice advice = map_advice::random)
+        : file{path, advice}
+    {
+        open(file.data());
+    }
+
+    /*! \brief Uses a store in memory, data must be 8 byte aligned and outlive the packed_store
+     */
+    explicit packed_store(std::span<char const> data) {
+        open(data);
+    }
+
+    //! Number of sequences
+    auto size() const noexcept -> size_t { return header.count; }
+
+    auto name(size_t i) const -> std::string_view {
+        auto e = entry(i);
+        return {bytes.data() + header.names + e.name, e.name_length};
+    }
+
+    //! Number of ranks of the i-th sequence
+    auto length(size_t i) const -> size_t {
+        return entry(i).length;
+    }
+
+    /*! \brief Ranks of the i-th sequence, a view into the mapping
+     */
+    auto sequence(size_t i) const -> packed_span<Alphabet> {
+        auto e = entry(i);
+        auto words = reinterpret_cast<uint64_t const*>(bytes.data() + e.payload);
+        return {std::span{words, Layout::words(e.length)}, e.length};
+    }
+
+    /*! \brief Index of a sequence by name, linear in the number of sequences
+     */
+    auto find(std::string_view n) const -> std::optional<size_t> {
+        for (size_t i{0}; i < size(); ++i) {
+            if (name(i) == n) return i;
+        }
+        return std::nullopt;
+    }
+
+    /*! \brief Extracts a region of the i-th sequence
+     *
+     * \param out ranks of the region (offset + out.size() must not exceed length(i))
+     */
+    void extract(size_t i, size_t offset, std::span<uint8_t> out) const {
+        sequence(i).unpack(offset, out);
+    }
+
+    auto extract(size_t i, size_t offset, size_t count) const -> std::vector<uint8_t> {
+        auto out = std::vector<uint8_t>{};
+        out.resize(count);
+        extract(i, offset, out);
+        return out;
+    }
+
+    auto extract_char(size_t i, size_t offset, size_t count) const -> std::string {
+        auto ranks = extract(i, offset, count);
+        auto out = std::string{};
+        out.resize(count);
+        for (size_t j{0}; j < count; ++j) {
+            out[j] = Alphabet::rank_to_char(ranks[j]);
+        }
+        return out;
+    }
+
+private:
+    mapped_file                 file;
+    std::span<char const>       bytes;
+    detail::packed_store_header header{};
+
+    auto entry(size_t i) const -> detail::packed_store_entry {
+        assert(i < size());
+        auto e = detail::packed_store_entry{};
+        std::memcpy(&e, bytes.data() + header.entries + i * sizeof(e), sizeof(e));
+        return e;
+    }
+
+    void open(std::span<char const> data) {
+        if constexpr (std::endian::native != std::endian::little) {
+            throw std::runtime_error{"packed_store requires a little endian machine"};
+        }
+        bytes = data;
+        if (bytes.size() < sizeof(header)) throw std::runtime_error{"not a packed store"};
+        std::memcpy(&header, bytes.data(), sizeof(header));
+        if (header.magic != detail::packed_store_magic or header.version != 1) throw std::runtime_error{"not a packed store"};
+        if (header.alphabet != detail::alphabet_fingerprint<Alphabet>() or header.bits != packed_bits<Alphabet>) {
+            throw std::runtime_error{"packed store was written with a different alphabet"};
+        }
+        if (header.file_size != bytes.size()
+            or header.entries > bytes.size()
+            or header.count > (bytes.size() - header.entries) / sizeof(detail::packed_store_entry)
+            or header.names > bytes.size()
+            or header.names_size > bytes.size() - header.names) {
+            throw std::runtime_error{"corrupt packed store"};
+        }
+        if (reinterpret_cast<uintptr_t>(bytes.data()) % alignof(uint64_t) != 0) {
+            throw std::runtime_error{"packed store is not aligned"};
+        }
+        // all payloads and names must lie inside of the file, accessors rely on it
+        for (size_t i{0}; i < size(); ++i) {
+            auto e = entry(i);
+            if (e.payload % sizeof(uint64_t) != 0
+                or e.payload > bytes.size()
+                or e.length > (bytes.size() - e.payload) / sizeof(uint64_t) * Layout::ranks_per_word // Layout::words(length) fit
+                or e.name > header.names_size
+                or e.name_length > header.names_size - e.name) {
+                throw std::runtime_error{"corrupt packed store"};
+            }
+        }
+    }
+};
+
+/*! \brief Collects sequences and writes them as a packed_store file
+ */
+template <alphabet_c Alphabet>
+struct packed_store_writer {
+    struct sequence {
+        std::string                name;
+        packed_sequence<Alphabet>  ranks;
+    };
+    std::vector<sequence> sequences;
+
+    /*! \brief Adds a sequence
+     *
+     * \param ranks ranks of Alphabet
+     */
+    void add(std::string_view name, std::span<uint8_t const> ranks) {
+        sequences.push_back({std::string{name}, packed_sequence<Alphabet>{ranks}});
+    }
+
+    /*! \brief Adds a sequence that is already packed, e.g. a packed_sequence
+     */
+    void add(std::string_view name, packed_span<Alphabet> ranks) {
+        auto seq = packed_sequence<Alphabet>{};
+        seq.words.assign(ranks.words.begin(), ranks.words.end());
+        seq.length = ranks.size();
+        sequences.push_back({std::string{name}, std::move(seq)});
+    }
+
+    void write(std::ostream& out) const {
+        auto align = [](uint64_t v) { return (v + 63) / 64 * 64; };
+
+        auto header = detail::packed_store_header{};
+        header.magic    = detail::packed_store_magic;
+        header.alphabet = detail::alphabet_fingerprint<Alphabet>();
+        header.bits     = packed_bits<Alphabet>;
+        header.version  = 1;
+        header.count    = sequences.size();
+        header.entries  = sizeof(header);
+        header.names    = header.entries + sequences.size() * sizeof(detail::packed_store_entry);
+
+        auto entries = std::vector<detail::packed_store_entry>{};
+        for (auto const& s : sequences) {
+            entries.push_back({0, s.ranks.size(), header.names_size, s.name.size()});
+            header.names_size += s.name.size();
+        }
+        auto pos = align(header.names + header.names_size);
+        for (size_t i{0}; i < sequences.size(); ++i) {
+            entries[i].payload = pos;
+            pos = align(pos + sequences[i].ranks.words.size() * sizeof(uint64_t));
+        }
+        header.file_size = pos;
+
+        auto written = uint64_t{0};
+        auto put = [&](void const* data, size_t n) {
+            out.write(static_cast<char const*>(data), static_cast<std::streamsize>(n));
+            written += n;
+        };
+        auto pad = [&](uint64_t target) {
+            static constexpr auto zeros = std::array<char, 64>{};
+            put(zeros.data(), target - written);
+        };
+        put(&header, sizeof(header));
+        put(entries.data(), entries.size() * sizeof(detail::packed_store_entry));
+        for (auto const& s : sequences) {
+            put(s.name.data(), s.name.size());
+        }
+        for (size_t i{0}; i < sequences.size(); ++i) {
+            pad(entries[i].payload);
+            put(sequences[i].ranks.words.data(), sequences[i].ranks.words.size() * sizeof(uint64_t));
+        }
+        pad(header.file_size);
+    }
+
+    /*! \brief Writes all sequences into a file, throws std::runtime_error on failure
+     */
+    void write(std::filesystem::path const& path) const {
+        if constexpr (std::endian::native != std::endian::little) {
+            throw std::runtime_error{"packed_store requires a little endian machine"};
+        }
+        auto ofs = std::ofstream{path, std::ios::binary};
+        if (!ofs) throw std::runtime_error{"can not open " + path.string()};
+        write(ofs);
+        if (!ofs) throw std::runtime_error{"can not write " + path.string()};
+    }
+};
+
+}
@@ -5,12 +5,40 @@
 
 #include "alphabet.h"
 
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <concepts>
 #include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <span>
+#include <vector>
 
 namespace ivs {
 
-template <size_t Size, char Offset>
+/*! \brief How a quality score relates to an error probability
+ */
+enum class quality_scale {
+    phred,  //!< Q = -10 log10(p)
+    solexa, //!< Q = -10 log10(p / (1-p))
+};
+
+/*! \brief Alphabet of Size consecutive chars, starting at Offset
+ *
+ * \tparam Size number of valid chars
+ * \tparam Offset char representing rank 0
+ * \tparam Scale how scores relate to error probabilities
+ */
+template <size_t Size, char Offset, quality_scale Scale = quality_scale::phred>
 struct ranged_alphabet {
+    static_assert(Size > 0 and Size + Offset <= 128);
+
+    static constexpr quality_scale scale = Scale;
+
+    //! Quality score of rank 0 (solexa scores start at -5 with ';')
+    static constexpr int min_score = (Scale == quality_scale::solexa) ? Offset - '@' : 0;
+
     /*! \brief Converts a single char value to a rank value
      *
      * \param c char value
@@ -18,7 +46,7 @@ struct ranged_alphabet {
      */
     template <uint8_t Unknown = 255>
     static constexpr auto char_to_rank(char c) noexcept -> uint8_t {
-        if (c < Offset or c-Offset > Size) {
+        if (c < Offset or c-Offset >= static_cast<int>(Size)) {
             return Unknown;
         }
         return c - Offset;
@@ -31,15 +59,238 @@ struct ranged_alphabet {
      */
     template <char Unknown = '\0'>
     static constexpr auto rank_to_char(uint8_t v) noexcept -> char {
-        if (v > Size) return Unknown;
+        if (v >= Size) return Unknown;
         return v + Offset;
     }
+
+    /*! \brief Normalizes a char, valid chars stay unchanged
+     *
+     * \param c char value
+     * \return c or Unknown if c is not part of the alphabet
+     */
+    template <char Unknown = '\0'>
+    static constexpr auto normalize_char(char c) noexcept -> char {
+        return rank_to_char<Unknown>(char_to_rank(c));
+    }
+
+    /*! \brief Returns size of the alphabet
+     *
+     * \return a size_t representing the size of the alphabet
+     */
+    static constexpr auto size() noexcept -> size_t {
+        return Size;
+    }
+
+    /*! \brief Quality score of a rank
+     */
+    static constexpr auto score(uint8_t v) noexcept -> int {
+        return v + min_score;
+    }
 };
 
 
 using pthred42       = ranged_alphabet<42, '!'>;
 using pthred63       = ranged_alphabet<63, '!'>;
-using pthred68solexa = ranged_alphabet<68, ';'>;
+using pthred68solexa = ranged_alphabet<68, ';', quality_scale::solexa>;
 using pthred94       = ranged_alphabet<94, '!'>;
 
+static_assert(alphabet_c<pthred42>, "Unit test: is supposed to model an alphabet");
+static_assert(alphabet_c<pthred63>, "Unit test: is supposed to model an alphabet");
+static_assert(alphabet_c<pthred68solexa>, "Unit test: is supposed to model an alphabet");
+static_assert(alphabet_c<pthred94>, "Unit test: is supposed to model an alphabet");
+
+template <typename Alphabet>
+concept quality_alphabet_c = alphabet_c<Alphabet> and requires(Alphabet) {
+    { Alphabet::scale } -> std::convertible_to<quality_scale>;
+    { Alphabet::score(uint8_t{}) } -> std::same_as<int>;
+};
+
+}
+
+namespace ivs::detail {
+
+/**
+ * Computes 10^(-q/10) without std::pow, so it can be used at compile time
+ */
+constexpr auto pow10_neg_tenth(int q) -> double {
+    constexpr double step = 0.79432823472428150206; // 10^(-1/10)
+    auto v = 1.;
+    for (int i{0}; i < q; ++i) v *= step;
+    for (int i{0}; i > q; --i) v /= step;
+    return v;
+}
+
+//! Error probability of each rank of a quality alphabet
+template <quality_alphabet_c Alphabet>
+constexpr std::array<double, Alphabet::size()> error_probability_table{[]() {
+    auto table = std::array<double, Alphabet::size()>{};
+    for (size_t r{0}; r < table.size(); ++r) {
+        auto e = pow10_neg_tenth(Alphabet::score(r));
+        if constexpr (Alphabet::scale == quality_scale::solexa) {
+            e = e / (1. + e);
+        }
+        table[r] = e;
+    }
+    return table;
+}()};
+
+}
+
+namespace ivs {
+
+/*! \brief Error probability of a single rank of a quality alphabet
+ *
+ * \param r rank of Alphabet
+ * \return probability that the corresponding base call is wrong
+ */
+template <quality_alphabet_c Alphabet>
+constexpr auto error_probability(uint8_t r) noexcept -> double {
+    assert(r < Alphabet::size());
+    return detail::error_probability_table<Alphabet>[r];
+}
+
+/*! \brief Decodes a quality string into ranks
+ *
+ * Decoding is a plain subtraction without table lookups or branches,
+ * which allows the compiler to vectorize it.
+ *
+ * \tparam Alphabet describes the used quality alphabet
+ * \param in quality string
+ * \param out ranks of input (must have same size as in), invalid chars are converted to Unknown
+ * \return true if all chars were valid
+ */
+template <quality_alphabet_c Alphabet, uint8_t Unknown = 255>
+auto decode_phred(std::span<char const> in, std::span<uint8_t> out) -> bool {
+    assert(in.size() == out.size());
+    constexpr auto offset = Alphabet::rank_to_char(0);
+    uint8_t invalid{0};
+    for (size_t i{0}; i < in.size(); ++i) {
+        auto r = static_cast<uint8_t>(in[i] - offset);
+        auto bad = static_cast<uint8_t>(r >= Alphabet::size());
+        invalid |= bad;
+        out[i] = bad ? Unknown : r;
+    }
+    return invalid == 0;
+}
+
+/*! \brief Decodes a quality string into ranks
+ *
+ * \tparam Alphabet describes the used quality alphabet
+ * \param in quality string
+ * \return ranks of input, invalid chars are converted to Unknown
+ */
+template <quality_alphabet_c Alphabet, uint8_t Unknown = 255>
+auto decode_phred(std::span<char const> in) -> std::vector<uint8_t> {
+    auto out = std::vector<uint8_t>{};
+    out.resize(in.size());
+    decode_phred<Alphabet, Unknown>(in, out);
+    return out;
+}
+
+/*! \brief Checks if all chars are valid quality chars
+ *
+ * Validates blocks of 64 chars without early exit, only the failing block is searched.
+ *
+ * \tparam Alphabet describes the used quality alphabet
+ * \param in quality string
+ * \return std::optional pointing to the first invalid char (if one exists)
+ */
+template <quality_alphabet_c Alphabet>
+auto validate_phred(std::span<char const> in) -> std::optional<size_t> {
+    constexpr auto offset = Alphabet::rank_to_char(0);
+    auto isInvalid = [](char c) -> bool {
+        return static_cast<uint8_t>(c - offset) >= Alphabet::size();
+    };
+    for (size_t i{0}; i < in.size(); i += 64) {
+        auto len = std::min<size_t>(64, in.size() - i);
+        bool invalid{false};
+        for (size_t j{0}; j < len; ++j) {
+            invalid |= isInvalid(in[i+j]);
+        }
+        if (invalid) {
+            for (size_t j{0}; j < len; ++j) {
+                if (isInvalid(in[i+j])) return i + j;
+            }
+        }
+    }
+    return std::nullopt;
+}
+
+/*! \brief Statistics of a single quality string
+ */
+struct quality_statistics {
+    size_t  length{};          //!< number of valid quality values
+    size_t  invalid{};         //!< number of chars that are not part of the alphabet
+    int64_t sum{};             //!< sum of all quality scores
+    int     min{};             //!< smallest quality score (0 for empty strings)
+    double  expected_errors{}; //!< sum of all error probabilities
+
+    /*! \brief Mean quality score, 0 for empty strings
+     */
+    auto mean() const -> double {
+        if (length == 0) return 0.;
+        return static_cast<double>(sum) / length;
+    }
+};
+
+namespace detail {
+
+/**
+ * Accumulates statistics of quality ranks, ranks outside of the alphabet are counted as invalid
+ */
+template <quality_alphabet_c Alphabet, typename Range, typename ToRank>
+auto quality_statistics_of(Range const& in, ToRank toRank) -> quality_statistics {
+    auto const& probabilities = error_probability_table<Alphabet>;
+    auto res = quality_statistics{};
+    size_t  minRank{Alphabet::size()};
+    size_t  rankSum{};
+    for (auto v : in) {
+        auto r = toRank(v);
+        if (r >= Alphabet::size()) {
+            res.invalid += 1;
+            continue;
+        }
+        rankSum += r;
+        minRank = std::min<size_t>(minRank, r);
+        res.expected_errors += probabilities[r];
+    }
+    res.length = in.size() - res.invalid;
+    res.sum    = static_cast<int64_t>(rankSum) + static_cast<int64_t>(res.length) * Alphabet::min_score;
+    if (res.length > 0) {
+        res.min = Alphabet::score(minRank);
+    }
+    return res;
+}
+
+}
+
+/*! \brief Computes statistics of a quality string in a single pass
+ *
+ * Expected errors are computed via a precomputed table of error probabilities.
+ *
+ * \tparam Alphabet describes the used quality alphabet
+ * \param in quality string
+ * \return statistics of in, invalid chars are only counted
+ */
+template <quality_alphabet_c Alphabet>
+auto compute_quality_statistics(std::span<char const> in) -> quality_statistics {
+    constexpr auto offset = Alphabet::rank_to_char(0);
+    return detail::quality_statistics_of<Alphabet>(in, [](char c) {
+        return static_cast<uint8_t>(c - offset);
+    });
+}
+
+/*! \brief Computes statistics of quality ranks in a single pass
+ *
+ * \tparam Alphabet describes the used quality alphabet
+ * \param in quality ranks
+ * \return statistics of in, invalid ranks are only counted
+ */
+template <quality_alphabet_c Alphabet>
+auto compute_quality_statistics(std::span<uint8_t const> in) -> quality_statistics {
+    return detail::quality_statistics_of<Alphabet>(in, [](uint8_t r) {
+        return r;
+    });
+}
+
 }
@@ -0,0 +1,242 @@
+// SPDX-FileCopyrightText: 2006-2023, Knut Reinert & Freie Universität Berlin
+// SPDX-FileCopyrightText: 2016-2023, Knut Reinert & MPI für molekulare Genetik
+// SPDX-License-Identifier: BSD-3-Clause
+#pragma once
+
+#include "qualities.h"
+
+#include <array>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <ranges>
+#include <span>
+#include <string>
+#include <vector>
+
+namespace ivs {
+
+/*! \brief A single bin of a quality binning scheme
+ *
+ * All scores from `lower` up to the `lower` of the next bin are represented by `value`.
+ */
+struct quality_bin {
+    int lower; //!< smallest score of this bin
+    int value; //!< score representing this bin
+};
+
+/*! \brief Illumina 8 level binning
+ */
+struct illumina8_binning {
+    static constexpr auto bins = std::array<quality_bin, 8>{{
+        { 0,  0},
+        { 2,  6},
+        {10, 15},
+        {20, 22},
+        {25, 27},
+        {30, 33},
+        {35, 37},
+        {40, 40},
+    }};
+};
+
+/*! \brief Illumina 4 level binning (as used by NovaSeq)
+ */
+struct illumina4_binning {
+    static constexpr auto bins = std::array<quality_bin, 4>{{
+        { 0,  2},
+        { 3, 12},
+        {15, 23},
+        {31, 37},
+    }};
+};
+
+/*! \brief Alphabet of the bins of a binning scheme over a quality alphabet
+ *
+ * A rank is the index of a bin, its char is the char of the representing score.
+ * Scores below the first bin are assigned to the first bin.
+ * Combined with packed_sequence, 8 bins require 3 bits and 4 bins 2 bits per value.
+ *
+ * \tparam Alphabet quality alphabet, e.g. pthred42
+ * \tparam Scheme type with a sorted `static constexpr std::array<quality_bin, N> bins`
+ */
+template <quality_alphabet_c Alphabet, typename Scheme>
+struct quality_bin_alphabet {
+    using quality_alphabet = Alphabet;
+
+    static constexpr auto bins = Scheme::bins;
+    static_assert(bins.size() > 0 and bins.size() < 256);
+    static_assert([]() {
+        for (size_t i{0}; i < bins.size(); ++i) {
+            if (i > 0 and bins[i-1].lower >= bins[i].lower) return false;
+            if (bins[i].value < Alphabet::min_score or bins[i].value >= Alphabet::score(Alphabet::size()-1) + 1) return false;
+        }
+        return true;
+    }(), "bins must be sorted and representable in Alphabet");
+
+    //! Smallest rank of Alphabet of each bin
+    static constexpr std::array<int, bins.size()> lower_ranks{[]() {
+        auto res = std::array<int, bins.size()>{};
+        for (size_t i{0}; i < bins.size(); ++i) {
+            res[i] = bins[i].lower - Alphabet::min_score;
+        }
+        return res;
+    }()};
+
+    //! Bin index of each rank of Alphabet
+    static constexpr std::array<uint8_t, Alphabet::size()> bin_table{[]() {
+        auto res = std::array<uint8_t, Alphabet::size()>{};
+        for (size_t r{0}; r < res.size(); ++r) {
+            for (size_t i{1}; i < bins.size(); ++i) {
+                res[r] += static_cast<int>(r) >= lower_ranks[i];
+            }
+        }
+        return res;
+    }()};
+
+    /*! \brief Converts a single char value to a rank value (the bin index)
+     *
+     * \param c char value
+     * \return corresponding rank value
+     */
+    template <uint8_t Unknown = 255>
+    static constexpr auto char_to_rank(char c) noexcept -> uint8_t {
+        auto r = Alphabet::char_to_rank(c);
+        if (r >= Alphabet::size()) return Unknown;
+        return bin_table[r];
+    }
+
+    /*! \brief Converts a single rank value to a char value
+     *
+     * \param v a rank value (bin index)
+     * \return char of the score representing the bin
+     */
+    template <char Unknown = '\0'>
+    static constexpr auto rank_to_char(uint8_t v) noexcept -> char {
+        if (v >= bins.size()) return Unknown;
+        return Alphabet::rank_to_char(bins[v].value - Alphabet::min_score);
+    }
+
+    /*! \brief Bins a char
+     *
+     * \param c char value
+     * \return char of the representing score of the bin of c
+     */
+    template <char Unknown = '\0'>
+    static constexpr auto normalize_char(char c) noexcept -> char {
+        return rank_to_char<Unknown>(char_to_rank(c));
+    }
+
+    /*! \brief Returns size of the alphabet (number of bins)
+     */
+    static constexpr auto size() noexcept -> size_t {
+        return bins.size();
+    }
+};
+
+/*! \brief Converts a quality string to bin indices
+ *
+ * The bin index is computed as number of bin boundaries not larger than the rank.
+ * This is free of table lookups and branches, allowing the compiler to vectorize it.
+ *
+ * \tparam Alphabet quality alphabet
+ * \tparam Scheme binning scheme
+ * \param in quality string
+ * \param out bin indices (must have same size as in), invalid chars are converted to Unknown
+ */
+template <quality_alphabet_c Alphabet, typename Scheme, uint8_t Unknown = 255>
+void quality_char_to_bin(std::span<char const> in, std::span<uint8_t> out) {
+    assert(in.size() == out.size());
+    using Bins = quality_bin_alphabet<Alphabet, Scheme>;
+    constexpr auto offset = Alphabet::rank_to_char(0);
+    for (size_t i{0}; i < in.size(); ++i) {
+        auto r = static_cast<uint8_t>(in[i] - offset);
+        uint8_t bin{0};
+        for (size_t j{1}; j < Bins::size(); ++j) {
+            bin += r >= Bins::lower_ranks[j];
+        }
+        out[i] = (r < Alphabet::size()) ? bin : Unknown;
+    }
+}
+
+/*! \brief Converts a quality string to bin indices
+ *
+ * \tparam Alphabet quality alphabet
+ * \tparam Scheme binning scheme
+ * \param in quality string
+ * \return bin indices, invalid chars are converted to Unknown
+ */
+template <quality_alphabet_c Alphabet, typename Scheme, uint8_t Unknown = 255>
+auto quality_char_to_bin(std::span<char const> in) -> std::vector<uint8_t> {
+    auto out = std::vector<uint8_t>{};
+    out.resize(in.size());
+    quality_char_to_bin<Alphabet, Scheme, Unknown>(in, out);
+    return out;
+}
+
+/*! \brief A view representing a quality string as bin indices
+ *
+ * \tparam Alphabet quality alphabet
+ * \tparam Scheme binning scheme
+ */
+template <quality_alphabet_c Alphabet, typename Scheme, uint8_t Unknown = 255>
+auto view_quality_char_to_bin = std::views::transform([](char c) {
+    return quality_bin_alphabet<Alphabet, Scheme>::template char_to_rank<Unknown>(c);
+});
+
+/*! \brief Bins a quality string, each char is replaced by the char representing its bin
+ *
+ * \tparam Alphabet quality alphabet
+ * \tparam Scheme binning scheme
+ * \param in quality string
+ * \param out binned quality string (must have same size as in), invalid chars are converted to Unknown
+ */
+template <quality_alphabet_c Alphabet, typename Scheme, char Unknown = '\0'>
+void bin_quality_char(std::span<char const> in, std::span<char> out) {
+    assert(in.size() == out.size());
+    using Bins = quality_bin_alphabet<Alphabet, Scheme>;
+    constexpr auto chars = []() {
+        auto res = std::array<char, 256>{};
+        res.fill(Unknown);
+        for (size_t i{0}; i < Bins::size(); ++i) {
+            res[i] = Bins::rank_to_char(i);
+        }
+        return res;
+    }();
+    constexpr auto offset = Alphabet::rank_to_char(0);
+    for (size_t i{0}; i < in.size(); ++i) {
+        auto r = static_cast<uint8_t>(in[i] - offset);
+        uint8_t bin{0};
+        for (size_t j{1}; j < Bins::size(); ++j) {
+            bin += r >= Bins::lower_ranks[j];
+        }
+        out[i] = chars[(r < Alphabet::size()) ? bin : 255];
+    }
+}
+
+/*! \brief Bins a quality string, each char is replaced by the char representing its bin
+ *
+ * \tparam Alphabet quality alphabet
+ * \tparam Scheme binning scheme
+ * \param in quality string
+ * \return binned quality string, invalid chars are converted to Unknown
+ */
+template <quality_alphabet_c Alphabet, typename Scheme, char Unknown = '\0'>
+auto bin_quality_char(std::span<char const> in) -> std::string {
+    auto out = std::string{};
+    out.resize(in.size());
+    bin_quality_char<Alphabet, Scheme, Unknown>(in, out);
+    return out;
+}
+
+/*! \brief A view representing a binned quality string
+ *
+ * \tparam Alphabet quality alphabet
+ * \tparam Scheme binning scheme
+ */
+template <quality_alphabet_c Alphabet, typename Scheme, char Unknown = '\0'>
+auto view_bin_quality_char = std::views::transform([](char c) {
+    return quality_bin_alphabet<Alphabet, Scheme>::template normalize_char<Unknown>(c);
+});
+
+}
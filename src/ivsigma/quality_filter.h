@@ -0,0 +1,220 @@
+// SPDX-FileCopyrightText: 2006-2023, Knut Reinert & Freie Universität Berlin
+// SPDX-FileCopyrightText: 2016-2023, Knut Reinert & MPI für molekulare Genetik
+// SPDX-License-Identifier: BSD-3-Clause
+#pragma once
+
+#include "compact_encoding.h"
+#include "interval.h"
+#include "qualities.h"
+#include "soft_mask.h"
+#include "winnowing_minimizer.h"
+
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <span>
+#include <vector>
+
+namespace ivs {
+
+/*! \brief Thresholds a k-mer has to fulfill to be reported
+ */
+struct kmer_quality_filter {
+    uint8_t min_quality{0};                                               //!< smallest allowed quality rank of each position
+    double  max_expected_errors{std::numeric_limits<double>::infinity()}; //!< largest allowed sum of error probabilities
+};
+
+/*! \brief Computes intervals of positions with a quality rank below min_quality
+ *
+ * The result can be passed to masked_compact_encoding and masked_winnowing_minimizer,
+ * skipping all k-mers whose minimum quality is below min_quality.
+ *
+ * \param qualities quality ranks
+ * \param min_quality smallest accepted quality rank
+ * \param out sorted, non overlapping intervals
+ */
+inline void low_quality_intervals(std::span<uint8_t const> qualities, uint8_t min_quality, std::vector<interval>& out) {
+    out.clear();
+    auto collector = detail::soft_mask_collector{out};
+    for (size_t i{0}; i < qualities.size(); i += 64) {
+        auto len = std::min<size_t>(64, qualities.size() - i);
+        uint64_t bits{};
+        for (size_t j{0}; j < len; ++j) {
+            bits |= uint64_t{qualities[i+j] < min_quality} << j;
+        }
+        collector.add(bits, i, len);
+    }
+}
+
+/*! \brief Computes intervals of positions with a quality rank below min_quality
+ *
+ * \param qualities quality ranks
+ * \param min_quality smallest accepted quality rank
+ * \return sorted, non overlapping intervals
+ */
+inline auto low_quality_intervals(std::span<uint8_t const> qualities, uint8_t min_quality) -> std::vector<interval> {
+    auto out = std::vector<interval>{};
+    low_quality_intervals(qualities, min_quality, out);
+    return out;
+}
+
+/*! \brief compact_encoding skipping k-mers of low quality
+ *
+ * The quality of the k positions is tracked alongside the rolling hash, by counting
+ * positions below `min_quality` and summing up error probabilities of the window.
+ * Probabilities are summed as fixed point integers (multiples of 2^-40), so the
+ * window sum does not drift on long sequences.
+ * Invalid quality ranks count as error probability 1.
+ *
+ * \tparam Alphabet describes the used alphabet
+ * \tparam QualityAlphabet describes the quality alphabet, e.g. pthred42
+ */
+template <alphabet_c Alphabet, quality_alphabet_c QualityAlphabet, bool UseCanonicalKmers=true>
+struct quality_filtered_compact_encoding {
+    using Encoding = compact_encoding<Alphabet, UseCanonicalKmers>;
+
+    std::span<uint8_t const> values;
+    std::span<uint8_t const> qualities;
+    size_t const             k;
+    kmer_quality_filter      filter;
+    size_t const             seed;
+
+    quality_filtered_compact_encoding(std::span<uint8_t const> _values, std::span<uint8_t const> _qualities, size_t _k, kmer_quality_filter _filter, size_t _seed = 0)
+        : values{_values}
+        , qualities{_qualities}
+        , k{_k}
+        , filter{_filter}
+        , seed{_seed}
+        , encoding{_values, _k, _seed}
+    {
+        assert(values.size() == qualities.size());
+    }
+
+    /*! \brief Number of k-mers passing the filter, requires a full traversal
+     */
+    auto size() const -> size_t {
+        size_t s{0};
+        for (auto iter = iterator{*this}; iter != nullptr; ++iter) {
+            ++s;
+        }
+        return s;
+    }
+
+private:
+    Encoding encoding;
+
+    //! Fixed point scale of error probabilities
+    static constexpr double scale = double(uint64_t{1} << 40);
+
+    //! Error probability of each quality rank in multiples of 1/scale (at least 1), invalid ranks have probability 1
+    static constexpr std::array<uint64_t, 256> probabilities{[]() {
+        auto table = std::array<uint64_t, 256>{};
+        table.fill(static_cast<uint64_t>(scale));
+        for (size_t r{0}; r < QualityAlphabet::size(); ++r) {
+            auto p   = detail::error_probability_table<QualityAlphabet>[r];
+            table[r] = std::max<uint64_t>(1, static_cast<uint64_t>(p * scale + 0.5));
+        }
+        return table;
+    }()};
+
+    //! max_expected_errors in multiples of 1/scale
+    static auto fixed_point_errors(double max_expected_errors) -> uint64_t {
+        if (max_expected_errors <= 0.) return 0;
+        if (!(max_expected_errors < double(std::numeric_limits<uint64_t>::max() >> 1) / scale)) {
+            return std::numeric_limits<uint64_t>::max();
+        }
+        return static_cast<uint64_t>(max_expected_errors * scale + 0.5);
+    }
+
+public:
+    struct iterator {
+        using ValuesIter = Encoding::iterator::ValuesIter;
+
+        quality_filtered_compact_encoding const* ptr;
+        Encoding::iterator iter;
+        ValuesIter         first;          // first value of the current k-mer
+        size_t             lowQualities{}; // positions below min_quality in the window
+        uint64_t           errors{};       // sum of error probabilities in the window (fixed point)
+        uint64_t           maxErrors;      // filter.max_expected_errors (fixed point)
+
+        iterator(quality_filtered_compact_encoding const& encoding)
+            : ptr{&encoding}
+            , iter{begin(ptr->encoding)}
+            , maxErrors{fixed_point_errors(ptr->filter.max_expected_errors)}
+        {
+            if (iter == nullptr) return;
+            for (size_t i{0}; i < ptr->k; ++i) {
+                add(ptr->qualities[i]);
+            }
+            skip();
+        }
+
+        auto operator*() const -> size_t {
+            return *iter;
+        }
+
+        /*! \brief Position of the first value of the current k-mer
+         */
+        auto position() const -> size_t {
+            return iter.position();
+        }
+
+        /*! \brief Iterator to the first value of the current k-mer
+         */
+        auto kmer() const -> ValuesIter {
+            return first;
+        }
+
+        auto operator++() -> iterator& {
+            next();
+            skip();
+            return *this;
+        }
+
+        bool operator==(std::nullptr_t) const {
+            return iter == nullptr;
+        }
+
+    private:
+        void add(uint8_t q) {
+            lowQualities += q < ptr->filter.min_quality;
+            errors       += probabilities[q];
+        }
+        void remove(uint8_t q) {
+            lowQualities -= q < ptr->filter.min_quality;
+            errors       -= probabilities[q];
+        }
+        void next() {
+            ++iter;
+            if (iter == nullptr) return;
+            remove(ptr->qualities[iter.pos - ptr->k]);
+            add(ptr->qualities[iter.pos]);
+        }
+        void skip() {
+            while (iter != nullptr and (lowQualities > 0 or errors > maxErrors)) {
+                next();
+            }
+            first = iter.first;
+        }
+    };
+
+    friend auto begin(quality_filtered_compact_encoding const& encoding) -> iterator {
+        return iterator{encoding};
+    }
+    friend auto end(quality_filtered_compact_encoding const&) -> std::nullptr_t {
+        return nullptr;
+    }
+};
+
+/*! \brief Winnowing minimizers over the k-mers passing a quality filter
+ *
+ * Windows consist of consecutive k-mers that passed the filter.
+ */
+template <alphabet_c Alphabet, quality_alphabet_c QualityAlphabet, bool DuplicatesAllowed=true, bool UseCanonicalKmers=true>
+using quality_filtered_winnowing_minimizer = winnowing_minimizer<Alphabet, DuplicatesAllowed, UseCanonicalKmers, std::span<uint8_t const>,
+                                                                 quality_filtered_compact_encoding<Alphabet, QualityAlphabet, UseCanonicalKmers>>;
+
+}
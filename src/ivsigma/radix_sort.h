@@ -0,0 +1,157 @@
+// SPDX-FileCopyrightText: 2006-2023, Knut Reinert & Freie Universität Berlin
+// SPDX-FileCopyrightText: 2016-2023, Knut Reinert & MPI für molekulare Genetik
+// SPDX-License-Identifier: BSD-3-Clause
+#pragma once
+
+#include "kmer_counter.h"
+
+#include <algorithm>
+#include <array>
+#include <barrier>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <span>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+namespace ivs::detail {
+
+/**
+ * Parallel LSD radix sort with 11bit digits, the histograms of a thread (16KiB) stay in the L1 cache.
+ * Each thread owns a contiguous part of the input, computes a histogram of its part
+ * and scatters its part to offsets derived from the histograms of all threads, keeping the sort stable.
+ * Digits that are equal for all keys are skipped, e.g. the unused high bits of compact encodings
+ * of short k-mers, so e.g. 21-mers of dna4 (42 bits) need 4 passes.
+ */
+template <typename T, typename Key>
+void radix_sort(std::span<T> values, Key const& key, size_t threads) {
+    static_assert(std::is_default_constructible_v<T> and std::is_copy_assignable_v<T>);
+    static constexpr size_t digit_bits = 11;
+    static constexpr size_t digits     = size_t{1} << digit_bits;
+
+    auto n = values.size();
+    if (n < digits) {
+        std::ranges::stable_sort(values, std::less{}, key);
+        return;
+    }
+    // at least 64k values per thread, otherwise thread creation dominates
+    threads = std::clamp<size_t>(n >> 16, 1, std::max<size_t>(threads, 1));
+
+    auto buffer  = std::unique_ptr<T[]>(new T[n]);
+    auto hists   = std::vector<std::array<size_t, digits>>(threads);
+    auto orBits  = std::vector<uint64_t>(threads, 0);
+    auto andBits = std::vector<uint64_t>(threads, ~uint64_t{0});
+    auto sync    = std::barrier{static_cast<std::ptrdiff_t>(threads)};
+
+    auto work = [&](size_t t) {
+        auto first = n * t / threads;
+        auto last  = n * (t + 1) / threads;
+        for (auto i{first}; i < last; ++i) {
+            auto k = static_cast<uint64_t>(key(values[i]));
+            orBits[t]  |= k;
+            andBits[t] &= k;
+        }
+        sync.arrive_and_wait();
+        uint64_t o{0}, a{~uint64_t{0}};
+        for (size_t i{0}; i < threads; ++i) {
+            o |= orBits[i];
+            a &= andBits[i];
+        }
+        auto varying = o ^ a; // bits that are not equal for all keys
+
+        T* src = values.data();
+        T* dst = buffer.get();
+        for (size_t shift{0}; shift < 64; shift += digit_bits) {
+            if (((varying >> shift) & (digits - 1)) == 0) continue;
+
+            auto& hist = hists[t];
+            hist.fill(0);
+            for (auto i{first}; i < last; ++i) {
+                hist[(static_cast<uint64_t>(key(src[i])) >> shift) & (digits - 1)] += 1;
+            }
+            sync.arrive_and_wait();
+
+            auto offsets = std::array<size_t, digits>{};
+            size_t sum{0};
+            for (size_t d{0}; d < digits; ++d) {
+                for (size_t i{0}; i < threads; ++i) {
+                    if (i == t) offsets[d] = sum;
+                    sum += hists[i][d];
+                }
+            }
+            for (auto i{first}; i < last; ++i) {
+                auto d = (static_cast<uint64_t>(key(src[i])) >> shift) & (digits - 1);
+                dst[offsets[d]++] = src[i];
+            }
+            sync.arrive_and_wait();
+            std::swap(src, dst);
+        }
+        if (src != values.data()) {
+            std::copy(src + first, src + last, values.data() + first);
+        }
+    };
+
+    auto pool = std::vector<std::thread>{};
+    for (size_t t{1}; t < threads; ++t) {
+        pool.emplace_back(work, t);
+    }
+    work(0);
+    for (auto& t : pool) {
+        t.join();
+    }
+}
+
+}
+
+namespace ivs {
+
+/*! \brief Sorts k-mers (e.g. values of compact_encoding) via a parallel radix sort
+ *
+ * \param values values to sort
+ * \param threads number of threads, small inputs use fewer threads
+ */
+inline void radix_sort(std::span<uint64_t> values, size_t threads = std::max(1u, std::thread::hardware_concurrency())) {
+    detail::radix_sort(values, std::identity{}, threads);
+}
+
+/*! \brief Stable radix sort of records by a 64bit key, e.g. k-mers with their positions
+ *
+ * \param values records, must be default constructible and copyable
+ * \param key returns the unsigned key of a record
+ * \param threads number of threads, small inputs use fewer threads
+ */
+template <typename T, typename Key>
+    requires std::is_invocable_r_v<uint64_t, Key const&, T const&>
+void radix_sort(std::span<T> values, Key key, size_t threads = std::max(1u, std::thread::hardware_concurrency())) {
+    detail::radix_sort(values, key, threads);
+}
+
+/*! \brief Sorts k-mers and removes duplicates
+ */
+inline void radix_sort_unique(std::vector<uint64_t>& values, size_t threads = std::max(1u, std::thread::hardware_concurrency())) {
+    radix_sort(values, threads);
+    auto [first, last] = std::ranges::unique(values);
+    values.erase(first, last);
+}
+
+/*! \brief Sorts k-mers and counts equal k-mers
+ *
+ * \param values k-mers, sorted afterwards
+ * \return distinct k-mers with their number of occurrences, sorted by k-mer
+ */
+inline auto radix_sort_count(std::span<uint64_t> values, size_t threads = std::max(1u, std::thread::hardware_concurrency())) -> std::vector<kmer_count> {
+    radix_sort(values, threads);
+    auto res = std::vector<kmer_count>{};
+    for (size_t i{0}; i < values.size();) {
+        auto j = i + 1;
+        while (j < values.size() and values[j] == values[i]) ++j;
+        res.push_back({values[i], j - i});
+        i = j;
+    }
+    return res;
+}
+
+}
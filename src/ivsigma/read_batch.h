@@ -0,0 +1,220 @@
+// SPDX-FileCopyrightText: 2006-2023, Knut Reinert & Freie Universität Berlin
+// SPDX-FileCopyrightText: 2016-2023, Knut Reinert & MPI für molekulare Genetik
+// SPDX-License-Identifier: BSD-3-Clause
+#pragma once
+
+#include "compact_encoding.h"
+#include "interval.h"
+#include "qualities.h"
+#include "soft_mask.h"
+#include "utility.h"
+#include "winnowing_minimizer.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace ivs {
+
+/*! \brief Many reads stored as structure of arrays
+ *
+ * Ranks and quality ranks of all reads are stored in two contiguous buffers,
+ * read i occupies [offsets[i], offsets[i+1]) of both. Names are stored in a separate arena.
+ * `clear()` keeps all buffers, so a batch can be reused without further allocations.
+ * All bulk functions accepting a `std::span<uint8_t const>` can be applied to all reads
+ * at once via `ranks` and `qualities`.
+ *
+ * \tparam Alphabet alphabet of the reads, e.g. dna5
+ * \tparam QualityAlphabet alphabet of the qualities
+ */
+template <alphabet_c Alphabet, quality_alphabet_c QualityAlphabet = pthred94>
+struct read_batch {
+    std::vector<uint8_t> ranks;            //!< ranks of all reads
+    std::vector<uint8_t> qualities;        //!< quality ranks of all reads (empty if the reads have no qualities)
+    std::vector<size_t>  offsets{0};       //!< begin of each read in ranks and qualities, and total size at the end
+    std::vector<char>    names;            //!< names of all reads
+    std::vector<size_t>  name_offsets{0};  //!< begin of each name, and total size at the end
+
+    //! A single read of the batch
+    struct read {
+        std::span<uint8_t const> values;
+        std::span<uint8_t const> qualities; //!< empty if the batch has no qualities
+        std::string_view         name;
+    };
+
+    //! Number of reads
+    auto size() const noexcept -> size_t { return offsets.size() - 1; }
+    auto empty() const noexcept -> bool { return size() == 0; }
+
+    //! Number of bases of all reads
+    auto total_length() const noexcept -> size_t { return offsets.back(); }
+
+    auto has_qualities() const noexcept -> bool { return !ranks.empty() and qualities.size() == ranks.size(); }
+
+    /*! \brief Removes all reads, keeps allocated memory
+     */
+    void clear() noexcept {
+        ranks.clear();
+        qualities.clear();
+        offsets.resize(1);
+        names.clear();
+        name_offsets.resize(1);
+    }
+
+    void reserve(size_t reads, size_t bases, size_t nameChars = 0) {
+        ranks.reserve(bases);
+        qualities.reserve(bases);
+        offsets.reserve(reads + 1);
+        names.reserve(nameChars);
+        name_offsets.reserve(reads + 1);
+    }
+
+    /*! \brief Converts and appends a single read
+     *
+     * \param sequence chars of the read, converted via convert_char_to_rank<Alphabet>
+     * \param quality quality chars, converted via decode_phred<QualityAlphabet>
+     *        (must be empty or have same size as sequence, either all or no reads have qualities)
+     * \param name name of the read
+     * Throws std::runtime_error on invalid quality chars, on a quality of different length than the sequence
+     * and on mixing reads with and without qualities; the batch is left unchanged.
+     */
+    void push_back(std::span<char const> sequence, std::span<char const> quality = {}, std::string_view name = {}) {
+        auto begin = ranks.size();
+        if (!quality.empty() and quality.size() != sequence.size()) {
+            throw std::runtime_error{"sequence and quality length differ in read " + std::string{name}};
+        }
+        if (quality.empty() ? (!sequence.empty() and !qualities.empty()) : qualities.size() != begin) {
+            throw std::runtime_error{"reads with and without qualities mixed at read " + std::string{name}};
+        }
+        ranks.resize(begin + sequence.size());
+        convert_char_to_rank<Alphabet>(sequence, std::span{ranks}.subspan(begin));
+        if (!quality.empty()) {
+            qualities.resize(ranks.size());
+            if (!decode_phred<QualityAlphabet>(quality, std::span{qualities}.subspan(begin))) {
+                ranks.resize(begin);
+                qualities.resize(begin);
+                throw std::runtime_error{"invalid quality char in read " + std::string{name}};
+            }
+        }
+        offsets.push_back(ranks.size());
+        names.insert(names.end(), name.begin(), name.end());
+        name_offsets.push_back(names.size());
+    }
+
+    /*! \brief Replaces the content by converted reads, allocating at most once per buffer
+     *
+     * \param sequences chars of each read
+     * \param qualities_ quality chars of each read (must be empty or have same size as sequences)
+     * \param names_ name of each read (must be empty or have same size as sequences)
+     */
+    void assign(std::span<std::string_view const> sequences, std::span<std::string_view const> qualities_ = {}, std::span<std::string_view const> names_ = {}) {
+        assert(qualities_.empty() or qualities_.size() == sequences.size());
+        assert(names_.empty() or names_.size() == sequences.size());
+        clear();
+        size_t bases{0}, nameChars{0};
+        for (auto s : sequences) bases += s.size();
+        for (auto n : names_) nameChars += n.size();
+        reserve(sequences.size(), bases, nameChars);
+        for (size_t i{0}; i < sequences.size(); ++i) {
+            push_back(sequences[i],
+                      qualities_.empty() ? std::string_view{} : qualities_[i],
+                      names_.empty()     ? std::string_view{} : names_[i]);
+        }
+    }
+
+    auto sequence(size_t i) const noexcept -> std::span<uint8_t const> {
+        assert(i < size());
+        return std::span{ranks}.subspan(offsets[i], offsets[i+1] - offsets[i]);
+    }
+
+    auto quality(size_t i) const noexcept -> std::span<uint8_t const> {
+        assert(i < size());
+        if (!has_qualities()) return {};
+        return std::span{qualities}.subspan(offsets[i], offsets[i+1] - offsets[i]);
+    }
+
+    auto name(size_t i) const noexcept -> std::string_view {
+        assert(i < size());
+        return {names.data() + name_offsets[i], name_offsets[i+1] - name_offsets[i]};
+    }
+
+    auto operator[](size_t i) const noexcept -> read {
+        return {sequence(i), quality(i), name(i)};
+    }
+
+    /*! \brief Maps a position of ranks to the read index and the position inside of the read
+     */
+    auto locate(size_t pos) const noexcept -> std::pair<size_t, size_t> {
+        assert(pos < total_length());
+        auto iter = std::ranges::upper_bound(offsets, pos);
+        auto i = static_cast<size_t>(iter - offsets.begin()) - 1;
+        return {i, pos - offsets[i]};
+    }
+
+    /*! \brief Empty intervals at the boundaries of reads, separating the reads for masked_view
+     */
+    auto boundaries() const -> std::vector<interval> {
+        auto res = std::vector<interval>{};
+        res.reserve(size());
+        for (size_t i{1}; i < size(); ++i) {
+            res.push_back({offsets[i], offsets[i]});
+        }
+        return res;
+    }
+
+    /*! \brief K-mers of all reads, k-mers never span two reads
+     *
+     * Positions refer to `ranks`, see `locate`.
+     */
+    template <bool UseCanonicalKmers=true>
+    auto kmers(size_t k, size_t seed = 0) const -> masked_compact_encoding<Alphabet, UseCanonicalKmers> {
+        return {ranks, boundaries(), k, seed};
+    }
+
+    /*! \brief Minimizers of all reads, windows never span two reads
+     *
+     * Positions refer to `ranks`, see `locate`.
+     */
+    template <bool DuplicatesAllowed=true, bool UseCanonicalKmers=true>
+    auto minimizers(size_t k, size_t window, size_t seed = 0) const -> masked_winnowing_minimizer<Alphabet, DuplicatesAllowed, UseCanonicalKmers> {
+        return {ranks, boundaries(), k, window, seed};
+    }
+
+    struct iterator {
+        using value_type      = read;
+        using difference_type = std::ptrdiff_t;
+
+        read_batch const* ptr{};
+        size_t            index{};
+
+        auto operator*() const -> read { return (*ptr)[index]; }
+        auto operator++() -> iterator& { ++index; return *this; }
+        auto operator++(int) -> iterator { auto r = *this; ++index; return r; }
+        friend bool operator==(iterator const&, iterator const&) = default;
+    };
+
+    auto begin() const noexcept -> iterator { return {this, 0}; }
+    auto end() const noexcept -> iterator { return {this, size()}; }
+};
+
+/*! \brief Computes quality statistics of each read of a batch
+ *
+ * \param batch reads with qualities
+ * \param out statistics of each read (must have same size as batch)
+ */
+template <alphabet_c Alphabet, quality_alphabet_c QualityAlphabet>
+void compute_quality_statistics(read_batch<Alphabet, QualityAlphabet> const& batch, std::span<quality_statistics> out) {
+    assert(batch.size() == out.size());
+    for (size_t i{0}; i < batch.size(); ++i) {
+        out[i] = compute_quality_statistics<QualityAlphabet>(batch.quality(i));
+    }
+}
+
+}
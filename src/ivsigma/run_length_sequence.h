@@ -0,0 +1,105 @@
+// SPDX-FileCopyrightText: 2006-2023, Knut Reinert & Freie Universität Berlin
+// SPDX-FileCopyrightText: 2016-2023, Knut Reinert & MPI für molekulare Genetik
+// SPDX-License-Identifier: BSD-3-Clause
+#pragma once
+
+#include "concepts.h"
+
+#include <algorithm>
+#include <cassert>
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <span>
+#include <vector>
+
+namespace ivs {
+
+/*! \brief Run length encoded ranks
+ *
+ * Stores one rank and the end position of each run of equal ranks.
+ * Well suited for binned qualities, which often consist of long runs.
+ * Random access requires a binary search over the runs.
+ *
+ * \tparam Alphabet describes the used alphabet
+ * \tparam Position type of the stored end positions, limits the length of the sequence
+ */
+template <alphabet_c Alphabet, std::unsigned_integral Position = uint32_t>
+struct run_length_sequence {
+    std::vector<uint8_t>  ranks; //!< rank of each run
+    std::vector<Position> ends;  //!< end position (exclusive) of each run
+
+    run_length_sequence() = default;
+
+    /*! \brief Encodes a rank sequence
+     */
+    run_length_sequence(std::span<uint8_t const> in) {
+        append(in);
+    }
+
+    auto size() const noexcept -> size_t { return ends.empty() ? 0 : ends.back(); }
+    auto empty() const noexcept -> bool { return ends.empty(); }
+
+    //! Number of runs
+    auto runs() const noexcept -> size_t { return ranks.size(); }
+
+    /*! \brief Appends ranks to the end
+     */
+    void append(std::span<uint8_t const> in) {
+        assert(size() + in.size() <= std::numeric_limits<Position>::max());
+        auto pos = size();
+        for (auto r : in) {
+            pos += 1;
+            if (!ranks.empty() and ranks.back() == r) {
+                ends.back() = static_cast<Position>(pos);
+            } else {
+                ranks.push_back(r);
+                ends.push_back(static_cast<Position>(pos));
+            }
+        }
+    }
+
+    void push_back(uint8_t r) {
+        append(std::span{&r, 1});
+    }
+
+    void clear() noexcept {
+        ranks.clear();
+        ends.clear();
+    }
+
+    auto operator[](size_t i) const noexcept -> uint8_t {
+        assert(i < size());
+        auto iter = std::ranges::upper_bound(ends, i);
+        return ranks[iter - ends.begin()];
+    }
+
+    /*! \brief Unpacks ranks starting at position offset
+     *
+     * \param offset first position to unpack
+     * \param out unpacked ranks (offset + out.size() must not exceed size())
+     */
+    void unpack(size_t offset, std::span<uint8_t> out) const noexcept {
+        assert(offset + out.size() <= size());
+        auto run = static_cast<size_t>(std::ranges::upper_bound(ends, offset) - ends.begin());
+        size_t i{0};
+        while (i < out.size()) {
+            auto len = std::min<size_t>(ends[run] - offset - i, out.size() - i);
+            std::fill_n(out.begin() + i, len, ranks[run]);
+            i += len;
+            run += 1;
+        }
+    }
+
+    /*! \brief Unpacks all ranks
+     */
+    auto unpack() const -> std::vector<uint8_t> {
+        auto out = std::vector<uint8_t>{};
+        out.resize(size());
+        unpack(0, out);
+        return out;
+    }
+};
+
+}
@@ -0,0 +1,442 @@
+// SPDX-FileCopyrightText: 2006-2023, Knut Reinert & Freie Universität Berlin
+// SPDX-FileCopyrightText: 2016-2023, Knut Reinert & MPI für molekulare Genetik
+// SPDX-License-Identifier: BSD-3-Clause
+#pragma once
+
+#include "compact_encoding.h"
+#include "concepts.h"
+#include "kmer_counter.h"
+#include "read_batch.h"
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cassert>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <istream>
+#include <iterator>
+#include <limits>
+#include <mutex>
+#include <ostream>
+#include <ranges>
+#include <span>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+namespace ivs::detail {
+
+inline constexpr auto minhash_magic      = std::array<char, 8>{'I', 'V', 'S', 'M', 'H', 'S', 'H', '\0'};
+inline constexpr auto frac_minhash_magic = std::array<char, 8>{'I', 'V', 'S', 'F', 'M', 'H', 'S', '\0'};
+inline constexpr auto hyperloglog_magic  = std::array<char, 8>{'I', 'V', 'S', 'H', 'L', 'L', '\0', '\0'};
+
+/**
+ * Sketches are written as: magic (8 bytes), version (u64), the fields of the sketch (u64 each),
+ * the number of values (u64) followed by the values, all little endian.
+ */
+template <typename T>
+void write_sketch(std::ostream& os, std::array<char, 8> const& magic, std::span<uint64_t const> fields, std::span<T const> values) {
+    if constexpr (std::endian::native != std::endian::little) {
+        throw std::runtime_error{"sketches require a little endian machine"};
+    }
+    auto write_u64 = [&](uint64_t v) {
+        os.write(reinterpret_cast<char const*>(&v), sizeof(v));
+    };
+    os.write(magic.data(), magic.size());
+    write_u64(1);
+    for (auto f : fields) write_u64(f);
+    write_u64(values.size());
+    os.write(reinterpret_cast<char const*>(values.data()), static_cast<std::streamsize>(values.size_bytes()));
+    if (!os) throw std::runtime_error{"can not write sketch"};
+}
+
+template <typename T>
+auto read_sketch(std::istream& is, std::array<char, 8> const& magic, std::span<uint64_t> fields) -> std::vector<T> {
+    if constexpr (std::endian::native != std::endian::little) {
+        throw std::runtime_error{"sketches require a little endian machine"};
+    }
+    auto read_u64 = [&]() {
+        uint64_t v{};
+        is.read(reinterpret_cast<char*>(&v), sizeof(v));
+        if (!is) throw std::runtime_error{"truncated sketch"};
+        return v;
+    };
+    auto m = std::array<char, 8>{};
+    is.read(m.data(), m.size());
+    if (!is or m != magic) throw std::runtime_error{"not a sketch of the expected type"};
+    if (read_u64() != 1) throw std::runtime_error{"unsupported sketch version"};
+    for (auto& f : fields) f = read_u64();
+    auto n = read_u64();
+    if (n > (uint64_t{1} << 40)) throw std::runtime_error{"corrupt sketch"};
+    auto values = std::vector<T>(n);
+    is.read(reinterpret_cast<char*>(values.data()), static_cast<std::streamsize>(n * sizeof(T)));
+    if (!is) throw std::runtime_error{"truncated sketch"};
+    return values;
+}
+
+/**
+ * Merges sorted, unique hashes into 'values', keeping at most 'limit' of the smallest hashes.
+ */
+inline void merge_hashes(std::vector<uint64_t>& values, std::span<uint64_t const> hashes, size_t limit) {
+    auto res = std::vector<uint64_t>{};
+    res.reserve(std::min(limit, values.size() + hashes.size()));
+    std::ranges::set_union(values, hashes, std::back_inserter(res));
+    if (res.size() > limit) res.resize(limit);
+    values = std::move(res);
+}
+
+inline void sort_unique(std::vector<uint64_t>& hashes) {
+    std::ranges::sort(hashes);
+    auto [first, last] = std::ranges::unique(hashes);
+    hashes.erase(first, last);
+}
+
+}
+
+namespace ivs {
+
+/*! \brief Bottom-k MinHash sketch: the 'size' smallest hashes of all k-mers
+ *
+ * Inserted values are k-mers (e.g. of compact_encoding), hashed via the same mixer as kmer_count_table.
+ * Sketches of the same k and size can be merged, e.g. sketches built by different threads.
+ */
+struct minhash_sketch {
+    /*!
+     * \param k size of the k-mers, used for distance estimation
+     * \param size maximal number of hashes kept
+     */
+    explicit minhash_sketch(size_t k, size_t size = 1000)
+        : kmerSize{k}
+        , capacity{std::max<size_t>(size, 1)}
+    {}
+
+    auto k() const noexcept -> size_t { return kmerSize; }
+    //! Maximal number of hashes
+    auto size() const noexcept -> size_t { return capacity; }
+    //! Smallest hashes, sorted
+    auto hashes() const noexcept -> std::span<uint64_t const> { return values; }
+
+    void insert(uint64_t kmer) {
+        auto h = detail::mix_kmer(kmer);
+        if (values.size() == capacity and h >= values.back()) return;
+        auto iter = std::ranges::lower_bound(values, h);
+        if (iter != values.end() and *iter == h) return;
+        values.insert(iter, h);
+        if (values.size() > capacity) values.pop_back();
+    }
+
+    /*! \brief Inserts all k-mers of a k-mer view, e.g. a compact_encoding
+     */
+    template <kmer_view_c Kmers>
+    void insert(Kmers const& kmers) {
+        auto buffer = std::vector<uint64_t>{};
+        auto threshold = values.size() == capacity ? values.back() : std::numeric_limits<uint64_t>::max();
+        for (auto kmer : kmers) {
+            auto h = detail::mix_kmer(static_cast<uint64_t>(kmer));
+            if (h >= threshold) continue;
+            buffer.push_back(h);
+            if (buffer.size() == 4 * capacity) {
+                detail::sort_unique(buffer);
+                detail::merge_hashes(values, buffer, capacity);
+                buffer.clear();
+                if (values.size() == capacity) threshold = values.back();
+            }
+        }
+        detail::sort_unique(buffer);
+        detail::merge_hashes(values, buffer, capacity);
+    }
+
+    void merge(minhash_sketch const& other) {
+        assert(other.kmerSize == kmerSize and other.capacity == capacity);
+        detail::merge_hashes(values, other.values, capacity);
+    }
+
+    void clear() noexcept { values.clear(); }
+
+    void write(std::ostream& os) const {
+        auto fields = std::array<uint64_t, 2>{kmerSize, capacity};
+        detail::write_sketch<uint64_t>(os, detail::minhash_magic, fields, values);
+    }
+
+    //! Reads a sketch written by write, throws std::runtime_error on failure
+    static auto read(std::istream& is) -> minhash_sketch {
+        auto fields = std::array<uint64_t, 2>{};
+        auto values = detail::read_sketch<uint64_t>(is, detail::minhash_magic, fields);
+        auto res = minhash_sketch{fields[0], fields[1]};
+        if (values.size() > res.capacity or !std::ranges::is_sorted(values)) throw std::runtime_error{"corrupt sketch"};
+        res.values = std::move(values);
+        return res;
+    }
+
+private:
+    size_t                kmerSize;
+    size_t                capacity;
+    std::vector<uint64_t> values;
+};
+
+/*! \brief FracMinHash sketch: all hashes smaller than 2^64 / scaled
+ *
+ * Keeps about 1/scaled of all distinct k-mers, the size of the sketch grows with the number of distinct k-mers.
+ * In contrast to minhash_sketch, sketches of very different sizes can be compared (containment).
+ */
+struct frac_minhash_sketch {
+    /*!
+     * \param k size of the k-mers, used for ANI estimation
+     * \param scaled keeps one of 'scaled' hashes on average
+     */
+    explicit frac_minhash_sketch(size_t k, size_t scaled = 1000)
+        : kmerSize{k}
+        , scaledBy{std::max<size_t>(scaled, 1)}
+        , threshold{scaledBy == 1 ? std::numeric_limits<uint64_t>::max() : std::numeric_limits<uint64_t>::max() / scaledBy}
+    {}
+
+    auto k() const noexcept -> size_t { return kmerSize; }
+    auto scaled() const noexcept -> size_t { return scaledBy; }
+    //! Kept hashes, sorted
+    auto hashes() const noexcept -> std::span<uint64_t const> { return values; }
+    //! Estimated number of distinct k-mers
+    auto cardinality() const noexcept -> double { return static_cast<double>(values.size()) * static_cast<double>(scaledBy); }
+
+    void insert(uint64_t kmer) {
+        auto h = detail::mix_kmer(kmer);
+        if (h > threshold) return;
+        auto iter = std::ranges::lower_bound(values, h);
+        if (iter == values.end() or *iter != h) values.insert(iter, h);
+    }
+
+    /*! \brief Inserts all k-mers of a k-mer view, e.g. a compact_encoding
+     */
+    template <kmer_view_c Kmers>
+    void insert(Kmers const& kmers) {
+        auto buffer = std::vector<uint64_t>{};
+        for (auto kmer : kmers) {
+            auto h = detail::mix_kmer(static_cast<uint64_t>(kmer));
+            if (h <= threshold) buffer.push_back(h);
+        }
+        detail::sort_unique(buffer);
+        detail::merge_hashes(values, buffer, std::numeric_limits<size_t>::max());
+    }
+
+    void merge(frac_minhash_sketch const& other) {
+        assert(other.kmerSize == kmerSize and other.scaledBy == scaledBy);
+        detail::merge_hashes(values, other.values, std::numeric_limits<size_t>::max());
+    }
+
+    void clear() noexcept { values.clear(); }
+
+    void write(std::ostream& os) const {
+        auto fields = std::array<uint64_t, 2>{kmerSize, scaledBy};
+        detail::write_sketch<uint64_t>(os, detail::frac_minhash_magic, fields, values);
+    }
+
+    //! Reads a sketch written by write, throws std::runtime_error on failure
+    static auto read(std::istream& is) -> frac_minhash_sketch {
+        auto fields = std::array<uint64_t, 2>{};
+        auto values = detail::read_sketch<uint64_t>(is, detail::frac_minhash_magic, fields);
+        auto res = frac_minhash_sketch{fields[0], fields[1]};
+        if (!std::ranges::is_sorted(values) or (!values.empty() and values.back() > res.threshold)) throw std::runtime_error{"corrupt sketch"};
+        res.values = std::move(values);
+        return res;
+    }
+
+private:
+    size_t                kmerSize;
+    size_t                scaledBy;
+    uint64_t              threshold;
+    std::vector<uint64_t> values;
+};
+
+/*! \brief HyperLogLog, estimates the number of distinct k-mers in 2^precision bytes
+ *
+ * The relative standard error is about 1.04 / sqrt(2^precision), e.g. 1.6% for the default precision 12.
+ */
+struct hyperloglog {
+    /*!
+     * \param precision number of hash bits selecting a register (4 to 18)
+     */
+    explicit hyperloglog(size_t precision = 12)
+        : bits{precision}
+        , registers(size_t{1} << precision)
+    {
+        assert(precision >= 4 and precision <= 18);
+    }
+
+    auto precision() const noexcept -> size_t { return bits; }
+
+    void insert(uint64_t kmer) noexcept {
+        auto h    = detail::mix_kmer(kmer);
+        auto idx  = h >> (64 - bits);
+        auto rank = static_cast<uint8_t>(std::countl_zero((h << bits) | (uint64_t{1} << (bits - 1))) + 1);
+        registers[idx] = std::max(registers[idx], rank);
+    }
+
+    /*! \brief Inserts all k-mers of a k-mer view, e.g. a compact_encoding
+     */
+    template <kmer_view_c Kmers>
+    void insert(Kmers const& kmers) {
+        for (auto kmer : kmers) {
+            insert(static_cast<uint64_t>(kmer));
+        }
+    }
+
+    void merge(hyperloglog const& other) noexcept {
+        assert(other.bits == bits);
+        for (size_t i{0}; i < registers.size(); ++i) {
+            registers[i] = std::max(registers[i], other.registers[i]);
+        }
+    }
+
+    void clear() noexcept { std::ranges::fill(registers, uint8_t{0}); }
+
+    //! Estimated number of distinct k-mers
+    auto cardinality() const noexcept -> double {
+        auto m = static_cast<double>(registers.size());
+        double sum{0.};
+        size_t zeros{0};
+        for (auto r : registers) {
+            sum   += std::ldexp(1., -static_cast<int>(r));
+            zeros += (r == 0);
+        }
+        auto alpha    = 0.7213 / (1. + 1.079 / m);
+        auto estimate = alpha * m * m / sum;
+        if (estimate <= 2.5 * m and zeros > 0) { // small range correction: linear counting
+            return m * std::log(m / static_cast<double>(zeros));
+        }
+        return estimate;
+    }
+
+    void write(std::ostream& os) const {
+        auto fields = std::array<uint64_t, 1>{bits};
+        detail::write_sketch<uint8_t>(os, detail::hyperloglog_magic, fields, registers);
+    }
+
+    //! Reads a sketch written by write, throws std::runtime_error on failure
+    static auto read(std::istream& is) -> hyperloglog {
+        auto fields    = std::array<uint64_t, 1>{};
+        auto registers = detail::read_sketch<uint8_t>(is, detail::hyperloglog_magic, fields);
+        if (fields[0] < 4 or fields[0] > 18 or registers.size() != (size_t{1} << fields[0])) throw std::runtime_error{"corrupt sketch"};
+        auto res = hyperloglog{fields[0]};
+        res.registers = std::move(registers);
+        return res;
+    }
+
+private:
+    size_t               bits;
+    std::vector<uint8_t> registers;
+};
+
+/*! \brief Estimated Jaccard index of the k-mer sets of two MinHash sketches
+ *
+ * Compares the smallest hashes of the union of both sketches, sketches must have the same k and size.
+ */
+inline auto jaccard(minhash_sketch const& a, minhash_sketch const& b) -> double {
+    assert(a.k() == b.k() and a.size() == b.size());
+    auto ha = a.hashes();
+    auto hb = b.hashes();
+    size_t i{0}, j{0}, n{0}, shared{0};
+    while (n < a.size() and i < ha.size() and j < hb.size()) {
+        if (ha[i] == hb[j]) {
+            shared += 1;
+            ++i;
+            ++j;
+        } else if (ha[i] < hb[j]) {
+            ++i;
+        } else {
+            ++j;
+        }
+        ++n;
+    }
+    n += std::min(a.size() - n, (ha.size() - i) + (hb.size() - j));
+    return n == 0 ? 0. : static_cast<double>(shared) / static_cast<double>(n);
+}
+
+/*! \brief Mash distance, an estimate of the mutation rate from the Jaccard index of k-mers
+ */
+inline auto mash_distance(double jaccard, size_t k) -> double {
+    if (jaccard <= 0.) return 1.;
+    return std::min(1., -std::log(2. * jaccard / (1. + jaccard)) / static_cast<double>(k));
+}
+
+//! Number of hashes contained in both sketches
+inline auto intersection(frac_minhash_sketch const& a, frac_minhash_sketch const& b) -> size_t {
+    assert(a.k() == b.k() and a.scaled() == b.scaled());
+    auto ha = a.hashes();
+    auto hb = b.hashes();
+    size_t i{0}, j{0}, shared{0};
+    while (i < ha.size() and j < hb.size()) {
+        shared += (ha[i] == hb[j]);
+        auto va = ha[i];
+        auto vb = hb[j];
+        i += (va <= vb);
+        j += (vb <= va);
+    }
+    return shared;
+}
+
+/*! \brief Estimated Jaccard index of the k-mer sets of two FracMinHash sketches
+ */
+inline auto jaccard(frac_minhash_sketch const& a, frac_minhash_sketch const& b) -> double {
+    auto shared = intersection(a, b);
+    auto total  = a.hashes().size() + b.hashes().size() - shared;
+    return total == 0 ? 0. : static_cast<double>(shared) / static_cast<double>(total);
+}
+
+/*! \brief Estimated fraction of the k-mers of 'a' that are contained in 'b'
+ */
+inline auto containment(frac_minhash_sketch const& a, frac_minhash_sketch const& b) -> double {
+    auto shared = intersection(a, b);
+    return a.hashes().empty() ? 0. : static_cast<double>(shared) / static_cast<double>(a.hashes().size());
+}
+
+/*! \brief Estimated average nucleotide identity of 'a' to 'b', derived from the containment: containment^(1/k)
+ */
+inline auto containment_ani(frac_minhash_sketch const& a, frac_minhash_sketch const& b) -> double {
+    return std::pow(containment(a, b), 1. / static_cast<double>(a.k()));
+}
+
+namespace detail {
+//! Empty sketches with the same parameters, without copying any values
+inline auto empty_sketch(minhash_sketch const& s) -> minhash_sketch { return minhash_sketch{s.k(), s.size()}; }
+inline auto empty_sketch(frac_minhash_sketch const& s) -> frac_minhash_sketch { return frac_minhash_sketch{s.k(), s.scaled()}; }
+inline auto empty_sketch(hyperloglog const& s) -> hyperloglog { return hyperloglog{s.precision()}; }
+}
+
+/*! \brief Inserts the k-mers of many sequences into a sketch on multiple threads
+ *
+ * Each thread fills its own empty sketch with the parameters of 'sketch' and merges it into 'sketch' once.
+ *
+ * \tparam Alphabet alphabet of the sequences
+ * \param sketch minhash_sketch, frac_minhash_sketch or hyperloglog
+ * \param sequences random access range of rank sequences (e.g. std::vector<std::vector<uint8_t>>)
+ * \param k size of the k-mers
+ * \param threads number of threads
+ */
+template <alphabet_c Alphabet, bool UseCanonicalKmers=true, typename Sketch, std::ranges::random_access_range Sequences>
+void sketch_kmers(Sketch& sketch, Sequences const& sequences, size_t k, size_t threads = std::max(1u, std::thread::hardware_concurrency())) {
+    auto n     = static_cast<size_t>(std::ranges::size(sequences));
+    auto mutex = std::mutex{};
+    detail::parallel_for(n, threads, 64,
+        [&]() { return detail::empty_sketch(sketch); },
+        [&](Sketch& local, size_t first, size_t last) {
+            for (auto i{first}; i < last; ++i) {
+                local.insert(compact_encoding<Alphabet, UseCanonicalKmers>{std::span<uint8_t const>{sequences[i]}, k});
+            }
+        },
+        [&](Sketch const& local) {
+            auto lock = std::lock_guard{mutex};
+            sketch.merge(local);
+        });
+}
+
+/*! \brief Inserts the k-mers of all reads of a batch into a sketch on multiple threads
+ */
+template <alphabet_c Alphabet, bool UseCanonicalKmers=true, typename Sketch, quality_alphabet_c QualityAlphabet>
+void sketch_kmers(Sketch& sketch, read_batch<Alphabet, QualityAlphabet> const& batch, size_t k, size_t threads = std::max(1u, std::thread::hardware_concurrency())) {
+    auto reads = std::views::iota(size_t{0}, batch.size())
+               | std::views::transform([&](size_t i) { return batch.sequence(i); });
+    sketch_kmers<Alphabet, UseCanonicalKmers>(sketch, reads, k, threads);
+}
+
+}
@@ -0,0 +1,285 @@
+// SPDX-FileCopyrightText: 2006-2023, Knut Reinert & Freie Universität Berlin
+// SPDX-FileCopyrightText: 2016-2023, Knut Reinert & MPI für molekulare Genetik
+// SPDX-License-Identifier: BSD-3-Clause
+#pragma once
+
+#include "compact_encoding.h"
+#include "concepts.h"
+#include "interval.h"
+#include "packed_sequence.h"
+#include "winnowing_minimizer.h"
+
+#include <algorithm>
+#include <bit>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <span>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace ivs::detail {
+
+/**
+ * Collects runs of set bits into a list of intervals.
+ * Bits are fed in blocks of up to 64 positions, runs crossing block boundaries are merged.
+ */
+struct soft_mask_collector {
+    std::vector<interval>& out;
+
+    void add(uint64_t bits, size_t offset, size_t length) {
+        size_t i{0};
+        while (i < length) {
+            auto zeros = static_cast<size_t>(std::countr_zero(bits >> i));
+            if (zeros >= length - i) return;
+            i += zeros;
+            auto ones = std::min<size_t>(std::countr_one(bits >> i), length - i);
+            if (!out.empty() and out.back().end == offset + i) {
+                out.back().end += ones;
+            } else {
+                out.push_back({offset + i, offset + i + ones});
+            }
+            i += ones;
+        }
+    }
+};
+
+//! true for 'a'-'z'
+constexpr auto is_soft_masked(char c) noexcept -> bool {
+    return static_cast<uint8_t>(c - 'a') < 26;
+}
+
+/**
+ * Applies 'op(i)' to every position and extracts the soft masked intervals on the way.
+ * The case bits are gathered into a 64bit word per block, intervals are extracted via bit scans.
+ */
+template <typename Op>
+void for_each_soft_masked(std::span<char const> in, std::vector<interval>& masked, Op&& op) {
+    masked.clear();
+    auto collector = soft_mask_collector{masked};
+    size_t i{0};
+    for (; i < in.size(); i += 64) {
+        auto len = std::min<size_t>(64, in.size() - i);
+        uint64_t bits{};
+        for (size_t j{0}; j < len; ++j) {
+            bits |= uint64_t{is_soft_masked(in[i+j])} << j;
+            op(i+j);
+        }
+        collector.add(bits, i, len);
+    }
+}
+
+}
+
+namespace ivs {
+
+/********** Soft masked intervals **********/
+
+/*! \brief Extracts the soft masked (lower case) intervals of a string
+ *
+ * \param in string input
+ * \param masked sorted, non overlapping intervals of lower case letters
+ */
+inline void soft_masked_intervals(std::span<char const> in, std::vector<interval>& masked) {
+    detail::for_each_soft_masked(in, masked, [](size_t) {});
+}
+
+/*! \brief Extracts the soft masked (lower case) intervals of a string
+ *
+ * \param in string input
+ * \return sorted, non overlapping intervals of lower case letters
+ */
+inline auto soft_masked_intervals(std::span<char const> in) -> std::vector<interval> {
+    auto masked = std::vector<interval>{};
+    soft_masked_intervals(in, masked);
+    return masked;
+}
+
+/*! \brief Normalizes chars and extracts the soft masked intervals in a single pass
+ *
+ * \tparam Alphabet describes the used alphabet
+ * \param in string input
+ * \param out normalized string of input (must have same size as in)
+ * \param masked sorted, non overlapping intervals of lower case letters of in
+ */
+template <alphabet_c Alphabet, char Unknown = '\0'>
+void normalize_char_soft_masked(std::span<char const> in, std::span<char> out, std::vector<interval>& masked) {
+    assert(in.size() == out.size());
+    detail::for_each_soft_masked(in, masked, [&](size_t i) {
+        out[i] = Alphabet::template normalize_char<Unknown>(in[i]);
+    });
+}
+
+/*! \brief Normalizes chars and extracts the soft masked intervals in a single pass
+ *
+ * \tparam Alphabet describes the used alphabet
+ * \param in string input
+ * \return normalized string and sorted, non overlapping intervals of lower case letters of in
+ */
+template <alphabet_c Alphabet, char Unknown = '\0'>
+auto normalize_char_soft_masked(std::span<char const> in) -> std::pair<std::string, std::vector<interval>> {
+    auto res = std::pair<std::string, std::vector<interval>>{};
+    res.first.resize(in.size());
+    normalize_char_soft_masked<Alphabet, Unknown>(in, res.first, res.second);
+    return res;
+}
+
+/*! \brief Converts a string to ranks and extracts the soft masked intervals in a single pass
+ *
+ * \tparam Alphabet describes the used alphabet
+ * \param in string input
+ * \param out ranks of input (must have same size as in)
+ * \param masked sorted, non overlapping intervals of lower case letters of in
+ */
+template <alphabet_c Alphabet, uint8_t Unknown = 255>
+void convert_char_to_rank_soft_masked(std::span<char const> in, std::span<uint8_t> out, std::vector<interval>& masked) {
+    assert(in.size() == out.size());
+    detail::for_each_soft_masked(in, masked, [&](size_t i) {
+        out[i] = Alphabet::template char_to_rank<Unknown>(in[i]);
+    });
+}
+
+/*! \brief Converts a string to ranks and extracts the soft masked intervals in a single pass
+ *
+ * \tparam Alphabet describes the used alphabet
+ * \param in string input
+ * \return ranks and sorted, non overlapping intervals of lower case letters of in
+ */
+template <alphabet_c Alphabet, uint8_t Unknown = 255>
+auto convert_char_to_rank_soft_masked(std::span<char const> in) -> std::pair<std::vector<uint8_t>, std::vector<interval>> {
+    auto res = std::pair<std::vector<uint8_t>, std::vector<interval>>{};
+    res.first.resize(in.size());
+    convert_char_to_rank_soft_masked<Alphabet, Unknown>(in, res.first, res.second);
+    return res;
+}
+
+/********** K-mers skipping masked intervals **********/
+
+/*! \brief Runs a k-mer view (e.g. compact_encoding) on every unmasked segment of a sequence
+ *
+ * K-mers overlapping a masked interval are skipped, no hashing happens inside of masked intervals.
+ * Windows of minimizers never span a masked interval.
+ *
+ * \tparam View k-mer view constructible via View{values, args...}
+ */
+template <typename View>
+struct masked_view {
+    std::vector<View>   segments;
+    std::vector<size_t> offsets;
+
+    /*!
+     * \param values rank input
+     * \param masked sorted, non overlapping intervals of values that should be skipped
+     * \param args further arguments passed to View (e.g. k, window and seed)
+     */
+    template <typename... Args>
+    masked_view(std::span<uint8_t const> values, std::span<interval const> masked, Args... args) {
+        init(values, masked, args...);
+    }
+
+    /*!
+     * \param values packed rank input, e.g. packed_span (any view providing `size()` and `subspan(offset, count)`)
+     * \param masked sorted, non overlapping intervals of values that should be skipped
+     * \param args further arguments passed to View (e.g. k, window and seed)
+     */
+    template <typename Values, typename... Args>
+        requires requires(Values const& v) {
+            v.size();
+            v.subspan(0, 0);
+        }
+    masked_view(Values values, std::span<interval const> masked, Args... args) {
+        init(values, masked, args...);
+    }
+
+    auto size() const -> size_t {
+        size_t s{0};
+        for (auto const& v : segments) {
+            s += v.size();
+        }
+        return s;
+    }
+
+private:
+    template <typename Values, typename... Args>
+    void init(Values values, std::span<interval const> masked, Args... args) {
+        size_t pos{0};
+        auto addSegment = [&](size_t end) {
+            if (pos < end) {
+                segments.emplace_back(values.subspan(pos, end - pos), args...);
+                offsets.push_back(pos);
+            }
+        };
+        for (auto const& m : masked) {
+            assert(m.begin >= pos);
+            assert(m.end <= values.size());
+            addSegment(m.begin);
+            pos = m.end;
+        }
+        addSegment(values.size());
+    }
+
+public:
+    struct iterator {
+        masked_view const* ptr;
+        size_t segment{};
+        std::optional<typename View::iterator> iter;
+
+        iterator(masked_view const& view)
+            : ptr{&view}
+        {
+            nextSegment();
+        }
+
+        auto operator*() const {
+            return **iter;
+        }
+
+        /*! \brief Position of the first value of the current k-mer in the input
+         */
+        auto position() const -> size_t {
+            return ptr->offsets[segment] + iter->position();
+        }
+
+        auto operator++() -> iterator& {
+            ++*iter;
+            if (*iter == nullptr) {
+                segment += 1;
+                nextSegment();
+            }
+            return *this;
+        }
+
+        bool operator==(std::nullptr_t) const {
+            return segment >= ptr->segments.size();
+        }
+
+    private:
+        void nextSegment() {
+            for (; segment < ptr->segments.size(); ++segment) {
+                iter.emplace(begin(ptr->segments[segment]));
+                if (*iter != nullptr) return;
+            }
+        }
+    };
+
+    friend auto begin(masked_view const& view) -> iterator {
+        return iterator{view};
+    }
+    friend auto end(masked_view const&) -> std::nullptr_t {
+        return nullptr;
+    }
+};
+
+/*! \brief compact_encoding skipping k-mers that overlap masked intervals
+ */
+template <alphabet_c Alphabet, bool UseCanonicalKmers=true>
+using masked_compact_encoding = masked_view<compact_encoding<Alphabet, UseCanonicalKmers>>;
+
+/*! \brief winnowing_minimizer skipping k-mers that overlap masked intervals
+ */
+template <alphabet_c Alphabet, bool DuplicatesAllowed=true, bool UseCanonicalKmers=true>
+using masked_winnowing_minimizer = masked_view<winnowing_minimizer<Alphabet, DuplicatesAllowed, UseCanonicalKmers>>;
+
+}
@@ -0,0 +1,299 @@
+// SPDX-FileCopyrightText: 2006-2023, Knut Reinert & Freie Universität Berlin
+// SPDX-FileCopyrightText: 2016-2023, Knut Reinert & MPI für molekulare Genetik
+// SPDX-License-Identifier: BSD-3-Clause
+#pragma once
+
+#include "compact_encoding.h"
+#include "concepts.h"
+#include "fastx_reader.h"
+#include "kmer_counter.h"
+#include "packed_sequence.h"
+#include "read_batch.h"
+#include "winnowing_minimizer.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace ivs::detail {
+
+/**
+ * K-mers of an encoding replaced by a hash of them, so winnowing_minimizer picks minimizers in a random order
+ * instead of the order of the compact encoding (which favors low complexity m-mers like AAAA).
+ */
+template <typename Encoding>
+struct hashed_kmers {
+    Encoding encoding;
+    uint64_t seed{};
+
+    auto size() const -> size_t {
+        return encoding.size();
+    }
+
+    struct iterator {
+        using ValuesIter = Encoding::iterator::ValuesIter;
+
+        Encoding::iterator iter;
+        uint64_t           seed;
+
+        auto operator*() const -> size_t {
+            return mix_kmer(*iter ^ seed);
+        }
+        auto position() const -> size_t {
+            return iter.position();
+        }
+        auto kmer() const -> ValuesIter {
+            return iter.kmer();
+        }
+        auto operator++() -> iterator& {
+            ++iter;
+            return *this;
+        }
+        bool operator==(std::nullptr_t) const {
+            return iter == nullptr;
+        }
+    };
+
+    friend auto begin(hashed_kmers const& h) -> iterator {
+        return iterator{begin(h.encoding), h.seed};
+    }
+    friend auto end(hashed_kmers const&) -> std::nullptr_t {
+        return nullptr;
+    }
+};
+
+}
+
+namespace ivs {
+
+//! Order of m-mers when selecting minimizers
+enum class minimizer_order {
+    lexicographic, //!< order of the compact encoding, as winnowing_minimizer
+    hashed,        //!< order of a hash of the m-mers, balances buckets and gives longer super-k-mers
+};
+
+/*! \brief Reads the super-k-mers of a bucket file written by super_kmer_partitioner
+ */
+template <alphabet_c Alphabet>
+struct super_kmer_reader {
+    using Layout = detail::packed_layout<packed_bits<Alphabet>>;
+
+    explicit super_kmer_reader(std::filesystem::path const& path)
+        : file{path}
+    {
+        auto data = file.data();
+        if (data.size() % sizeof(uint64_t) != 0) throw std::runtime_error{"corrupt super-k-mer file " + path.string()};
+        words = {reinterpret_cast<uint64_t const*>(data.data()), data.size() / sizeof(uint64_t)};
+    }
+
+    /*! \brief Reads the next super-k-mer, a view into the mapped file
+     *
+     * \return false at the end of the file
+     */
+    bool next(packed_span<Alphabet>& super_kmer) {
+        if (pos >= words.size()) return false;
+        auto length = static_cast<size_t>(words[pos]);
+        auto n      = Layout::words(length);
+        if (n > words.size() - pos - 1) throw std::runtime_error{"truncated super-k-mer file"};
+        super_kmer = {words.subspan(pos + 1, n), length};
+        pos += 1 + n;
+        return true;
+    }
+
+private:
+    mapped_file               file;
+    std::span<uint64_t const> words;
+    size_t                    pos{};
+};
+
+/*! \brief Counts all k-mers of a bucket file
+ *
+ * \param table k-mers are added to this table
+ * \param bucket file written by super_kmer_partitioner
+ * \param k size of the k-mers, as used by the partitioner
+ */
+template <alphabet_c Alphabet, bool UseCanonicalKmers=true>
+void count_super_kmers(kmer_count_table& table, std::filesystem::path const& bucket, size_t k) {
+    auto reader = super_kmer_reader<Alphabet>{bucket};
+    auto ranks  = std::vector<uint8_t>{};
+    auto kmers  = std::vector<uint64_t>{};
+    for (auto super_kmer = packed_span<Alphabet>{}; reader.next(super_kmer);) {
+        ranks.resize(super_kmer.size());
+        super_kmer.unpack(0, ranks);
+        for (auto kmer : compact_encoding<Alphabet, UseCanonicalKmers>{ranks, k}) {
+            kmers.push_back(kmer);
+        }
+        if (kmers.size() >= 4096) {
+            table.insert(kmers);
+            kmers.clear();
+        }
+    }
+    table.insert(kmers);
+}
+
+/*! \brief Splits sequences into super-k-mers and writes them into bucket files
+ *
+ * A super-k-mer is a maximal run of consecutive k-mers sharing the same minimizer (the smallest m-mer of each k-mer,
+ * computed via winnowing_minimizer, by default in a hashed order). Super-k-mers are assigned to a bucket by their minimizer,
+ * all occurrences of a k-mer end up in the same bucket, so buckets can be counted one after another
+ * in memory bounded by the largest bucket (see count_buckets).
+ *
+ * Each bucket is a file of records, consisting of the number of ranks (64bit) followed by
+ * the ranks packed as by packed_sequence. Records are buffered per bucket.
+ * A partitioner must not be used by multiple threads at the same time.
+ *
+ * \tparam Alphabet alphabet of the sequences
+ */
+template <alphabet_c Alphabet, bool UseCanonicalKmers=true>
+struct super_kmer_partitioner {
+    using Layout = detail::packed_layout<packed_bits<Alphabet>>;
+
+    size_t const          k;
+    size_t const          m;
+    minimizer_order const order;
+    uint64_t const        seed;
+
+    /*!
+     * \param directory existing directory, receives the files bucket_0.skm ... bucket_{buckets-1}.skm
+     * \param buckets number of bucket files
+     * \param _k size of the k-mers
+     * \param _m size of the minimizers (must be smaller or equal to k)
+     * \param buffer_size bytes buffered per bucket before writing
+     * \param _order order of the m-mers, the default hashed order avoids oversized buckets of low complexity m-mers
+     * \param _seed seed of the order, e.g. to partition the same data differently
+     */
+    super_kmer_partitioner(std::filesystem::path const& directory, size_t buckets, size_t _k, size_t _m, size_t buffer_size = size_t{1} << 16,
+                           minimizer_order _order = minimizer_order::hashed, uint64_t _seed = 0)
+        : k{_k}
+        , m{_m}
+        , order{_order}
+        , seed{_seed}
+        , bufferWords{std::max<size_t>(buffer_size / sizeof(uint64_t), 64)}
+    {
+        assert(buckets > 0);
+        assert(m > 0 and m <= k);
+        for (size_t i{0}; i < buckets; ++i) {
+            auto path = directory / ("bucket_" + std::to_string(i) + ".skm");
+            auto& b = this->buckets.emplace_back(path);
+            b.file.open(path, std::ios::binary | std::ios::trunc);
+            if (!b.file) throw std::runtime_error{"can not open " + path.string()};
+        }
+    }
+
+    super_kmer_partitioner(super_kmer_partitioner const&) = delete;
+    auto operator=(super_kmer_partitioner const&) -> super_kmer_partitioner& = delete;
+
+    ~super_kmer_partitioner() {
+        for (auto& b : buckets) {
+            b.file.write(reinterpret_cast<char const*>(b.buffer.data()), static_cast<std::streamsize>(b.buffer.size() * sizeof(uint64_t)));
+        }
+    }
+
+    //! Number of buckets
+    auto size() const noexcept -> size_t { return buckets.size(); }
+
+    auto bucket_path(size_t i) const -> std::filesystem::path const& { return buckets[i].path; }
+
+    //! Number of k-mers written to bucket i
+    auto bucket_kmers(size_t i) const -> size_t { return buckets[i].kmers; }
+
+    /*! \brief Splits a sequence into super-k-mers and appends them to their buckets
+     *
+     * \param ranks ranks of Alphabet
+     */
+    void add(std::span<uint8_t const> ranks) {
+        if (ranks.size() < k) return;
+        using Encoding = compact_encoding<Alphabet, UseCanonicalKmers>;
+        if (order == minimizer_order::hashed) {
+            using Hashed = detail::hashed_kmers<Encoding>;
+            add(ranks, winnowing_minimizer<Alphabet, true, UseCanonicalKmers, std::span<uint8_t const>, Hashed>{Hashed{Encoding{ranks, m}, seed}, k - m + 1});
+        } else {
+            add(ranks, winnowing_minimizer<Alphabet, true, UseCanonicalKmers>{ranks, m, k - m + 1, seed});
+        }
+    }
+
+    /*! \brief Adds all reads of a batch
+     */
+    template <quality_alphabet_c QualityAlphabet>
+    void add(read_batch<Alphabet, QualityAlphabet> const& batch) {
+        for (size_t i{0}; i < batch.size(); ++i) {
+            add(batch.sequence(i));
+        }
+    }
+
+    /*! \brief Writes all buffered super-k-mers, throws std::runtime_error on failure
+     */
+    void flush() {
+        for (auto& b : buckets) {
+            b.file.write(reinterpret_cast<char const*>(b.buffer.data()), static_cast<std::streamsize>(b.buffer.size() * sizeof(uint64_t)));
+            b.file.flush();
+            b.buffer.clear();
+            if (!b.file) throw std::runtime_error{"can not write " + b.path.string()};
+        }
+    }
+
+    /*! \brief Counts the k-mers of one bucket after another
+     *
+     * Flushes all buckets, counts each bucket in its own kmer_count_table and calls 'f(table)'.
+     * Every k-mer occurs in exactly one bucket, the results of all buckets can simply be concatenated.
+     */
+    template <typename F>
+    void count_buckets(F&& f) {
+        flush();
+        for (size_t i{0}; i < buckets.size(); ++i) {
+            auto table = kmer_count_table{buckets[i].kmers};
+            count_super_kmers<Alphabet, UseCanonicalKmers>(table, buckets[i].path, k);
+            f(static_cast<kmer_count_table const&>(table));
+        }
+    }
+
+private:
+    template <typename Minimizers>
+    void add(std::span<uint8_t const> ranks, Minimizers const& minimizers) {
+        auto window = k - m + 1;
+        auto iter   = begin(minimizers);
+        if (iter == end(minimizers)) return;
+
+        size_t first{0};  // index of the first k-mer of the current super-k-mer
+        auto minimizer = *iter;
+        for (++iter; iter != end(minimizers); ++iter) {
+            auto start = iter.pos + 1 - window; // first k-mer of the new minimizer
+            write(minimizer, ranks.subspan(first, start - first + k - 1));
+            first     = start;
+            minimizer = *iter;
+        }
+        write(minimizer, ranks.subspan(first));
+    }
+
+    struct bucket {
+        std::filesystem::path path;
+        std::ofstream         file{};
+        std::vector<uint64_t> buffer{};
+        size_t                kmers{};
+    };
+    size_t              bufferWords;
+    std::vector<bucket> buckets;
+
+    void write(uint64_t minimizer, std::span<uint8_t const> ranks) {
+        auto& b = buckets[detail::mix_kmer(minimizer) % buckets.size()];
+        b.kmers += ranks.size() - k + 1;
+        auto pos = b.buffer.size();
+        b.buffer.resize(pos + 1 + Layout::words(ranks.size()));
+        b.buffer[pos] = ranks.size();
+        Layout::pack(ranks, b.buffer.data() + pos + 1);
+        if (b.buffer.size() >= bufferWords) {
+            b.file.write(reinterpret_cast<char const*>(b.buffer.data()), static_cast<std::streamsize>(b.buffer.size() * sizeof(uint64_t)));
+            b.buffer.clear();
+            if (!b.file) throw std::runtime_error{"can not write " + b.path.string()};
+        }
+    }
+};
+
+}
@@ -0,0 +1,234 @@
+// SPDX-FileCopyrightText: 2006-2023, Knut Reinert & Freie Universität Berlin
+// SPDX-FileCopyrightText: 2016-2023, Knut Reinert & MPI für molekulare Genetik
+// SPDX-License-Identifier: BSD-3-Clause
+#pragma once
+
+#include "aminoacids.h"
+#include "nucliotides.h"
+
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <string_view>
+#include <vector>
+
+namespace ivs {
+
+/*! \brief Genetic codes as numbered by the NCBI
+ */
+enum class genetic_code : uint8_t {
+    standard                           =  1,
+    vertebrate_mitochondrial           =  2,
+    yeast_mitochondrial                =  3,
+    mold_mitochondrial                 =  4,
+    invertebrate_mitochondrial         =  5,
+    ciliate                            =  6,
+    echinoderm_mitochondrial           =  9,
+    euplotid                           = 10,
+    bacterial                          = 11,
+    alternative_yeast                  = 12,
+    ascidian_mitochondrial             = 13,
+    alternative_flatworm_mitochondrial = 14,
+    chlorophycean_mitochondrial        = 16,
+    trematode_mitochondrial            = 21,
+    scenedesmus_obliquus_mitochondrial = 22,
+    thraustochytrium_mitochondrial     = 23,
+    rhabdopleuridae_mitochondrial      = 24,
+    candidate_division_sr1             = 25,
+    pachysolen_tannophilus             = 26,
+    mesodinium                         = 29,
+    peritrich                          = 30,
+    cephalodiscidae_mitochondrial      = 33,
+};
+
+}
+
+namespace ivs::detail {
+
+/*! \brief Amino acids of all 64 codons, in NCBI order (TCAG for each codon position)
+ */
+constexpr auto genetic_code_amino_acids(genetic_code code) -> std::string_view {
+    switch (code) {
+    case genetic_code::standard:
+    case genetic_code::bacterial:                          return "FFLLSSSSYY**CC*WLLLLPPPPHHQQRRRRIIIMTTTTNNKKSSRRVVVVAAAADDEEGGGG";
+    case genetic_code::vertebrate_mitochondrial:           return "FFLLSSSSYY**CCWWLLLLPPPPHHQQRRRRIIMMTTTTNNKKSS**VVVVAAAADDEEGGGG";
+    case genetic_code::yeast_mitochondrial:                return "FFLLSSSSYY**CCWWTTTTPPPPHHQQRRRRIIMMTTTTNNKKSSRRVVVVAAAADDEEGGGG";
+    case genetic_code::mold_mitochondrial:                 return "FFLLSSSSYY**CCWWLLLLPPPPHHQQRRRRIIIMTTTTNNKKSSRRVVVVAAAADDEEGGGG";
+    case genetic_code::invertebrate_mitochondrial:         return "FFLLSSSSYY**CCWWLLLLPPPPHHQQRRRRIIMMTTTTNNKKSSSSVVVVAAAADDEEGGGG";
+    case genetic_code::ciliate:                            return "FFLLSSSSYYQQCC*WLLLLPPPPHHQQRRRRIIIMTTTTNNKKSSRRVVVVAAAADDEEGGGG";
+    case genetic_code::echinoderm_mitochondrial:           return "FFLLSSSSYY**CCWWLLLLPPPPHHQQRRRRIIIMTTTTNNNKSSSSVVVVAAAADDEEGGGG";
+    case genetic_code::euplotid:                           return "FFLLSSSSYY**CCCWLLLLPPPPHHQQRRRRIIIMTTTTNNKKSSRRVVVVAAAADDEEGGGG";
+    case genetic_code::alternative_yeast:                  return "FFLLSSSSYY**CC*WLLLSPPPPHHQQRRRRIIIMTTTTNNKKSSRRVVVVAAAADDEEGGGG";
+    case genetic_code::ascidian_mitochondrial:             return "FFLLSSSSYY**CCWWLLLLPPPPHHQQRRRRIIMMTTTTNNKKSSGGVVVVAAAADDEEGGGG";
+    case genetic_code::alternative_flatworm_mitochondrial: return "FFLLSSSSYYY*CCWWLLLLPPPPHHQQRRRRIIIMTTTTNNNKSSSSVVVVAAAADDEEGGGG";
+    case genetic_code::chlorophycean_mitochondrial:        return "FFLLSSSSYY*LCC*WLLLLPPPPHHQQRRRRIIIMTTTTNNKKSSRRVVVVAAAADDEEGGGG";
+    case genetic_code::trematode_mitochondrial:            return "FFLLSSSSYY**CCWWLLLLPPPPHHQQRRRRIIMMTTTTNNNKSSSSVVVVAAAADDEEGGGG";
+    case genetic_code::scenedesmus_obliquus_mitochondrial: return "FFLLSS*SYY*LCC*WLLLLPPPPHHQQRRRRIIIMTTTTNNKKSSRRVVVVAAAADDEEGGGG";
+    case genetic_code::thraustochytrium_mitochondrial:     return "FF*LSSSSYY**CC*WLLLLPPPPHHQQRRRRIIIMTTTTNNKKSSRRVVVVAAAADDEEGGGG";
+    case genetic_code::rhabdopleuridae_mitochondrial:      return "FFLLSSSSYY**CCWWLLLLPPPPHHQQRRRRIIIMTTTTNNKKSSSKVVVVAAAADDEEGGGG";
+    case genetic_code::candidate_division_sr1:             return "FFLLSSSSYY**CCGWLLLLPPPPHHQQRRRRIIIMTTTTNNKKSSRRVVVVAAAADDEEGGGG";
+    case genetic_code::pachysolen_tannophilus:             return "FFLLSSSSYY**CC*WLLLAPPPPHHQQRRRRIIIMTTTTNNKKSSRRVVVVAAAADDEEGGGG";
+    case genetic_code::mesodinium:                         return "FFLLSSSSYYYYCC*WLLLLPPPPHHQQRRRRIIIMTTTTNNKKSSRRVVVVAAAADDEEGGGG";
+    case genetic_code::peritrich:                          return "FFLLSSSSYYEECC*WLLLLPPPPHHQQRRRRIIIMTTTTNNKKSSRRVVVVAAAADDEEGGGG";
+    case genetic_code::cephalodiscidae_mitochondrial:      return "FFLLSSSSYYY*CCWWLLLLPPPPHHQQRRRRIIIMTTTTNNKKSSSKVVVVAAAADDEEGGGG";
+    }
+    return {};
+}
+
+/*! \brief Table translating a codon of dna5 ranks into a rank of Alphabet
+ *
+ * The table is indexed by `r1 << 6 | r2 << 3 | r3`, with every rank above 4 clamped to 5
+ * (a slot holding `Unknown`), which avoids any branching. If ReverseComplement is set, the codon is read on the opposite strand,
+ * i.e. the ranks are given in forward direction and the translation of their reverse complement is stored.
+ * Codons containing an `N` translate to `X`, codons containing invalid ranks to `Unknown`.
+ */
+template <alphabet_c Alphabet, genetic_code Code, bool ReverseComplement, uint8_t Unknown>
+constexpr auto codon_table_init() {
+    constexpr auto tcag = std::array<size_t, 4>{2, 1, 3, 0}; // dna4 rank to NCBI order
+    auto aminoacids = genetic_code_amino_acids(Code);
+    auto table = std::array<uint8_t, 512>{};
+    table.fill(Unknown);
+    for (size_t i{0}; i < table.size(); ++i) {
+        auto r = std::array<size_t, 3>{i >> 6, (i >> 3) & 7, i & 7};
+        if (r[0] > 4 or r[1] > 4 or r[2] > 4) continue;
+        if (r[0] == 4 or r[1] == 4 or r[2] == 4) {
+            table[i] = Alphabet::template char_to_rank<Unknown>('X');
+            continue;
+        }
+        if constexpr (ReverseComplement) {
+            r = {3 - r[2], 3 - r[1], 3 - r[0]};
+        }
+        auto c = aminoacids[tcag[r[0]]*16 + tcag[r[1]]*4 + tcag[r[2]]];
+        table[i] = Alphabet::template char_to_rank<Unknown>(c);
+    }
+    return table;
+}
+
+template <alphabet_c Alphabet, genetic_code Code, bool ReverseComplement, uint8_t Unknown>
+constexpr std::array<uint8_t, 512> codon_table{codon_table_init<Alphabet, Code, ReverseComplement, Unknown>()};
+
+constexpr auto codon_index(uint8_t r1, uint8_t r2, uint8_t r3) noexcept -> size_t {
+    // invalid ranks all map to slot 5, masking would alias e.g. rank 8 with A
+    auto clamp = [](uint8_t r) { return std::min<size_t>(r, 5); };
+    return clamp(r1) << 6 | clamp(r2) << 3 | clamp(r3);
+}
+
+}
+
+namespace ivs {
+
+/*! \brief Translates a single codon
+ *
+ * \tparam Alphabet target amino acid alphabet (e.g. aa27, aa20, aa10murphy)
+ * \tparam Code genetic code
+ * \param r1, r2, r3 dna5 (or dna4) ranks of the codon
+ * \return rank of the amino acid
+ */
+template <alphabet_c Alphabet = aa27, genetic_code Code = genetic_code::standard, uint8_t Unknown = 255>
+constexpr auto translate_codon(uint8_t r1, uint8_t r2, uint8_t r3) noexcept -> uint8_t {
+    return detail::codon_table<Alphabet, Code, false, Unknown>[detail::codon_index(r1, r2, r3)];
+}
+
+/*! \brief Number of amino acids of a frame
+ *
+ * \param size number of nucleotides
+ * \param frame offset of the frame (0, 1 or 2)
+ * \return number of complete codons
+ */
+constexpr auto translated_size(size_t size, size_t frame = 0) noexcept -> size_t {
+    if (size < frame) return 0;
+    return (size - frame) / 3;
+}
+
+/*! \brief Translates a dna5 rank sequence into amino acid ranks
+ *
+ * \tparam Alphabet target amino acid alphabet
+ * \tparam Code genetic code
+ * \param in dna5 ranks
+ * \param out amino acid ranks (must have size translated_size(in.size()))
+ */
+template <alphabet_c Alphabet = aa27, genetic_code Code = genetic_code::standard, uint8_t Unknown = 255>
+void translate_rank(std::span<uint8_t const> in, std::span<uint8_t> out) {
+    assert(out.size() == translated_size(in.size()));
+    auto const& table = detail::codon_table<Alphabet, Code, false, Unknown>;
+    for (size_t i{0}; i < out.size(); ++i) {
+        out[i] = table[detail::codon_index(in[i*3], in[i*3+1], in[i*3+2])];
+    }
+}
+
+/*! \brief Translates a dna5 rank sequence into amino acid ranks
+ *
+ * \tparam Alphabet target amino acid alphabet
+ * \tparam Code genetic code
+ * \param in dna5 ranks
+ * \return amino acid ranks
+ */
+template <alphabet_c Alphabet = aa27, genetic_code Code = genetic_code::standard, uint8_t Unknown = 255>
+auto translate_rank(std::span<uint8_t const> in) -> std::vector<uint8_t> {
+    auto out = std::vector<uint8_t>{};
+    out.resize(translated_size(in.size()));
+    translate_rank<Alphabet, Code, Unknown>(in, out);
+    return out;
+}
+
+/*! \brief Translates the reverse complement of a dna5 rank sequence into amino acid ranks
+ *
+ * The reverse complement is never materialized.
+ *
+ * \tparam Alphabet target amino acid alphabet
+ * \tparam Code genetic code
+ * \param in dna5 ranks
+ * \param out amino acid ranks (must have size translated_size(in.size()))
+ */
+template <alphabet_c Alphabet = aa27, genetic_code Code = genetic_code::standard, uint8_t Unknown = 255>
+void translate_reverse_complement_rank(std::span<uint8_t const> in, std::span<uint8_t> out) {
+    assert(out.size() == translated_size(in.size()));
+    auto const& table = detail::codon_table<Alphabet, Code, true, Unknown>;
+    auto n = in.size();
+    for (size_t i{0}; i < out.size(); ++i) {
+        auto s = n - 3 - i*3;
+        out[i] = table[detail::codon_index(in[s], in[s+1], in[s+2])];
+    }
+}
+
+/*! \brief Translates a dna5 rank sequence in all six reading frames
+ *
+ * Frames 0-2 are the forward frames with offset 0, 1 and 2,
+ * frames 3-5 the frames with offset 0, 1 and 2 of the reverse complement.
+ *
+ * \tparam Alphabet target amino acid alphabet
+ * \tparam Code genetic code
+ * \param in dna5 ranks
+ * \param out amino acid ranks per frame (frame f must have size translated_size(in.size(), f%3))
+ */
+template <alphabet_c Alphabet = aa27, genetic_code Code = genetic_code::standard, uint8_t Unknown = 255>
+void translate_rank_six_frame(std::span<uint8_t const> in, std::array<std::span<uint8_t>, 6> out) {
+    for (size_t f{0}; f < 3; ++f) {
+        auto sub = in.subspan(std::min(f, in.size()));
+        translate_rank<Alphabet, Code, Unknown>(sub, out[f]);
+        sub = in.first(in.size() - std::min(f, in.size()));
+        translate_reverse_complement_rank<Alphabet, Code, Unknown>(sub, out[f+3]);
+    }
+}
+
+/*! \brief Translates a dna5 rank sequence in all six reading frames
+ *
+ * \tparam Alphabet target amino acid alphabet
+ * \tparam Code genetic code
+ * \param in dna5 ranks
+ * \return amino acid ranks of all six frames (see above)
+ */
+template <alphabet_c Alphabet = aa27, genetic_code Code = genetic_code::standard, uint8_t Unknown = 255>
+auto translate_rank_six_frame(std::span<uint8_t const> in) -> std::array<std::vector<uint8_t>, 6> {
+    auto out = std::array<std::vector<uint8_t>, 6>{};
+    for (size_t f{0}; f < 6; ++f) {
+        out[f].resize(translated_size(in.size(), f%3));
+    }
+    translate_rank_six_frame<Alphabet, Code, Unknown>(in, {out[0], out[1], out[2], out[3], out[4], out[5]});
+    return out;
+}
+
+}
@@ -0,0 +1,249 @@
+// SPDX-FileCopyrightText: 2006-2023, Knut Reinert & Freie Universität Berlin
+// SPDX-FileCopyrightText: 2016-2023, Knut Reinert & MPI für molekulare Genetik
+// SPDX-License-Identifier: BSD-3-Clause
+#pragma once
+
+#include "interval.h"
+#include "packed_sequence.h"
+
+#include <algorithm>
+#include <bit>
+#include <cassert>
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <span>
+#include <vector>
+
+namespace ivs {
+
+/*! \brief Quality trimming of the 3' end (as used by BWA and cutadapt)
+ *
+ * Removes the suffix that maximizes the sum of (threshold - quality).
+ *
+ * \param qualities quality ranks of a read (e.g. pthred42)
+ * \param threshold quality rank threshold
+ * \return length of the read after trimming
+ */
+inline auto quality_trim_3prime(std::span<uint8_t const> qualities, uint8_t threshold) -> size_t {
+    int64_t sum{0};
+    int64_t max{0};
+    auto end = qualities.size();
+    for (auto i = qualities.size(); i > 0; --i) {
+        sum += static_cast<int64_t>(threshold) - qualities[i-1];
+        if (sum < 0) break;
+        if (sum > max) {
+            max = sum;
+            end = i-1;
+        }
+    }
+    return end;
+}
+
+/*! \brief Quality trimming of the 5' end
+ *
+ * Removes the prefix that maximizes the sum of (threshold - quality).
+ *
+ * \param qualities quality ranks of a read (e.g. pthred42)
+ * \param threshold quality rank threshold
+ * \return first position of the read after trimming
+ */
+inline auto quality_trim_5prime(std::span<uint8_t const> qualities, uint8_t threshold) -> size_t {
+    int64_t sum{0};
+    int64_t max{0};
+    size_t begin{0};
+    for (size_t i{0}; i < qualities.size(); ++i) {
+        sum += static_cast<int64_t>(threshold) - qualities[i];
+        if (sum < 0) break;
+        if (sum > max) {
+            max = sum;
+            begin = i+1;
+        }
+    }
+    return begin;
+}
+
+/*! \brief Trimming of a poly tail, e.g. poly-A or poly-G (as produced by two color chemistry)
+ *
+ * Removes the suffix with the highest score, each match of rank scores +1, each mismatch -2.
+ *
+ * \param values ranks of a read
+ * \param rank rank of the tail
+ * \return length of the read after trimming
+ */
+inline auto poly_tail_trim(std::span<uint8_t const> values, uint8_t rank) -> size_t {
+    int64_t score{0};
+    int64_t max{0};
+    auto end = values.size();
+    for (auto i = values.size(); i > 0; --i) {
+        score += (values[i-1] == rank) ? 1 : -2;
+        if (score < 0) break;
+        if (score > max) {
+            max = score;
+            end = i-1;
+        }
+    }
+    return end;
+}
+
+/*! \brief Searches a 3' adapter in reads
+ *
+ * Finds the leftmost position at which the read matches the adapter, or a prefix of it
+ * if the adapter reaches over the end of the read.
+ * Adapter and reads are packed into 2 bits per base, which allows comparing
+ * 32 bases via a single xor and popcount. Ranks other than 0-3 (e.g. N) always mismatch.
+ */
+struct adapter_finder {
+    using Layout = detail::packed_layout<2>;
+
+    size_t min_overlap{3};       //!< smallest overlap of read and adapter
+    double max_error_rate{0.1};  //!< allowed mismatches per overlapping base
+
+private:
+    size_t                length{};
+    std::vector<uint64_t> words;   // packed adapter
+    std::vector<uint64_t> invalid; // lowest bit of each field of a base that is not in 0-3
+
+    // bit set at the lowest bit of every field
+    static constexpr uint64_t lowBits = 0x5555'5555'5555'5555ull;
+
+    static void pack(std::span<uint8_t const> in, std::vector<uint64_t>& words, std::vector<uint64_t>& invalid) {
+        // one extra word, so chunks can always be read from two consecutive words
+        auto n = Layout::words(in.size()) + 1;
+        words.assign(n, 0);
+        invalid.assign(n, 0);
+        for (size_t i{0}; i < in.size(); ++i) {
+            auto shift = (i % Layout::ranks_per_word) * 2;
+            words[i / Layout::ranks_per_word]   |= uint64_t{in[i] & 3u} << shift;
+            invalid[i / Layout::ranks_per_word] |= uint64_t{in[i] > 3} << shift;
+        }
+    }
+
+    // 32 fields starting at field pos
+    static auto chunk(std::vector<uint64_t> const& words, size_t pos) -> uint64_t {
+        auto w = pos / Layout::ranks_per_word;
+        auto s = (pos % Layout::ranks_per_word) * 2;
+        if (s == 0) return words[w];
+        return (words[w] >> s) | (words[w+1] << (64 - s));
+    }
+
+public:
+    adapter_finder() = default;
+
+    /*!
+     * \param adapter ranks of the adapter (dna4)
+     * \param _min_overlap smallest overlap of read and adapter
+     * \param _max_error_rate allowed mismatches per overlapping base
+     */
+    adapter_finder(std::span<uint8_t const> adapter, size_t _min_overlap = 3, double _max_error_rate = 0.1)
+        : min_overlap{_min_overlap}
+        , max_error_rate{_max_error_rate}
+        , length{adapter.size()}
+    {
+        pack(adapter, words, invalid);
+    }
+
+    /*! \brief Position of the adapter in a read
+     *
+     * \param read ranks of the read (dna4 or dna5)
+     * \return position of the first base of the adapter, or read.size() if the adapter was not found (or is empty)
+     */
+    auto find(std::span<uint8_t const> read) const -> size_t {
+        if (length == 0) return read.size();
+        thread_local std::vector<uint64_t> readWords;
+        thread_local std::vector<uint64_t> readInvalid;
+        pack(read, readWords, readInvalid);
+
+        auto minOverlap = std::max<size_t>(std::min(min_overlap, length), 1);
+        for (size_t p{0}; p + minOverlap <= read.size(); ++p) {
+            auto overlap = std::min(length, read.size() - p);
+            auto allowed = static_cast<size_t>(overlap * max_error_rate);
+            size_t mismatches{0};
+            for (size_t i{0}; i < overlap and mismatches <= allowed; i += Layout::ranks_per_word) {
+                auto x      = chunk(readWords, p + i) ^ chunk(words, i);
+                auto fields = ((x | (x >> 1)) & lowBits) | chunk(readInvalid, p + i) | chunk(invalid, i);
+                auto rest   = overlap - i;
+                if (rest < Layout::ranks_per_word) {
+                    fields &= (uint64_t{1} << (rest * 2)) - 1;
+                }
+                mismatches += std::popcount(fields);
+            }
+            if (mismatches <= allowed) return p;
+        }
+        return read.size();
+    }
+};
+
+/*! \brief Combines quality, adapter and poly tail trimming
+ *
+ * Trimming is applied in this order: quality trimming of both ends, removal of the adapter
+ * and everything behind it and removal of a poly tail. The result is the interval of
+ * the read that should be kept, no data is copied.
+ * Reads without qualities (e.g. from FASTA files) are not quality trimmed.
+ */
+struct read_trimmer {
+    std::optional<uint8_t> quality_threshold_5prime{}; //!< quality rank threshold for the 5' end
+    std::optional<uint8_t> quality_threshold_3prime{}; //!< quality rank threshold for the 3' end
+    std::optional<adapter_finder> adapter{};           //!< 3' adapter
+    std::optional<uint8_t> poly_tail{};                //!< rank of a poly tail, e.g. 0 for poly-A in dna4
+
+    /*! \brief Trims a single read
+     *
+     * \param values ranks of the read (dna4 or dna5)
+     * \param qualities quality ranks of the read (must be empty or have same size as values),
+     *        quality trimming is skipped if empty
+     * \return interval of the read to keep
+     */
+    auto trim(std::span<uint8_t const> values, std::span<uint8_t const> qualities = {}) const -> interval {
+        assert(qualities.empty() or qualities.size() == values.size());
+        auto res = interval{0, values.size()};
+        if (quality_threshold_3prime and !qualities.empty()) {
+            res.end = quality_trim_3prime(qualities, *quality_threshold_3prime);
+        }
+        if (quality_threshold_5prime and !qualities.empty()) {
+            res.begin = std::min(res.end, quality_trim_5prime(qualities.subspan(0, res.end), *quality_threshold_5prime));
+        }
+        if (adapter) {
+            res.end = res.begin + adapter->find(values.subspan(res.begin, res.size()));
+        }
+        if (poly_tail) {
+            res.end = res.begin + poly_tail_trim(values.subspan(res.begin, res.size()), *poly_tail);
+        }
+        return res;
+    }
+
+    /*! \brief Trims a batch of reads
+     *
+     * \param values ranks of each read
+     * \param qualities quality ranks of each read (must be empty or have same size as values),
+     *        if empty no quality trimming is done
+     * \param out interval to keep of each read (must have same size as values)
+     */
+    void trim(std::span<std::span<uint8_t const> const> values, std::span<std::span<uint8_t const> const> qualities, std::span<interval> out) const {
+        assert(values.size() == out.size());
+        assert(qualities.empty() or qualities.size() == values.size());
+        for (size_t i{0}; i < values.size(); ++i) {
+            out[i] = trim(values[i], qualities.empty() ? std::span<uint8_t const>{} : qualities[i]);
+        }
+    }
+
+    /*! \brief Trims all reads of a batch (e.g. a read_batch)
+     *
+     * \param batch reads providing `size()`, `sequence(i)` and `quality(i)`
+     * \param out interval to keep of each read (must have same size as batch)
+     */
+    template <typename Batch>
+        requires requires(Batch const& b) {
+            { b.sequence(0) } -> std::convertible_to<std::span<uint8_t const>>;
+            { b.quality(0) } -> std::convertible_to<std::span<uint8_t const>>;
+        }
+    void trim(Batch const& batch, std::span<interval> out) const {
+        assert(batch.size() == out.size());
+        for (size_t i{0}; i < batch.size(); ++i) {
+            out[i] = trim(batch.sequence(i), batch.quality(i));
+        }
+    }
+};
+
+}
@@ -0,0 +1,370 @@
+// SPDX-FileCopyrightText: 2006-2023, Knut Reinert & Freie Universität Berlin
+// SPDX-FileCopyrightText: 2016-2023, Knut Reinert & MPI für molekulare Genetik
+// SPDX-License-Identifier: BSD-3-Clause
+#pragma once
+
+#include "compact_encoding.h"
+#include "fastx_reader.h"
+#include "interval.h"
+#include "nucliotides.h"
+#include "soft_mask.h"
+#include "winnowing_minimizer.h"
+
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <cctype>
+#include <compare>
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <iterator>
+#include <optional>
+#include <ranges>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace ivs::detail {
+
+/**
+ * Layout of UCSC .2bit files: 4 bases per byte, the first base in the most significant bits,
+ * encoded as T=0, C=1, A=2, G=3.
+ */
+struct twobit_layout {
+    //! dna4 rank of each 2bit code
+    static constexpr std::array<uint8_t, 4> ranks{3, 1, 0, 2};
+
+    //! dna4 ranks of the 4 bases of each byte
+    static constexpr std::array<std::array<uint8_t, 4>, 256> byte_ranks{[]() {
+        auto table = std::array<std::array<uint8_t, 4>, 256>{};
+        for (size_t b{0}; b < 256; ++b) {
+            for (size_t j{0}; j < 4; ++j) {
+                table[b][j] = ranks[(b >> (6 - 2*j)) & 3];
+            }
+        }
+        return table;
+    }()};
+
+    static constexpr auto get(uint8_t const* data, size_t i) noexcept -> uint8_t {
+        return ranks[(data[i / 4] >> (6 - 2 * (i % 4))) & 3];
+    }
+
+    /*! \brief Unpacks dna4 ranks starting at position offset
+     */
+    static void unpack(uint8_t const* data, size_t offset, std::span<uint8_t> out) noexcept {
+        size_t i{0};
+        for (; i < out.size() and (offset + i) % 4 != 0; ++i) {
+            out[i] = get(data, offset + i);
+        }
+        for (; i + 4 <= out.size(); i += 4) {
+            auto const& r = byte_ranks[data[(offset + i) / 4]];
+            std::ranges::copy(r, out.begin() + i);
+        }
+        for (; i < out.size(); ++i) {
+            out[i] = get(data, offset + i);
+        }
+    }
+};
+
+/**
+ * Random access iterator over the dna4 ranks of .2bit data
+ */
+struct twobit_iterator {
+    using value_type        = uint8_t;
+    using difference_type   = std::ptrdiff_t;
+    using iterator_category = std::random_access_iterator_tag;
+
+    uint8_t const* data{};
+    size_t         pos{};
+
+    auto operator*() const -> uint8_t { return twobit_layout::get(data, pos); }
+    auto operator[](difference_type n) const -> uint8_t { return twobit_layout::get(data, pos + n); }
+
+    auto operator++() -> twobit_iterator& { ++pos; return *this; }
+    auto operator--() -> twobit_iterator& { --pos; return *this; }
+    auto operator++(int) -> twobit_iterator { auto r = *this; ++pos; return r; }
+    auto operator--(int) -> twobit_iterator { auto r = *this; --pos; return r; }
+    auto operator+=(difference_type n) -> twobit_iterator& { pos += n; return *this; }
+    auto operator-=(difference_type n) -> twobit_iterator& { pos -= n; return *this; }
+
+    friend auto operator+(twobit_iterator i, difference_type n) -> twobit_iterator { return i += n; }
+    friend auto operator+(difference_type n, twobit_iterator i) -> twobit_iterator { return i += n; }
+    friend auto operator-(twobit_iterator i, difference_type n) -> twobit_iterator { return i -= n; }
+    friend auto operator-(twobit_iterator const& lhs, twobit_iterator const& rhs) -> difference_type {
+        return static_cast<difference_type>(lhs.pos) - static_cast<difference_type>(rhs.pos);
+    }
+
+    friend bool operator==(twobit_iterator const& lhs, twobit_iterator const& rhs) { return lhs.pos == rhs.pos; }
+    friend auto operator<=>(twobit_iterator const& lhs, twobit_iterator const& rhs) { return lhs.pos <=> rhs.pos; }
+};
+
+}
+
+namespace ivs {
+
+/*! \brief A non owning view of the bases of a .2bit sequence as dna4 ranks
+ *
+ * N positions are stored as T in .2bit files, see twobit_sequence::n_blocks.
+ */
+struct twobit_span {
+    using Layout   = detail::twobit_layout;
+    using iterator = detail::twobit_iterator;
+
+    std::span<uint8_t const> bytes;
+    size_t                   length{};
+
+    auto size() const noexcept -> size_t { return length; }
+    auto empty() const noexcept -> bool { return length == 0; }
+
+    auto operator[](size_t i) const noexcept -> uint8_t {
+        assert(i < length);
+        return Layout::get(bytes.data(), i);
+    }
+
+    auto begin() const noexcept -> iterator { return {bytes.data(), 0}; }
+    auto end() const noexcept -> iterator { return {bytes.data(), length}; }
+
+    auto subspan(size_t offset, size_t count) const noexcept {
+        assert(offset + count <= length);
+        return std::ranges::subrange{begin() + offset, begin() + offset + count};
+    }
+
+    /*! \brief Unpacks dna4 ranks starting at position offset
+     */
+    void unpack(size_t offset, std::span<uint8_t> out) const noexcept {
+        assert(offset + out.size() <= length);
+        Layout::unpack(bytes.data(), offset, out);
+    }
+};
+
+//! Range of a .2bit sequence, as consumed by the k-mer engines
+using twobit_subrange = decltype(twobit_span{}.subspan(0, 0));
+
+/*! \brief compact_encoding over a .2bit sequence, skipping N blocks
+ */
+template <bool UseCanonicalKmers=true>
+using twobit_compact_encoding = masked_view<compact_encoding<dna4, UseCanonicalKmers, twobit_subrange>>;
+
+/*! \brief winnowing_minimizer over a .2bit sequence, skipping N blocks
+ */
+template <bool DuplicatesAllowed=true, bool UseCanonicalKmers=true>
+using twobit_winnowing_minimizer = masked_view<winnowing_minimizer<dna4, DuplicatesAllowed, UseCanonicalKmers, twobit_subrange>>;
+
+/*! \brief A single sequence of a .2bit file
+ *
+ * The bases are a view into the file, the N and mask blocks are decoded when the sequence is opened.
+ */
+struct twobit_sequence {
+    std::string_view      name;
+    twobit_span           bases;
+    std::vector<interval> n_blocks;    //!< sorted runs of N
+    std::vector<interval> mask_blocks; //!< sorted soft masked (lower case) regions
+
+    auto size() const noexcept -> size_t { return bases.size(); }
+
+    /*! \brief Extracts a region as dna5 ranks
+     *
+     * \param offset first position of the region
+     * \param out ranks of the region (offset + out.size() must not exceed size())
+     */
+    void extract(size_t offset, std::span<uint8_t> out) const {
+        assert(offset + out.size() <= size());
+        bases.unpack(offset, out);
+        auto last = offset + out.size();
+        auto block = std::ranges::upper_bound(n_blocks, offset, {}, &interval::begin);
+        if (block != n_blocks.begin()) --block;
+        for (; block != n_blocks.end() and block->begin < last; ++block) {
+            auto b = std::max(block->begin, offset);
+            auto e = std::min(block->end, last);
+            if (b < e) {
+                std::fill(out.begin() + (b - offset), out.begin() + (e - offset), uint8_t{4});
+            }
+        }
+    }
+
+    /*! \brief Extracts a region as dna5 ranks
+     */
+    auto extract(size_t offset, size_t length) const -> std::vector<uint8_t> {
+        auto out = std::vector<uint8_t>{};
+        out.resize(length);
+        extract(offset, out);
+        return out;
+    }
+
+    /*! \brief Extracts a region as chars
+     *
+     * \param soft_masked if set, positions inside of mask blocks are reported as lower case chars
+     */
+    auto extract_char(size_t offset, size_t length, bool soft_masked = false) const -> std::string {
+        auto ranks = extract(offset, length);
+        auto out = std::string{};
+        out.resize(length);
+        for (size_t i{0}; i < length; ++i) {
+            out[i] = dna5::rank_to_char(ranks[i]);
+        }
+        if (soft_masked) {
+            auto last  = offset + length;
+            auto block = std::ranges::upper_bound(mask_blocks, offset, {}, &interval::begin);
+            if (block != mask_blocks.begin()) --block;
+            for (; block != mask_blocks.end() and block->begin < last; ++block) {
+                auto b = std::max(block->begin, offset);
+                auto e = std::min(block->end, last);
+                for (auto i = b; i < e; ++i) {
+                    out[i - offset] = static_cast<char>(std::tolower(static_cast<unsigned char>(out[i - offset])));
+                }
+            }
+        }
+        return out;
+    }
+
+    /*! \brief K-mers of all stretches between N blocks, positions refer to this sequence
+     */
+    template <bool UseCanonicalKmers=true>
+    auto kmers(size_t k, size_t seed = 0) const -> twobit_compact_encoding<UseCanonicalKmers> {
+        return {bases, n_blocks, k, seed};
+    }
+
+    /*! \brief Minimizers of all stretches between N blocks, positions refer to this sequence
+     */
+    template <bool DuplicatesAllowed=true, bool UseCanonicalKmers=true>
+    auto minimizers(size_t k, size_t window, size_t seed = 0) const -> twobit_winnowing_minimizer<DuplicatesAllowed, UseCanonicalKmers> {
+        return {bases, n_blocks, k, window, seed};
+    }
+};
+
+/*! \brief Reads UCSC .2bit files via a memory mapping
+ *
+ * Opening reads only the header and the index of sequence names.
+ * Supports version 0 and 1 (64 bit offsets) files of both byte orders.
+ * Throws std::runtime_error on malformed files.
+ */
+struct twobit_file {
+    struct entry {
+        std::string_view name;
+        uint64_t         offset; //!< position of the sequence record in the file
+    };
+
+    std::vector<entry> index;
+
+    explicit twobit_file(std::filesystem::path const& path)
+        : file{path}
+    {
+        parse(file.data());
+    }
+
+    /*! \brief Parses .2bit data in memory, data must outlive the twobit_file
+     */
+    explicit twobit_file(std::span<char const> data) {
+        parse(data);
+    }
+
+    //! Number of sequences
+    auto size() const noexcept -> size_t { return index.size(); }
+
+    /*! \brief Opens the i-th sequence
+     */
+    auto sequence(size_t i) const -> twobit_sequence {
+        assert(i < size());
+        auto p   = index[i].offset;
+        auto res = twobit_sequence{};
+        res.name = index[i].name;
+        auto length = read32(p);
+        p += 4;
+        res.n_blocks    = blocks(p);
+        res.mask_blocks = blocks(p);
+        p += 4; // reserved
+        auto n = (static_cast<size_t>(length) + 3) / 4;
+        check(p, n);
+        res.bases = {bytes.subspan(p, n), length};
+        for (auto const& b : res.n_blocks) {
+            if (b.end > length) throw std::runtime_error{"corrupt 2bit file, N block out of range"};
+        }
+        for (auto const& b : res.mask_blocks) {
+            if (b.end > length) throw std::runtime_error{"corrupt 2bit file, mask block out of range"};
+        }
+        return res;
+    }
+
+    /*! \brief Opens a sequence by name
+     */
+    auto find(std::string_view name) const -> std::optional<twobit_sequence> {
+        for (size_t i{0}; i < index.size(); ++i) {
+            if (index[i].name == name) return sequence(i);
+        }
+        return std::nullopt;
+    }
+
+private:
+    mapped_file              file;
+    std::span<uint8_t const> bytes;
+    bool                     swap{};
+
+    void check(uint64_t p, uint64_t n) const {
+        if (p + n > bytes.size()) throw std::runtime_error{"corrupt 2bit file, unexpected end"};
+    }
+
+    auto read32(uint64_t p) const -> uint32_t {
+        check(p, 4);
+        auto b = bytes.data() + p;
+        if (swap) {
+            return uint32_t{b[3]} | uint32_t{b[2]} << 8 | uint32_t{b[1]} << 16 | uint32_t{b[0]} << 24;
+        }
+        return uint32_t{b[0]} | uint32_t{b[1]} << 8 | uint32_t{b[2]} << 16 | uint32_t{b[3]} << 24;
+    }
+
+    auto read64(uint64_t p) const -> uint64_t {
+        auto lo = read32(p);
+        auto hi = read32(p + 4);
+        if (swap) std::swap(lo, hi);
+        return uint64_t{lo} | uint64_t{hi} << 32;
+    }
+
+    // reads a block list (count, starts, sizes)
+    auto blocks(uint64_t& p) const -> std::vector<interval> {
+        auto count = read32(p);
+        p += 4;
+        check(p, uint64_t{count} * 8);
+        auto res = std::vector<interval>{};
+        res.reserve(count);
+        for (size_t i{0}; i < count; ++i) {
+            size_t begin = read32(p + 4*i);
+            size_t len   = read32(p + 4*(count + i));
+            res.push_back({begin, begin + len});
+        }
+        p += uint64_t{count} * 8;
+        return res;
+    }
+
+    void parse(std::span<char const> data) {
+        bytes = {reinterpret_cast<uint8_t const*>(data.data()), data.size()};
+        auto signature = read32(0);
+        if (signature == 0x4327'411a) {
+            swap = true;
+        } else if (signature != 0x1a41'2743) {
+            throw std::runtime_error{"not a 2bit file"};
+        }
+        auto version = read32(4);
+        if (version > 1) throw std::runtime_error{"unsupported 2bit version"};
+        auto count = read32(8);
+        uint64_t p = 16;
+        // each entry has at least a name length and an offset, bounds the reservation by the file size
+        check(p, uint64_t{count} * ((version == 0) ? 5 : 9));
+        index.reserve(count);
+        for (size_t i{0}; i < count; ++i) {
+            check(p, 1);
+            size_t len = bytes[p];
+            check(p + 1, len);
+            auto name = std::string_view{data.data() + p + 1, len};
+            p += 1 + len;
+            auto offset = (version == 0) ? uint64_t{read32(p)} : read64(p);
+            p += (version == 0) ? 4 : 8;
+            index.push_back({name, offset});
+        }
+    }
+};
+
+}
@@ -6,13 +6,16 @@
 #include "concepts.h"
 
 #include <algorithm>
+#include <array>
 #include <cassert>
 #include <concepts>
+#include <cstdint>
 #include <optional>
 #include <ranges>
 #include <span>
 #include <string>
 #include <type_traits>
+#include <utility>
 #include <vector>
 
 namespace ivs {
@@ -96,6 +99,143 @@ auto view_rank_to_char = std::views::transform([](uint8_t c) {
     return Alphabet::template rank_to_char<Unknown>(c);
 });
 
+/********** Functions converting rank to rank **********/
+
+/*! \brief Policy for ranks that have no counterpart in the target alphabet
+ */
+enum class rank_conversion_policy {
+    unknown, //!< ranks are converted to `Unknown`
+    replace, //!< ranks are replaced by their first alternative that exists in the target alphabet (e.g. N becomes A)
+    random,  //!< ranks are replaced by a pseudo random alternative that exists in the target alphabet
+};
+
+namespace detail {
+
+/*! \brief Alternatives of a rank of From expressed as ranks of To
+ */
+template <alphabet_c From, alphabet_c To, uint8_t Unknown>
+constexpr auto mapped_base_alternatives(uint8_t rank) {
+    auto res = std::array<uint8_t, 32>{};
+    size_t count{0};
+    if constexpr (requires() { From::base_alternatives(uint8_t{}); }) {
+        for (auto alt : From::base_alternatives(rank)) {
+            auto r = To::template char_to_rank<Unknown>(From::rank_to_char(alt));
+            if (r == Unknown or count == res.size()) continue;
+            res[count++] = r;
+        }
+    }
+    return std::make_pair(res, count);
+}
+
+//! Table representing conversion from a rank of From to a rank of To
+template <alphabet_c From, alphabet_c To, rank_conversion_policy Policy, uint8_t Unknown>
+constexpr std::array<uint8_t, 256> rank_to_rank_table{[]() {
+    auto table = std::array<uint8_t, 256>{};
+    for (size_t i{0}; i < 256; ++i) {
+        table[i] = To::template char_to_rank<Unknown>(From::rank_to_char(i));
+        if constexpr (Policy == rank_conversion_policy::replace) {
+            auto [alts, count] = mapped_base_alternatives<From, To, Unknown>(i);
+            if (table[i] == Unknown and count > 0) {
+                table[i] = alts[0];
+            }
+        }
+    }
+    return table;
+}()};
+
+//! Alternatives for each rank of From that has no counterpart in To
+template <alphabet_c From, alphabet_c To, uint8_t Unknown>
+constexpr auto rank_to_rank_alternatives_table{[]() {
+    auto table = std::array<std::pair<std::array<uint8_t, 32>, size_t>, 256>{};
+    for (size_t i{0}; i < 256; ++i) {
+        if (rank_to_rank_table<From, To, rank_conversion_policy::unknown, Unknown>[i] == Unknown) {
+            table[i] = mapped_base_alternatives<From, To, Unknown>(i);
+        }
+    }
+    return table;
+}()};
+
+}
+
+/*! \brief Converts a single rank of one alphabet to a rank of another alphabet
+ *
+ * \tparam From describes the alphabet of the input
+ * \tparam To describes the alphabet of the output
+ * \param r rank of From
+ * \return rank of To
+ */
+template <alphabet_c From, alphabet_c To, rank_conversion_policy Policy = rank_conversion_policy::unknown, uint8_t Unknown = 255>
+    requires (Policy != rank_conversion_policy::random)
+constexpr auto convert_rank(uint8_t r) noexcept -> uint8_t {
+    return detail::rank_to_rank_table<From, To, Policy, Unknown>[r];
+}
+
+/*! \brief Converts ranks of one alphabet to ranks of another alphabet
+ *
+ * Conversion happens through a single table, that is composed at compile time
+ * from both alphabets. No intermediate char representation is created.
+ *
+ * \tparam From describes the alphabet of the input
+ * \tparam To describes the alphabet of the output
+ * \tparam Policy how to handle ranks that have no counterpart in To
+ * \param in  rank input
+ * \param out rank output (must have same size as in)
+ * \param seed seed for rank_conversion_policy::random
+ * \param offset position of in[0] in the whole sequence, when converting a sequence in chunks
+ */
+template <alphabet_c From, alphabet_c To, rank_conversion_policy Policy = rank_conversion_policy::unknown, uint8_t Unknown = 255>
+void convert_rank(std::span<uint8_t const> in, std::span<uint8_t> out, uint64_t seed = 0, size_t offset = 0) {
+    assert(in.size() == out.size());
+    auto const& table = detail::rank_to_rank_table<From, To, Policy, Unknown>;
+    for (size_t i{0}; i < in.size(); ++i) {
+        out[i] = table[in[i]];
+    }
+    if constexpr (Policy == rank_conversion_policy::random) {
+        // second pass, unmappable ranks are rare
+        auto const& alternatives = detail::rank_to_rank_alternatives_table<From, To, Unknown>;
+        for (size_t i{0}; i < in.size(); ++i) {
+            if (out[i] != Unknown) continue;
+            auto const& [alts, count] = alternatives[in[i]];
+            if (count == 0) continue;
+            // splitmix64 of seed and position, chunks converted with their offset give the same result
+            auto z = seed + (offset+i+1) * 0x9e3779b97f4a7c15ull;
+            z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ull;
+            z = (z ^ (z >> 27)) * 0x94d049bb133111ebull;
+            z = z ^ (z >> 31);
+            out[i] = alts[z % count];
+        }
+    }
+}
+
+/*! \brief Converts ranks of one alphabet to ranks of another alphabet
+ *
+ * \tparam From describes the alphabet of the input
+ * \tparam To describes the alphabet of the output
+ * \tparam Policy how to handle ranks that have no counterpart in To
+ * \param in rank input
+ * \param seed seed for rank_conversion_policy::random
+ * \return a vector of ranks of To
+ */
+template <alphabet_c From, alphabet_c To, rank_conversion_policy Policy = rank_conversion_policy::unknown, uint8_t Unknown = 255>
+auto convert_rank(std::span<uint8_t const> in, uint64_t seed = 0) -> std::vector<uint8_t> {
+    auto out = std::vector<uint8_t>{};
+    out.resize(in.size());
+    convert_rank<From, To, Policy, Unknown>(in, out, seed);
+    return out;
+}
+
+/*! \brief A view representing ranks of one alphabet as ranks of another alphabet
+ *
+ * \tparam From describes the alphabet of the input
+ * \tparam To describes the alphabet of the output
+ * \tparam Policy how to handle ranks that have no counterpart in To (random is not supported)
+ */
+template <alphabet_c From, alphabet_c To, rank_conversion_policy Policy = rank_conversion_policy::unknown, uint8_t Unknown = 255>
+    requires (Policy != rank_conversion_policy::random)
+auto view_convert_rank = std::views::transform([](uint8_t c) {
+    return detail::rank_to_rank_table<From, To, Policy, Unknown>[c];
+});
+
 /********** Functions Normalizing chars **********/
 
 /*! \brief Normalizes chars according to the alphabet
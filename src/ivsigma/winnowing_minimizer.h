@@ -9,17 +9,24 @@
 
 namespace ivs {
 
-template <alphabet_c Alphabet, bool DuplicatesAllowed=true, bool UseCanonicalKmers=true>
+/*! \brief Winnowing minimizers over the k-mers of an encoding
+ *
+ * \tparam Encoding k-mer encoding, e.g. a compact_encoding or a quality_filtered_compact_encoding
+ */
+template <alphabet_c Alphabet, bool DuplicatesAllowed=true, bool UseCanonicalKmers=true, std::ranges::forward_range Values = std::span<uint8_t const>,
+          typename Encoding = compact_encoding<Alphabet, UseCanonicalKmers, Values>>
 struct winnowing_minimizer {
-    using Encoding = compact_encoding<Alphabet, UseCanonicalKmers>;
-
     Encoding hash;
     size_t   window{};
 
-    winnowing_minimizer(std::span<uint8_t const> _values, size_t _k, size_t _window, size_t _seed = 0)
+    winnowing_minimizer(Values _values, size_t _k, size_t _window, size_t _seed = 0)
         : hash{_values, _k, _seed}
         , window{_window} {
     }
+    winnowing_minimizer(Encoding _hash, size_t _window)
+        : hash{_hash}
+        , window{_window} {
+    }
     auto size() const -> size_t {
         if (hash.size() < window) return 0;
         return hash.size() - window + 1;
@@ -28,41 +35,70 @@ struct winnowing_minimizer {
     struct iterator {
         winnowing_minimizer const* ptr;
 
-        Encoding::iterator                     iter;
-        std::deque<std::pair<size_t, size_t>>  values{};
-        size_t                                 pos{};
+        struct entry {
+            size_t pos;                            // running index of the k-mer
+            size_t hash;
+            Encoding::iterator::ValuesIter kmer;   // first value of the k-mer
+            size_t position;                       // position of the first value of the k-mer
+        };
+
+        Encoding::iterator  iter;
+        std::deque<entry>   values{};
+        size_t              pos{};
 
         iterator(winnowing_minimizer const& minimizer)
             : ptr{&minimizer}
             , iter{begin(ptr->hash)}
         {
-            if (ptr->size() == 0) return;
+            if (iter == end(ptr->hash) or ptr->window == 0) return;
 
-            values.emplace_back(0, *iter);
+            values.push_back({0, *iter, iter.kmer(), iter.position()});
             while (pos+1 < ptr->window) {
                 ++iter;
                 ++pos;
+                if (iter == end(ptr->hash)) {
+                    values.clear();
+                    return;
+                }
                 // pop at the end, until element smaller is found
-                while (!values.empty() && values.back().second > *iter) {
+                while (!values.empty() && values.back().hash > *iter) {
                     values.pop_back();
                 }
-                values.emplace_back(pos, *iter);
+                values.push_back({pos, *iter, iter.kmer(), iter.position()});
             }
         }
 
 
         auto operator*() const -> size_t {
-            return values.front().second;
+            return values.front().hash;
+        }
+
+        /*! \brief Iterator to the first value of the current minimizer
+         *
+         * Allows mapping the minimizer back to the underlying values, e.g.
+         * to original coordinates of a homopolymer compressed sequence.
+         */
+        auto kmer() const -> Encoding::iterator::ValuesIter {
+            return values.front().kmer;
+        }
+
+        /*! \brief Position of the first value of the current minimizer
+         *
+         * Counted in the values of the encoding, e.g. in compressed coordinates of a
+         * homopolymer compressed sequence (see kmer() for original coordinates).
+         */
+        auto position() const -> size_t {
+            return values.front().position;
         }
 
         auto operator++() -> iterator& {
-            auto lastReportedPos  = values.front().first;
-            auto lastReportedHash = values.front().second;
+            auto lastReportedPos  = values.front().pos;
+            auto lastReportedHash = values.front().hash;
             auto abortPred = [&]() {
                 if constexpr (DuplicatesAllowed) {
-                    return lastReportedPos == values.front().first;
+                    return lastReportedPos == values.front().pos;
                 } else {
-                    return lastReportedHash == values.front().second;
+                    return lastReportedHash == values.front().hash;
                 }
             };
 
@@ -75,17 +111,16 @@ struct winnowing_minimizer {
                 }
 
                 // drop at the beginning if outside of the window
-                auto const& [_pos, _hash] = values.front();
-                if (_pos + ptr->window <= pos) {
+                if (values.front().pos + ptr->window <= pos) {
                     values.pop_front();
                 }
 
                 // pop at the end, until element smaller is found
-                while (!values.empty() && values.back().second >= *iter) {
+                while (!values.empty() && values.back().hash >= *iter) {
                     values.pop_back();
                 }
 
-                values.emplace_back(pos, *iter);
+                values.push_back({pos, *iter, iter.kmer(), iter.position()});
                 if (ptr->window == 1) break;
             }
             return *this;
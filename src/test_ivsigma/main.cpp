@@ -4,12 +4,20 @@
 #undef NDEBUG
 
 #include <algorithm>
+#include <cmath>
+#include <filesystem>
 #include <fmt/format.h>
 #include <fmt/ranges.h>
+#include <fstream>
 #include <iostream>
+#include <map>
+#include <numeric>
 #include <ivsigma/ivsigma.h>
 #include <ranges>
+#include <set>
+#include <sstream>
 #include <string>
+#include <thread>
 
 template <ivs::alphabet_c Alphabet>
 static void check_normalize(std::string input, std::string expected) {
@@ -612,7 +620,73 @@ void test_aminoacids() {
 
 }
 void test_qualities() {
-    //!TODO
+    // ranged alphabets model alphabet_c
+    assert(ivs::pthred42::size() == 42);
+    assert(ivs::pthred94::size() == 94);
+    assert(ivs::pthred42::char_to_rank('!') == 0);
+    assert(ivs::pthred42::char_to_rank('J') == 41);
+    assert(ivs::pthred42::char_to_rank('K') == 255);
+    assert(ivs::pthred42::char_to_rank(' ') == 255);
+    assert(ivs::pthred94::char_to_rank('~') == 93);
+    assert(ivs::pthred94::char_to_rank(127) == 255);
+    assert(ivs::pthred42::rank_to_char(41) == 'J');
+    assert(ivs::pthred42::rank_to_char(42) == '\0');
+    assert(ivs::pthred68solexa::char_to_rank(';') == 0);
+    assert(ivs::pthred68solexa::score(0) == -5);
+    assert(ivs::normalize_char<ivs::pthred42>(std::string{"!5J K"}) == std::string({'!', '5', 'J', '\0', '\0'}));
+    assert((ivs::convert_char_to_rank<ivs::pthred42>(std::string{"!+5"}) == std::vector<uint8_t>{0, 10, 20}));
+
+    // decoding and validation
+    {
+        auto input = std::string{};
+        for (size_t i{0}; i < 200; ++i) {
+            input += static_cast<char>('!' + (i * 7) % 42);
+        }
+        auto ranks = std::vector<uint8_t>(input.size());
+        assert(ivs::decode_phred<ivs::pthred42>(input, ranks));
+        assert(ranks == ivs::convert_char_to_rank<ivs::pthred42>(input));
+        assert(!ivs::validate_phred<ivs::pthred42>(input));
+
+        input[150] = 'Z';
+        input[170] = ' ';
+        assert(!ivs::decode_phred<ivs::pthred42>(input, ranks));
+        assert(ranks == ivs::convert_char_to_rank<ivs::pthred42>(input));
+        assert(ivs::validate_phred<ivs::pthred42>(input) == 150);
+        assert(ivs::validate_phred<ivs::pthred94>(input) == 170);
+    }
+
+    // error probabilities
+    {
+        auto close = [](double a, double b) { return std::abs(a - b) < 1e-12; };
+        assert(close(ivs::error_probability<ivs::pthred42>(10), 0.1));
+        assert(close(ivs::error_probability<ivs::pthred42>(20), 0.01));
+        assert(close(ivs::error_probability<ivs::pthred42>(30), 0.001));
+        assert(close(ivs::error_probability<ivs::pthred42>(0), 1.));
+        for (uint8_t r{0}; r < ivs::pthred94::size(); ++r) {
+            assert(std::abs(ivs::error_probability<ivs::pthred94>(r) - std::pow(10., -r / 10.)) < 1e-12);
+        }
+        // solexa score 0 means p/(1-p) = 1
+        assert(close(ivs::error_probability<ivs::pthred68solexa>(5), 0.5));
+        assert(close(ivs::error_probability<ivs::pthred68solexa>(15), 0.1 / 1.1));
+    }
+
+    // statistics
+    {
+        auto stats = ivs::compute_quality_statistics<ivs::pthred42>(std::string{"+5?+ "});
+        assert(stats.length == 4);
+        assert(stats.invalid == 1);
+        assert(stats.sum == 10 + 20 + 30 + 10);
+        assert(stats.min == 10);
+        assert(std::abs(stats.mean() - 17.5) < 1e-12);
+        assert(std::abs(stats.expected_errors - 0.211) < 1e-12);
+
+        auto empty = ivs::compute_quality_statistics<ivs::pthred42>(std::string{});
+        assert(empty.length == 0 and empty.min == 0 and empty.mean() == 0.);
+
+        auto solexa = ivs::compute_quality_statistics<ivs::pthred68solexa>(std::string{";@"});
+        assert(solexa.sum == -5);
+        assert(solexa.min == -5);
+    }
 }
 
 void test_compact_encoding() {
@@ -646,6 +720,16 @@ void test_compact_encoding() {
         assert(result[3] == 143);
         assert(result[4] == 432);
     }
+
+    // only a few k-mers
+    {
+        auto short_v = std::vector<uint8_t>{3, 2, 0, 1};
+        auto result = std::vector<size_t>{};
+        for (auto h : ivs::compact_encoding<ivs::dna4, /*UseCanonicalKmers=*/false>{short_v, /*.k=*/ 3}) {
+            result.push_back(h);
+        }
+        assert((result == std::vector<size_t>{56, 33}));
+    }
 }
 
 void test_winnowing_minimizer() {
@@ -734,12 +818,2307 @@ void test_winnowing_minimizer() {
 
 }
 
+namespace {
+//! Reproducible pseudo random numbers for test data (64bit linear congruential generator)
+struct test_rng {
+    uint64_t state;
+
+    auto operator()() -> uint64_t {
+        state = state * 6364136223846793005ull + 1442695040888963407ull;
+        return state;
+    }
+};
+
+//! 'count' random sequences of dna4 ranks with 'length' ranks each
+auto random_ranks(uint64_t seed, size_t count, size_t length) -> std::vector<std::vector<uint8_t>> {
+    auto next = test_rng{seed};
+    auto res  = std::vector<std::vector<uint8_t>>(count, std::vector<uint8_t>(length));
+    for (auto& s : res) {
+        for (auto& r : s) r = static_cast<uint8_t>(next() >> 62);
+    }
+    return res;
+}
+}
+
+void test_kmer_counter() {
+    // random reads with a repeated region
+    auto reads  = random_ranks(42, 300, 100);
+    auto repeat = random_ranks(43, 1, 40)[0];
+    for (size_t i{0}; i < reads.size(); ++i) {
+        if (i % 7 == 0) reads[i].resize(5);
+        else if (i % 3 == 0) std::ranges::copy(repeat, reads[i].begin() + 10);
+    }
+
+    auto expected = std::map<uint64_t, uint64_t>{};
+    for (auto const& read : reads) {
+        for (auto kmer : ivs::compact_encoding<ivs::dna4>{read, 11}) {
+            expected[kmer] += 1;
+        }
+    }
+
+    for (size_t threads : {1, 4}) {
+        auto table = ivs::kmer_count_table{expected.size()};
+        ivs::count_kmers<ivs::dna4>(table, reads, 11, threads);
+        assert(table.size() == expected.size());
+        for (auto [kmer, count] : expected) {
+            assert(table.count(kmer) == count);
+        }
+
+        auto hist = table.histogram();
+        auto expectedHist = std::vector<uint64_t>{};
+        for (auto [kmer, count] : expected) {
+            if (count >= expectedHist.size()) expectedHist.resize(count + 1);
+            expectedHist[count] += 1;
+        }
+        assert(hist == expectedHist);
+        auto capped = table.histogram(2);
+        assert(capped.size() == 3 and capped[1] == expectedHist[1]);
+
+        auto frequent = table.kmers_above(5);
+        auto expectedFrequent = std::vector<ivs::kmer_count>{};
+        for (auto [kmer, count] : expected) {
+            if (count >= 5) expectedFrequent.push_back({kmer, count});
+        }
+        assert(frequent == expectedFrequent and !frequent.empty());
+    }
+
+    // read batches count the same k-mers
+    {
+        auto batch = ivs::read_batch<ivs::dna4>{};
+        for (auto const& read : reads) batch.push_back(ivs::convert_rank_to_char<ivs::dna4>(read));
+        auto table = ivs::kmer_count_table{expected.size()};
+        ivs::count_kmers<ivs::dna4>(table, batch, 11, 2);
+        assert(table.size() == expected.size());
+        for (auto [kmer, count] : expected) {
+            assert(table.count(kmer) == count);
+        }
+    }
+
+    // concurrent single inserts, including the value used as empty marker
+    {
+        auto table = ivs::kmer_count_table{100};
+        auto threads = std::vector<std::thread>{};
+        for (size_t t{0}; t < 4; ++t) {
+            threads.emplace_back([&]() {
+                for (uint64_t v{0}; v < 100; ++v) {
+                    table.insert(v);
+                }
+                table.insert(~uint64_t{0}, 2);
+            });
+        }
+        for (auto& t : threads) t.join();
+        assert(table.size() == 101);
+        for (uint64_t v{0}; v < 100; ++v) {
+            assert(table.count(v) == 4);
+        }
+        assert(table.count(~uint64_t{0}) == 8);
+    }
+
+    // full tables throw
+    {
+        auto table = ivs::kmer_count_table{1};
+        bool thrown{false};
+        try {
+            for (uint64_t v{0}; v <= table.capacity(); ++v) {
+                table.insert(v);
+            }
+        } catch (std::runtime_error const&) {
+            thrown = true;
+        }
+        assert(thrown);
+
+        // overfilled from several threads, the exception reaches the caller of count_kmers
+        thrown = false;
+        try {
+            auto small = ivs::kmer_count_table{64};
+            ivs::count_kmers<ivs::dna4>(small, reads, 11, 4);
+        } catch (std::runtime_error const&) {
+            thrown = true;
+        }
+        assert(thrown);
+    }
+}
+
+void test_homopolymer_compression() {
+    auto v = std::vector<uint8_t>{0, 0, 1, 1, 1, 2, 3, 3, 0, 2, 2};
+
+    {
+        auto out       = std::vector<uint8_t>(v.size());
+        auto positions = std::vector<size_t>(v.size());
+        auto n = ivs::compress_homopolymers(v, out, positions);
+        assert(n == 6);
+        out.resize(n);
+        positions.resize(n);
+        assert((out       == std::vector<uint8_t>{0, 1, 2, 3, 0, 2}));
+        assert((positions == std::vector<size_t>{0, 2, 5, 6, 8, 9}));
+        assert(ivs::compress_homopolymers(v) == out);
+    }
+
+    {
+        auto view   = ivs::homopolymer_compressed_view{v};
+        auto ranks  = std::vector<uint8_t>{};
+        auto pos    = std::vector<size_t>{};
+        auto length = std::vector<size_t>{};
+        for (auto iter = view.begin(); iter != view.end(); ++iter) {
+            ranks.push_back(*iter);
+            pos.push_back(iter.position());
+            length.push_back(iter.run_length());
+        }
+        assert((ranks  == std::vector<uint8_t>{0, 1, 2, 3, 0, 2}));
+        assert((pos    == std::vector<size_t>{0, 2, 5, 6, 8, 9}));
+        assert((length == std::vector<size_t>{2, 3, 1, 2, 1, 2}));
+        assert(ivs::homopolymer_compressed_view{std::vector<uint8_t>{}}.empty());
+    }
+
+    // k-mers over the view are identical to k-mers over the materialized compression
+    {
+        auto compressed = ivs::compress_homopolymers(v);
+        auto expected   = std::vector<size_t>{};
+        for (auto h : ivs::compact_encoding<ivs::dna4>{compressed, /*.k=*/ 3}) {
+            expected.push_back(h);
+        }
+        auto result    = std::vector<size_t>{};
+        auto positions = std::vector<size_t>{};
+        auto encoding  = ivs::homopolymer_compact_encoding<ivs::dna4>{v, /*.k=*/ 3};
+        for (auto iter = begin(encoding); iter != end(encoding); ++iter) {
+            result.push_back(*iter);
+            positions.push_back(iter.kmer().position());
+        }
+        assert(expected.size() == 4);
+        assert(result == expected);
+        assert((positions == std::vector<size_t>{0, 2, 5, 6}));
+    }
+
+    {
+        auto compressed = ivs::compress_homopolymers(v);
+        auto expected   = std::vector<size_t>{};
+        auto expectedPositions = std::vector<size_t>{};
+        auto plain = ivs::winnowing_minimizer<ivs::dna4>{compressed, /*.k=*/ 3, /*.window=*/ 2};
+        for (auto iter = begin(plain); iter != end(plain); ++iter) {
+            expected.push_back(*iter);
+            expectedPositions.push_back(iter.position());
+        }
+        auto result    = std::vector<size_t>{};
+        auto positions = std::vector<size_t>{};
+        auto compressedPositions = std::vector<size_t>{};
+        auto minimizer = ivs::homopolymer_winnowing_minimizer<ivs::dna4>{v, /*.k=*/ 3, /*.window=*/ 2};
+        for (auto iter = begin(minimizer); iter != end(minimizer); ++iter) {
+            result.push_back(*iter);
+            positions.push_back(iter.kmer().position());
+            compressedPositions.push_back(iter.position());
+        }
+        assert(result == expected);
+        assert(compressedPositions == expectedPositions);
+        assert(result.size() == positions.size());
+        assert(std::ranges::is_sorted(positions));
+    }
+
+    // sequences shorter than k
+    {
+        auto short_v = std::vector<uint8_t>{1, 1, 1, 2, 2};
+        auto encoding = ivs::homopolymer_compact_encoding<ivs::dna4>{short_v, /*.k=*/ 3};
+        assert(begin(encoding) == end(encoding));
+    }
+}
+
+void test_translation() {
+    auto dna = std::string{"ATGGCCAANTAAGGTTGA"};
+    auto v = ivs::convert_char_to_rank<ivs::dna5>(dna);
+
+    assert(ivs::translate_codon(0, 3, 2) == ivs::aa27::char_to_rank('M'));
+    assert(ivs::translate_codon(3, 2, 0) == ivs::aa27::char_to_rank('*'));
+    assert((ivs::translate_codon<ivs::aa27, ivs::genetic_code::vertebrate_mitochondrial>(3, 2, 0) == ivs::aa27::char_to_rank('W')));
+    assert(ivs::translate_codon(4, 3, 2) == ivs::aa27::char_to_rank('X'));
+    assert(ivs::translate_codon(255, 3, 2) == 255);
+    for (uint8_t r{5}; r < 16; ++r) {
+        assert(ivs::translate_codon(r, 3, 2) == 255);
+        assert(ivs::translate_codon(0, r, 2) == 255);
+        assert(ivs::translate_codon(0, 3, r) == 255);
+    }
+    assert((ivs::translate_rank(std::vector<uint8_t>{8, 3, 2, 0, 3, 2}) == std::vector<uint8_t>{255, ivs::aa27::char_to_rank('M')}));
+
+    {
+        auto aa = ivs::translate_rank(v);
+        assert(ivs::convert_rank_to_char<ivs::aa27>(aa) == "MAX*G*");
+    }
+    {
+        auto aa = ivs::translate_rank<ivs::aa27, ivs::genetic_code::vertebrate_mitochondrial>(v);
+        assert(ivs::convert_rank_to_char<ivs::aa27>(aa) == "MAX*GW");
+    }
+    {
+        auto aa = ivs::translate_rank<ivs::aa10murphy>(v);
+        assert(ivs::convert_rank_to_char<ivs::aa10murphy>(aa) == "IASFGF");
+    }
+
+    // six frames must match translation of the shifted sequence and its reverse complement
+    {
+        for (auto input : {dna, std::string{"ACGTTGCANNGTCAGTCGTAGCTTTGCAAC"}, std::string{"ACGTTGCAGTCAGTCGTAGCTTTGCA"}, std::string{"AC"}}) {
+            auto ranks  = ivs::convert_char_to_rank<ivs::dna5>(input);
+            auto rev    = ivs::reverse_complement_rank<ivs::dna5>(ranks);
+            auto frames = ivs::translate_rank_six_frame(ranks);
+            for (size_t f{0}; f < 3; ++f) {
+                auto fwd = std::span{ranks}.subspan(std::min(f, ranks.size()));
+                auto bwd = std::span{rev}.subspan(std::min(f, rev.size()));
+                assert(frames[f]   == ivs::translate_rank(fwd));
+                assert(frames[f+3] == ivs::translate_rank(bwd));
+                assert(frames[f].size() == ivs::translated_size(input.size(), f));
+            }
+        }
+    }
+
+    // output works with compact_encoding
+    {
+        auto aa = ivs::translate_rank(v);
+        auto result = std::vector<size_t>{};
+        for (auto h : ivs::compact_encoding<ivs::aa27>{aa, /*.k=*/ 2}) {
+            result.push_back(h);
+        }
+        assert(result.size() == 5);
+        assert(result[0] == 10 * 27 + 0);
+    }
+}
+
+template <ivs::alphabet_c From, ivs::alphabet_c To>
+static void check_convert_rank_via_char() {
+    auto input = std::vector<uint8_t>{};
+    for (size_t i{0}; i < 256; ++i) {
+        input.push_back(i);
+    }
+    auto expected = ivs::convert_char_to_rank<To>(ivs::convert_rank_to_char<From>(input));
+    assert((ivs::convert_rank<From, To>(input) == expected));
+    assert((std::ranges::equal(input | ivs::view_convert_rank<From, To>, expected)));
+}
+
+void test_convert_rank() {
+    check_convert_rank_via_char<ivs::aa27, ivs::aa10murphy>();
+    check_convert_rank_via_char<ivs::aa27, ivs::aa10li>();
+    check_convert_rank_via_char<ivs::aa27, ivs::aa20>();
+    check_convert_rank_via_char<ivs::dna5, ivs::dna4>();
+    check_convert_rank_via_char<ivs::dna5, ivs::dna3bs>();
+    check_convert_rank_via_char<ivs::iupac, ivs::dna5>();
+
+    auto input = std::vector<uint8_t>{0, 1, 4, 2, 3, 4, 4, 255};
+    {
+        auto output = ivs::convert_rank<ivs::dna5, ivs::dna4>(input);
+        assert((output == std::vector<uint8_t>{0, 1, 255, 2, 3, 255, 255, 255}));
+    }
+    {
+        auto output = ivs::convert_rank<ivs::dna5, ivs::dna4, ivs::rank_conversion_policy::replace>(input);
+        assert((output == std::vector<uint8_t>{0, 1, 0, 2, 3, 0, 0, 255}));
+        assert((ivs::convert_rank<ivs::dna5, ivs::dna4, ivs::rank_conversion_policy::replace>(4) == 0));
+    }
+    {
+        auto output = ivs::convert_rank<ivs::dna5, ivs::dna4, ivs::rank_conversion_policy::random>(input, /*.seed=*/ 42);
+        assert(output.size() == input.size());
+        for (size_t i{0}; i < input.size(); ++i) {
+            if (input[i] < 4) assert(output[i] == input[i]);
+            else if (input[i] == 4) assert(output[i] < 4);
+            else assert(output[i] == 255);
+        }
+        // reproducible
+        assert((output == ivs::convert_rank<ivs::dna5, ivs::dna4, ivs::rank_conversion_policy::random>(input, /*.seed=*/ 42)));
+
+        // many N are replaced by all four bases
+        auto many_n = std::vector<uint8_t>(1000, 4);
+        auto replaced = ivs::convert_rank<ivs::dna5, ivs::dna4, ivs::rank_conversion_policy::random>(many_n);
+        for (uint8_t r{0}; r < 4; ++r) {
+            assert(std::ranges::count(replaced, r) > 100);
+        }
+
+        // converting in chunks with their offsets gives the same result
+        auto chunked = std::vector<uint8_t>(many_n.size());
+        for (size_t i{0}; i < many_n.size(); i += 300) {
+            auto n = std::min<size_t>(300, many_n.size() - i);
+            ivs::convert_rank<ivs::dna5, ivs::dna4, ivs::rank_conversion_policy::random>(std::span{many_n}.subspan(i, n), std::span{chunked}.subspan(i, n), 0, i);
+        }
+        assert(chunked == replaced);
+    }
+    {
+        // iupac R stands for A or G
+        auto output = ivs::convert_rank<ivs::iupac, ivs::dna4, ivs::rank_conversion_policy::random>(std::vector<uint8_t>(100, 5));
+        for (auto r : output) {
+            assert(r == 0 or r == 2);
+        }
+    }
+}
+
+void test_bisulfite() {
+    check_char_to_rank<ivs::dna3bs_ga>("ACGTUacgtu", {0, 1, 0, 2, 2, 0, 1, 0, 2, 2});
+    check_rank_to_char<ivs::dna3bs_ga>({0, 1, 2}, "ACT");
+    check_normalize<ivs::dna3bs_ga>("ACGTUacgtu", "ACATTACATT");
+
+    auto input = ivs::convert_char_to_rank<ivs::dna4>(std::string{"ACGTTGCACGGA"});
+    auto [top, bottom] = ivs::convert_rank_bisulfite(input);
+    assert(ivs::convert_rank_to_char<ivs::dna3bs>(top)       == "ATGTTGTATGGA");
+    assert(ivs::convert_rank_to_char<ivs::dna3bs_ga>(bottom) == "ACATTACACAAA");
+
+    // fused k-mers are identical to k-mers of the converted sequences
+    auto expectedTop    = std::vector<size_t>{};
+    auto expectedBottom = std::vector<size_t>{};
+    for (auto h : ivs::compact_encoding<ivs::dna3bs>{top, /*.k=*/ 4}) {
+        expectedTop.push_back(h);
+    }
+    for (auto h : ivs::compact_encoding<ivs::dna3bs_ga>{bottom, /*.k=*/ 4}) {
+        expectedBottom.push_back(h);
+    }
+    auto resultTop    = std::vector<size_t>{};
+    auto resultBottom = std::vector<size_t>{};
+    for (auto [t, b] : ivs::bisulfite_compact_encoding{input, /*.k=*/ 4}) {
+        resultTop.push_back(t);
+        resultBottom.push_back(b);
+    }
+    assert(expectedTop.size() == 9);
+    assert(resultTop    == expectedTop);
+    assert(resultBottom == expectedBottom);
+
+    {
+        auto short_input = std::vector<uint8_t>{0, 1};
+        auto encoding = ivs::bisulfite_compact_encoding{short_input, /*.k=*/ 4};
+        assert(begin(encoding) == end(encoding));
+    }
+}
+
+template <ivs::alphabet_c Alphabet>
+static void check_packed_sequence(std::vector<uint8_t> input) {
+    auto packed = ivs::packed_sequence<Alphabet>{input};
+    assert(packed.size() == input.size());
+    assert(packed.unpack() == input);
+    assert(std::ranges::equal(packed, input));
+    for (size_t i{0}; i < input.size(); ++i) {
+        assert(packed[i] == input[i]);
+    }
+
+    // appending at unaligned positions
+    auto appended = ivs::packed_sequence<Alphabet>{};
+    for (size_t i{0}; i < input.size(); i += 7) {
+        appended.append(std::span{input}.subspan(i, std::min<size_t>(7, input.size() - i)));
+    }
+    assert(appended.words == packed.words);
+
+    // region extraction
+    auto region = std::vector<uint8_t>(input.size() / 2);
+    packed.unpack(input.size() / 3, region);
+    assert(std::ranges::equal(region, std::span{input}.subspan(input.size() / 3, region.size())));
+
+    // shrinking clears unused bits
+    auto shrunk = packed;
+    shrunk.resize(input.size() / 2);
+    auto expected = ivs::packed_sequence<Alphabet>{std::span{input}.first(input.size() / 2)};
+    assert(shrunk.words == expected.words);
+}
+
+void test_packed_sequence() {
+    auto input = std::vector<uint8_t>{};
+    for (size_t i{0}; i < 1000; ++i) {
+        input.push_back((i * 7 + i / 3) % 27);
+    }
+    check_packed_sequence<ivs::aa27>(input);
+    for (auto& v : input) v %= 5;
+    check_packed_sequence<ivs::dna5>(input);
+    for (auto& v : input) v %= 4;
+    check_packed_sequence<ivs::dna4>(input);
+    for (auto& v : input) v %= 2;
+    check_packed_sequence<ivs::dna2>(input);
+
+    static_assert(ivs::packed_bits<ivs::dna2> == 1);
+    static_assert(ivs::packed_bits<ivs::dna4> == 2);
+    static_assert(ivs::packed_bits<ivs::dna5> == 3);
+    static_assert(ivs::packed_bits<ivs::aa27> == 5);
+    static_assert(std::ranges::random_access_range<ivs::packed_span<ivs::dna4>>);
+
+    // k-mers over packed sequences
+    {
+        auto ranks  = ivs::convert_char_to_rank<ivs::dna4>(std::string{"ACGTTGCAACGTAGCTAGCATCGACTAGC"});
+        auto packed = ivs::packed_sequence<ivs::dna4>{ranks};
+        auto expected = std::vector<size_t>{};
+        for (auto h : ivs::compact_encoding<ivs::dna4>{ranks, /*.k=*/ 5}) {
+            expected.push_back(h);
+        }
+        auto result = std::vector<size_t>{};
+        for (auto h : ivs::compact_encoding<ivs::dna4, true, ivs::packed_span<ivs::dna4>>{packed, /*.k=*/ 5}) {
+            result.push_back(h);
+        }
+        assert(result == expected);
+    }
+}
+
+template <ivs::alphabet_c Alphabet>
+static void check_composition(std::vector<uint8_t> const& input, size_t window, size_t step) {
+    auto expected = std::array<size_t, Alphabet::size()>{};
+    for (auto v : input) {
+        if (v < expected.size()) expected[v] += 1;
+    }
+    assert(ivs::rank_histogram<Alphabet>(input) == expected);
+    auto packed = ivs::packed_sequence<Alphabet>{input};
+    if (std::ranges::all_of(input, [](uint8_t v) { return v < Alphabet::size(); })) {
+        assert(ivs::rank_histogram<Alphabet>(packed) == expected);
+    }
+
+    auto check = [&](auto const& composition) {
+        size_t n{0};
+        for (auto const& w : composition) {
+            assert(w.position == n * step);
+            assert(w.length == window);
+            auto counts = std::array<size_t, Alphabet::size()>{};
+            size_t cpg{};
+            for (size_t i{w.position}; i < w.position + window; ++i) {
+                if (input[i] < counts.size()) counts[input[i]] += 1;
+                if (i > w.position and input[i-1] == 1 and input[i] == 2) cpg += 1;
+            }
+            assert(w.counts == counts);
+            assert(w.cpg == cpg);
+            n += 1;
+        }
+        assert(n == (input.size() < window ? 0 : (input.size() - window) / step + 1));
+    };
+    check(ivs::sliding_composition<Alphabet>{input, window, step});
+    check(ivs::sliding_composition<Alphabet, ivs::packed_span<Alphabet>>{packed, window, step});
+}
+
+void test_composition() {
+    auto input = ivs::convert_char_to_rank<ivs::dna5>(std::string{"ACGCGTTANNCGATCGCGCGTATATACGNNNACGTCGA"});
+    for (auto window : {1, 2, 5, 10, 50}) {
+        for (auto step : {1, 3, 10}) {
+            check_composition<ivs::dna5>(input, window, step);
+        }
+    }
+    for (auto& v : input) v %= 4;
+    check_composition<ivs::dna4>(input, 10, 5);
+
+    {
+        auto w = *begin(ivs::sliding_composition<ivs::dna5>{input, 4});
+        assert(w.gc_fraction() == 0.75);
+        assert(w.cpg_density() == 1. / 3.);
+    }
+    {
+        auto aa = ivs::convert_char_to_rank<ivs::aa27>(std::string{"MKVLAWCCG*XX"});
+        auto histogram = ivs::rank_histogram<ivs::aa27>(aa);
+        assert(histogram[ivs::aa27::char_to_rank('C')] == 2);
+        assert(histogram[ivs::aa27::char_to_rank('X')] == 2);
+        assert(std::accumulate(histogram.begin(), histogram.end(), size_t{}) == aa.size());
+        assert(ivs::rank_histogram<ivs::aa27>(ivs::packed_sequence<ivs::aa27>{aa}) == histogram);
+    }
+}
+
+void test_dust() {
+    auto random = std::string{"GATTACCGTAGCTTAGCCATGCAGTTCGATCGGATCAAGTCTGAACGTTAGCCTAGGCATCGTAAGCT"};
+    auto repeat = std::string{"CACACACACACACACACACACACACA"};
+
+    // no low complexity region
+    assert(ivs::sdust(ivs::convert_char_to_rank<ivs::dna4>(random)).empty());
+    assert(ivs::sdust(std::vector<uint8_t>{}).empty());
+
+    // poly-A
+    {
+        auto input = random.substr(0, 40) + std::string(30, 'A') + random.substr(20);
+        auto result = ivs::sdust(ivs::convert_char_to_rank<ivs::dna4>(input));
+        assert((result == std::vector<ivs::interval>{{40, 70}}));
+    }
+
+    // N separates independent pieces
+    {
+        auto input = random.substr(0, 30) + std::string(40, 'N') + repeat + random.substr(0, 30);
+        auto result = ivs::sdust(ivs::convert_char_to_rank<ivs::dna5>(input));
+        assert((result == std::vector<ivs::interval>{{70, 96}}));
+
+        input = repeat + "N" + repeat;
+        result = ivs::sdust(ivs::convert_char_to_rank<ivs::dna5>(input));
+        assert((result == std::vector<ivs::interval>{{0, 26}, {27, 53}}));
+    }
+
+    // a higher threshold masks less, reusing the masker
+    {
+        auto input = ivs::convert_char_to_rank<ivs::dna4>(random + "ACGACGACGACGACGACGACGACGACGACG" + random);
+        auto masker = ivs::sdust_masker{};
+        auto strict = masker.mask(input);
+        masker.threshold = 60;
+        auto relaxed = masker.mask(input);
+        assert(strict.size() == 1);
+        assert(strict[0].begin >= random.size() - 3 and strict[0].end <= random.size() + 33);
+        assert(relaxed.empty());
+    }
+}
+
+void test_soft_mask() {
+    // interval extraction, including runs crossing 64 character blocks
+    {
+        auto input = std::string(60, 'A') + std::string(10, 'c') + std::string(60, 'G') + std::string(70, 't') + "nA";
+        auto masked = ivs::soft_masked_intervals(input);
+        assert((masked == std::vector<ivs::interval>{{60, 70}, {130, 201}}));
+        assert(ivs::soft_masked_intervals(std::string{}).empty());
+        assert(ivs::soft_masked_intervals(std::string{"ACGT"}).empty());
+    }
+
+    // fused normalization and rank conversion
+    {
+        auto input = std::string{"ACgtNNacGT"};
+        auto [normalized, masked] = ivs::normalize_char_soft_masked<ivs::dna5>(input);
+        assert(normalized == ivs::normalize_char<ivs::dna5>(input));
+        assert((masked == std::vector<ivs::interval>{{2, 4}, {6, 8}}));
+
+        auto [ranks, masked2] = ivs::convert_char_to_rank_soft_masked<ivs::dna5>(input);
+        assert(ranks == ivs::convert_char_to_rank<ivs::dna5>(input));
+        assert(masked2 == masked);
+    }
+
+    // k-mers overlapping masked intervals are skipped
+    {
+        auto input = std::string{"ACGTAcgtacGTACGTAC"};
+        auto [ranks, masked] = ivs::convert_char_to_rank_soft_masked<ivs::dna4>(input);
+        assert((masked == std::vector<ivs::interval>{{5, 10}}));
+
+        auto all = std::vector<std::pair<size_t, size_t>>{};
+        auto encoding = ivs::compact_encoding<ivs::dna4>{ranks, 3};
+        for (auto iter = begin(encoding); iter != nullptr; ++iter) {
+            auto p = iter.position();
+            if (p + 3 <= 5 or p >= 10) {
+                all.emplace_back(p, *iter);
+            }
+        }
+        auto view = ivs::masked_compact_encoding<ivs::dna4>{ranks, masked, 3};
+        auto result = std::vector<std::pair<size_t, size_t>>{};
+        for (auto iter = begin(view); iter != end(view); ++iter) {
+            result.emplace_back(iter.position(), *iter);
+        }
+        assert(result == all);
+        assert(view.size() == all.size());
+
+        // nothing masked
+        auto unmasked = ivs::masked_compact_encoding<ivs::dna4>{ranks, {}, 3};
+        assert((unmasked.size() == ivs::compact_encoding<ivs::dna4>{ranks, 3}.size()));
+
+        // everything masked
+        auto fully = std::vector<ivs::interval>{{0, ranks.size()}};
+        auto none = ivs::masked_compact_encoding<ivs::dna4>{ranks, fully, 3};
+        assert(begin(none) == end(none));
+    }
+
+    // minimizers are computed per unmasked segment
+    {
+        auto input = std::string{"ACGTAGCTAGGATCGATCgatcgatcgatcgTCGATCGGGACTAGCGA"};
+        auto [ranks, masked] = ivs::convert_char_to_rank_soft_masked<ivs::dna4>(input);
+        auto view = ivs::masked_winnowing_minimizer<ivs::dna4>{ranks, masked, 4, 3};
+        auto expected = std::vector<std::pair<size_t, size_t>>{};
+        for (auto [b, e] : std::vector<std::pair<size_t, size_t>>{{0, 18}, {31, ranks.size()}}) {
+            auto segment = std::span<uint8_t const>{ranks}.subspan(b, e - b);
+            auto minimizer = ivs::winnowing_minimizer<ivs::dna4>{segment, 4, 3};
+            for (auto iter = begin(minimizer); iter != end(minimizer); ++iter) {
+                expected.emplace_back(b + iter.position(), *iter);
+            }
+        }
+        auto result = std::vector<std::pair<size_t, size_t>>{};
+        for (auto iter = begin(view); iter != end(view); ++iter) {
+            result.emplace_back(iter.position(), *iter);
+        }
+        assert(result == expected);
+    }
+}
+
+void test_n_compressed_sequence() {
+    auto input = std::string{"NNNNACGTTGCANNNNNNNNGATTACARYACGTACGTNNACGTAN"};
+    auto ranks = ivs::convert_char_to_rank<ivs::iupac>(input);
+    auto seq = ivs::n_compressed_sequence{ranks};
+    assert(seq.size() == input.size());
+    assert((seq.gaps == std::vector<ivs::interval>{{0, 4}, {12, 20}, {37, 39}, {44, 45}}));
+    assert((seq.exceptions == std::vector<ivs::n_compressed_sequence::exception>{{27, 5}, {28, 6}}));
+
+    // random access and region extraction
+    for (size_t i{0}; i < input.size(); ++i) {
+        assert(seq[i] == ranks[i]);
+    }
+    assert(seq.extract(0, input.size()) == ranks);
+    for (size_t b{0}; b < input.size(); b += 5) {
+        for (size_t e{b}; e <= input.size(); e += 3) {
+            assert(seq.extract_char(b, e - b) == input.substr(b, e - b));
+        }
+    }
+    auto dna5 = seq.extract_char<ivs::dna5>(20, 12);
+    assert(dna5 == "GATTACANNACG");
+
+    // appending continues gaps
+    auto appended = ivs::n_compressed_sequence{std::span{ranks}.subspan(0, 15)};
+    appended.append(std::span{ranks}.subspan(15));
+    assert(appended.gaps == seq.gaps);
+    assert(appended.exceptions == seq.exceptions);
+    assert(appended.extract(0, input.size()) == ranks);
+
+    assert((seq.unknown_intervals() == std::vector<ivs::interval>{{0, 4}, {12, 20}, {27, 29}, {37, 39}, {44, 45}}));
+
+    // k-mers skip all non ACGT positions
+    {
+        auto expected = std::vector<std::pair<size_t, size_t>>{};
+        auto dna4 = ivs::convert_char_to_rank<ivs::dna4>(input);
+        auto encoding = ivs::compact_encoding<ivs::dna4>{dna4, 4};
+        for (auto iter = begin(encoding); iter != nullptr; ++iter) {
+            auto p = iter.position();
+            auto valid = std::all_of(ranks.begin() + p, ranks.begin() + p + 4, [](uint8_t r) { return r < 4; });
+            if (valid) {
+                expected.emplace_back(p, *iter);
+            }
+        }
+        auto kmers = seq.kmers(4);
+        auto result = std::vector<std::pair<size_t, size_t>>{};
+        for (auto iter = begin(kmers); iter != end(kmers); ++iter) {
+            result.emplace_back(iter.position(), *iter);
+        }
+        assert(result == expected);
+    }
+
+    // minimizers
+    {
+        auto minimizers = seq.minimizers(3, 2);
+        auto bases = seq.bases.unpack();
+        auto masked = ivs::masked_winnowing_minimizer<ivs::dna4>{bases, seq.unknown_intervals(), 3, 2};
+        auto result   = std::vector<std::pair<size_t, size_t>>{};
+        auto expected = std::vector<std::pair<size_t, size_t>>{};
+        for (auto iter = begin(minimizers); iter != end(minimizers); ++iter) {
+            result.emplace_back(iter.position(), *iter);
+        }
+        for (auto iter = begin(masked); iter != end(masked); ++iter) {
+            expected.emplace_back(iter.position(), *iter);
+        }
+        assert(!result.empty());
+        assert(result == expected);
+    }
+}
+
+struct two_bins {
+    static constexpr auto bins = std::array<ivs::quality_bin, 2>{{{-5, 0}, {20, 30}}};
+};
+
+void test_quality_binning() {
+    using bins8 = ivs::quality_bin_alphabet<ivs::pthred42, ivs::illumina8_binning>;
+    using bins4 = ivs::quality_bin_alphabet<ivs::pthred42, ivs::illumina4_binning>;
+    static_assert(ivs::alphabet_c<bins8>);
+    static_assert(bins8::size() == 8);
+    static_assert(ivs::packed_bits<bins8> == 3);
+    static_assert(ivs::packed_bits<bins4> == 2);
+
+    auto input = std::string{};
+    for (int i{0}; i < 42; ++i) {
+        input += static_cast<char>('!' + i);
+    }
+    input += " ~";
+
+    // bin indices, by kernel and by alphabet
+    auto expected8 = std::vector<uint8_t>{0, 0, 1, 1, 1, 1, 1, 1, 1, 1, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2,
+                                          3, 3, 3, 3, 3, 4, 4, 4, 4, 4, 5, 5, 5, 5, 5, 6, 6, 6, 6, 6,
+                                          7, 7, 255, 255};
+    assert((ivs::quality_char_to_bin<ivs::pthred42, ivs::illumina8_binning>(input) == expected8));
+    assert(ivs::convert_char_to_rank<bins8>(input) == expected8);
+    assert(std::ranges::equal(input | ivs::view_quality_char_to_bin<ivs::pthred42, ivs::illumina8_binning>, expected8));
+
+    // binned chars
+    auto binned = ivs::bin_quality_char<ivs::pthred42, ivs::illumina4_binning>(input);
+    assert(binned == ivs::normalize_char<bins4>(input));
+    assert(std::ranges::equal(binned, input | ivs::view_bin_quality_char<ivs::pthred42, ivs::illumina4_binning>));
+    assert(binned.substr(0, 5) == "###--");
+    assert(binned[14] == '-' and binned[15] == '8' and binned[30] == '8' and binned[31] == 'F');
+    assert(binned[42] == '\0' and binned[43] == '\0');
+
+    // custom scheme over a solexa alphabet
+    assert((ivs::quality_char_to_bin<ivs::pthred68solexa, two_bins>(std::string{";@STh "}) == std::vector<uint8_t>{0, 0, 0, 1, 1, 255}));
+    assert((ivs::bin_quality_char<ivs::pthred68solexa, two_bins>(std::string{";T"}) == "@^"));
+
+    // packed storage of bins
+    {
+        auto qualities = std::string{"IIIIIIIIIIIIHHHHHHHHH?????::::::::::,,,,,,##"};
+        auto bins = ivs::quality_char_to_bin<ivs::pthred42, ivs::illumina8_binning>(qualities);
+        auto packed = ivs::packed_sequence<bins8>{bins};
+        assert(packed.words.size() == 3);
+        assert(packed.unpack() == bins);
+        assert((ivs::convert_rank_to_char<bins8>(packed.unpack()) == ivs::bin_quality_char<ivs::pthred42, ivs::illumina8_binning>(qualities)));
+
+        auto rle = ivs::run_length_sequence<bins8>{bins};
+        assert(rle.size() == bins.size());
+        assert(rle.runs() == 6);
+        assert(rle.unpack() == bins);
+        for (size_t i{0}; i < bins.size(); ++i) {
+            assert(rle[i] == bins[i]);
+        }
+        auto region = std::vector<uint8_t>(20);
+        rle.unpack(7, region);
+        assert(std::ranges::equal(region, std::span{bins}.subspan(7, 20)));
+    }
+
+    // run length sequence
+    {
+        auto rle = ivs::run_length_sequence<ivs::dna4, uint16_t>{};
+        assert(rle.empty() and rle.size() == 0);
+        rle.append(std::vector<uint8_t>{0, 0, 1});
+        rle.push_back(1);
+        rle.append(std::vector<uint8_t>{1, 2});
+        assert((rle.ranks == std::vector<uint8_t>{0, 1, 2}));
+        assert((rle.ends == std::vector<uint16_t>{2, 5, 6}));
+        assert((rle.unpack() == std::vector<uint8_t>{0, 0, 1, 1, 1, 2}));
+        rle.clear();
+        assert(rle.empty());
+    }
+}
+
+void test_quality_filter() {
+    auto sequence = std::string{"ACGTTGCAACGTAGCTAGCTAGGATCCATGACGT"};
+    auto quality  = std::string{"IIIIIIII#IIIIIIIII5555IIIIII+IIIII"};
+    auto values    = ivs::convert_char_to_rank<ivs::dna4>(sequence);
+    auto qualities = ivs::convert_char_to_rank<ivs::pthred42>(quality);
+    size_t k = 5;
+
+    // reference: all k-mers with their quality statistics computed naively
+    auto reference = [&](ivs::kmer_quality_filter filter) {
+        auto res = std::vector<std::pair<size_t, size_t>>{};
+        auto encoding = ivs::compact_encoding<ivs::dna4>{values, k};
+        for (auto iter = begin(encoding); iter != nullptr; ++iter) {
+            auto p = iter.position();
+            auto stats = ivs::compute_quality_statistics<ivs::pthred42>(std::string_view{quality}.substr(p, k));
+            if (stats.min >= filter.min_quality and stats.expected_errors <= filter.max_expected_errors) {
+                res.emplace_back(p, *iter);
+            }
+        }
+        return res;
+    };
+    auto collect = [](auto const& view) {
+        auto res = std::vector<std::pair<size_t, size_t>>{};
+        for (auto iter = begin(view); iter != end(view); ++iter) {
+            res.emplace_back(iter.position(), *iter);
+        }
+        return res;
+    };
+
+    for (auto filter : std::vector<ivs::kmer_quality_filter>{{0}, {10}, {20}, {30}, {41}, {0, 0.01}, {0, 0.1}, {0, 0.5}, {10, 0.01}}) {
+        auto expected = reference(filter);
+        auto view = ivs::quality_filtered_compact_encoding<ivs::dna4, ivs::pthred42>{values, qualities, k, filter};
+        assert(collect(view) == expected);
+        assert(view.size() == expected.size());
+
+        // minimum quality via masking
+        if (filter.max_expected_errors == std::numeric_limits<double>::infinity()) {
+            auto masked = ivs::masked_compact_encoding<ivs::dna4>{values, ivs::low_quality_intervals(qualities, filter.min_quality), k};
+            assert(collect(masked) == expected);
+        }
+    }
+    assert((ivs::low_quality_intervals(qualities, 30) == std::vector<ivs::interval>{{8, 9}, {18, 22}, {28, 29}}));
+
+    // everything filtered
+    {
+        auto view = ivs::quality_filtered_compact_encoding<ivs::dna4, ivs::pthred42>{values, qualities, k, {42}};
+        assert(begin(view) == end(view));
+    }
+
+    // minimizers over k-mers passing the filter
+    {
+        auto filter = ivs::kmer_quality_filter{20};
+        auto encoding = ivs::quality_filtered_compact_encoding<ivs::dna4, ivs::pthred42>{values, qualities, 3, filter};
+        auto view = ivs::quality_filtered_winnowing_minimizer<ivs::dna4, ivs::pthred42>{encoding, 4};
+
+        // every window of passing k-mers contains a reported minimizer with the smallest value
+        auto kmers = collect(encoding);
+        auto result = collect(view);
+        assert(!result.empty());
+        for (auto m : result) {
+            assert(std::ranges::find(kmers, m) != kmers.end());
+        }
+        for (size_t i{0}; i + 4 <= kmers.size(); ++i) {
+            auto window = std::span{kmers}.subspan(i, 4);
+            auto minValue = std::ranges::min(window | std::views::values);
+            auto found = std::ranges::any_of(window, [&](auto kmer) {
+                return kmer.second == minValue and std::ranges::find(result, kmer) != result.end();
+            });
+            assert(found);
+        }
+
+        // without filtering the result is identical to winnowing_minimizer
+        auto unfiltered = ivs::quality_filtered_compact_encoding<ivs::dna4, ivs::pthred42>{values, qualities, 3, {}};
+        auto plain      = ivs::winnowing_minimizer<ivs::dna4>{values, 3, 4};
+        assert(collect(ivs::quality_filtered_winnowing_minimizer<ivs::dna4, ivs::pthred42>{unfiltered, 4}) == collect(plain));
+    }
+
+    // long sequences, the error sum of the window does not drift
+    {
+        auto longValues    = random_ranks(13, 1, 200'000)[0];
+        auto longQualities = random_ranks(14, 1, 200'000)[0];
+        for (size_t i{0}; i < longQualities.size(); ++i) {
+            longQualities[i] = static_cast<uint8_t>(i % 1000 < 500 ? 2 + longQualities[i] : 30 + longQualities[i] * 3);
+        }
+        auto filter   = ivs::kmer_quality_filter{0, 0.05};
+        auto view     = ivs::quality_filtered_compact_encoding<ivs::dna4, ivs::pthred42>{longValues, longQualities, 21, filter};
+        auto expected = std::vector<size_t>{};
+        for (size_t p{0}; p + 21 <= longValues.size(); ++p) {
+            auto stats = ivs::compute_quality_statistics<ivs::pthred42>(std::span{longQualities}.subspan(p, 21));
+            if (stats.expected_errors <= filter.max_expected_errors) expected.push_back(p);
+        }
+        auto positions = std::vector<size_t>{};
+        for (auto iter = begin(view); iter != end(view); ++iter) positions.push_back(iter.position());
+        assert(!positions.empty() and positions.back() == longValues.size() - 21);
+        assert(positions == expected);
+    }
+}
+
+void test_trimming() {
+    auto quality = [](std::string const& s) { return ivs::convert_char_to_rank<ivs::pthred42>(s); };
+    auto dna5    = [](std::string const& s) { return ivs::convert_char_to_rank<ivs::dna5>(s); };
+
+    // quality trimming
+    assert(ivs::quality_trim_3prime(quality("IIIIIIIIII"), 20) == 10);
+    assert(ivs::quality_trim_3prime(quality("IIIIIIII##"), 20) == 8);
+    assert(ivs::quality_trim_3prime(quality("IIIII#I###"), 20) == 7);
+    assert(ivs::quality_trim_3prime(quality("##########"), 20) == 0);
+    assert(ivs::quality_trim_3prime(quality(""), 20) == 0);
+    assert(ivs::quality_trim_5prime(quality("##IIIIIIII"), 20) == 2);
+    assert(ivs::quality_trim_5prime(quality("IIIIIIIIII"), 20) == 0);
+    // bwa example: a good base does not stop trimming, if it is followed by bad bases
+    assert(ivs::quality_trim_3prime(quality("IIIIII##5###"), 15) == 6);
+
+    // poly tail trimming
+    assert(ivs::poly_tail_trim(dna5("ACGTACGTAAAAAAAA"), 0) == 8);
+    assert(ivs::poly_tail_trim(dna5("ACGTACGTAAAACAAAAAAA"), 0) == 8);
+    assert(ivs::poly_tail_trim(dna5("ACGTACGTGGGGGG"), 0) == 14);
+    assert(ivs::poly_tail_trim(dna5("ACGTACGTGGGGGG"), 2) == 8);
+    assert(ivs::poly_tail_trim(dna5("AAAA"), 0) == 0);
+
+    // adapter search
+    {
+        auto adapterSeq = std::string{"AGATCGGAAGAGCACACGTCTGAACTCCAGTCACGATCAGT"};
+        auto insert     = std::string{"TTGCCATGCAGTTACCTGATCGTAGCTTAGCGGATCCTAGTCCAGTTAGC"};
+        auto finder = ivs::adapter_finder{dna5(adapterSeq), 3, 0.1};
+
+        // no adapter
+        assert(finder.find(dna5(insert)) == insert.size());
+        // full adapter
+        assert(finder.find(dna5(insert + adapterSeq + "ACGT")) == insert.size());
+        // partial adapter at the end
+        assert(finder.find(dna5(insert + adapterSeq.substr(0, 10))) == insert.size());
+        assert(finder.find(dna5(insert + adapterSeq.substr(0, 3))) == insert.size());
+        assert(finder.find(dna5(insert + adapterSeq.substr(0, 2))) == insert.size() + 2);
+        // mismatches and N
+        auto mutated = adapterSeq;
+        mutated[5]  = 'T';
+        mutated[20] = 'N';
+        mutated[35] = 'C';
+        assert(finder.find(dna5(insert + mutated)) == insert.size());
+        mutated[30] = 'N';
+        mutated[10] = 'C';
+        assert(finder.find(dna5(insert + mutated)) > insert.size());
+
+        // an empty adapter is never found
+        auto empty = ivs::adapter_finder{std::vector<uint8_t>{}, 0};
+        assert(empty.find(dna5(insert)) == insert.size());
+        assert(ivs::adapter_finder{}.find(dna5(insert)) == insert.size());
+        assert(ivs::adapter_finder{}.find(std::vector<uint8_t>{}) == 0);
+        assert((ivs::read_trimmer{.adapter = empty}.trim(dna5(insert)) == ivs::interval{0, insert.size()}));
+
+        // compare against a naive search at many lengths and offsets
+        for (size_t len{0}; len < adapterSeq.size() + 40; len += 3) {
+            auto read = dna5((insert + insert + adapterSeq + insert).substr(7, len + 30));
+            auto adapter = dna5(adapterSeq);
+            auto expected = read.size();
+            for (size_t p{0}; p + 3 <= read.size(); ++p) {
+                auto overlap = std::min(adapter.size(), read.size() - p);
+                size_t mismatches{0};
+                for (size_t i{0}; i < overlap; ++i) {
+                    mismatches += read[p+i] != adapter[i] or read[p+i] > 3;
+                }
+                if (mismatches <= static_cast<size_t>(overlap * 0.1)) {
+                    expected = p;
+                    break;
+                }
+            }
+            assert(finder.find(read) == expected);
+        }
+    }
+
+    // combined trimming on a batch
+    {
+        auto trimmer = ivs::read_trimmer{};
+        trimmer.quality_threshold_3prime = 20;
+        trimmer.adapter   = ivs::adapter_finder{dna5("AGATCGGAAGAGC")};
+        trimmer.poly_tail = 2; // poly-G
+
+        auto reads = std::vector<std::vector<uint8_t>>{
+            dna5("ACGTTGCAACGTAGCTAGCT"),
+            dna5("ACGTTGCAACGTAGATCGGAAGAGCGG"),
+            dna5("ACGTTGCAACGTGGGGGGGGGGGGGG"),
+            dna5("ACGTTGCAACGTAGCTAGCT"),
+        };
+        auto qualities = std::vector<std::vector<uint8_t>>{
+            quality("IIIIIIIIIIIIIIIIIIII"),
+            quality("IIIIIIIIIIIIIIIIIIIIIIIIIII"),
+            quality("IIIIIIIIIIIIIIIIIIIIIIIIII"),
+            quality("IIIIIIIIIIIIIII#####"),
+        };
+        auto valueSpans   = std::vector<std::span<uint8_t const>>(reads.begin(), reads.end());
+        auto qualitySpans = std::vector<std::span<uint8_t const>>(qualities.begin(), qualities.end());
+        auto result = std::vector<ivs::interval>(reads.size());
+        trimmer.trim(valueSpans, qualitySpans, result);
+        assert((result == std::vector<ivs::interval>{{0, 20}, {0, 12}, {0, 12}, {0, 15}}));
+
+        // without qualities only adapter and poly tail are trimmed
+        trimmer.quality_threshold_5prime = 20;
+        trimmer.trim(valueSpans, {}, result);
+        assert((result == std::vector<ivs::interval>{{0, 20}, {0, 12}, {0, 12}, {0, 20}}));
+        assert((trimmer.trim(reads[3]) == ivs::interval{0, 20}));
+    }
+}
+
+void test_read_batch() {
+    auto sequences = std::vector<std::string_view>{"ACGTTGCAAC", "", "GGATCCNNACGT", "TTAGC"};
+    auto qualities = std::vector<std::string_view>{"IIIIIIII##", "", "IIII5555IIII", "+++++"};
+    auto names     = std::vector<std::string_view>{"read1", "read2", "read3", "r4"};
+
+    auto batch = ivs::read_batch<ivs::dna5, ivs::pthred42>{};
+    batch.assign(sequences, qualities, names);
+    assert(batch.size() == 4);
+    assert(batch.total_length() == 27);
+    assert(batch.has_qualities());
+    assert((batch.offsets == std::vector<size_t>{0, 10, 10, 22, 27}));
+    for (size_t i{0}; i < batch.size(); ++i) {
+        assert(std::ranges::equal(batch.sequence(i), ivs::convert_char_to_rank<ivs::dna5>(sequences[i])));
+        assert(std::ranges::equal(batch.quality(i), ivs::convert_char_to_rank<ivs::pthred42>(qualities[i])));
+        assert(batch.name(i) == names[i]);
+        assert(batch[i].name == names[i]);
+    }
+    assert((batch.locate(0) == std::pair<size_t, size_t>{0, 0}));
+    assert((batch.locate(12) == std::pair<size_t, size_t>{2, 2}));
+    assert((batch.locate(26) == std::pair<size_t, size_t>{3, 4}));
+
+    // invalid quality chars are rejected
+    {
+        auto copy = batch;
+        bool thrown{false};
+        try {
+            copy.push_back(std::string_view{"ACGT"}, std::string_view{"II~I"}, "bad");
+        } catch (std::runtime_error const&) {
+            thrown = true;
+        }
+        assert(thrown);
+        assert(copy.ranks == batch.ranks and copy.qualities == batch.qualities and copy.offsets == batch.offsets);
+    }
+
+    // reads with and without qualities can not be mixed, qualities must match the sequence
+    {
+        auto withoutQualities = ivs::read_batch<ivs::dna5, ivs::pthred42>{};
+        withoutQualities.push_back(std::string_view{"ACGT"});
+        withoutQualities.push_back(std::string_view{""}, std::string_view{""}, "empty");
+        auto appendFails = [](auto batch, std::string_view sequence, std::string_view quality) {
+            auto copy = batch;
+            bool thrown{false};
+            try {
+                batch.push_back(sequence, quality, "read");
+            } catch (std::runtime_error const&) {
+                thrown = true;
+                assert(batch.ranks == copy.ranks and batch.qualities == copy.qualities and batch.offsets == copy.offsets);
+            }
+            return thrown;
+        };
+        assert(appendFails(batch, "ACGT", ""));
+        assert(appendFails(batch, "ACGT", "III"));
+        assert(appendFails(withoutQualities, "ACGT", "IIII"));
+        assert(!appendFails(batch, "", ""));
+        assert(!appendFails(withoutQualities, "ACGT", ""));
+    }
+
+    // iteration
+    size_t count{0};
+    for (auto read : batch) {
+        assert(read.values.size() == sequences[count].size());
+        ++count;
+    }
+    assert(count == batch.size());
+
+    // bulk functions over all reads at once
+    auto complement = ivs::complement_rank<ivs::dna5>(batch.ranks);
+    assert(complement.size() == batch.total_length());
+
+    // k-mers never span two reads
+    {
+        auto kmers = batch.kmers(4);
+        auto result = std::vector<std::tuple<size_t, size_t, size_t>>{};
+        for (auto iter = begin(kmers); iter != end(kmers); ++iter) {
+            auto [read, pos] = batch.locate(iter.position());
+            result.emplace_back(read, pos, *iter);
+        }
+        auto expected = std::vector<std::tuple<size_t, size_t, size_t>>{};
+        for (size_t i{0}; i < batch.size(); ++i) {
+            auto encoding = ivs::compact_encoding<ivs::dna5>{batch.sequence(i), 4};
+            for (auto iter = begin(encoding); iter != end(encoding); ++iter) {
+                expected.emplace_back(i, iter.position(), *iter);
+            }
+        }
+        assert(result == expected);
+        assert(kmers.size() == 7 + 9 + 2);
+    }
+
+    // statistics and trimming on the whole batch
+    {
+        auto stats = std::vector<ivs::quality_statistics>(batch.size());
+        ivs::compute_quality_statistics(batch, stats);
+        assert(stats[0].min == 2 and stats[1].length == 0 and stats[2].min == 20 and stats[3].sum == 50);
+
+        auto trimmer = ivs::read_trimmer{};
+        trimmer.quality_threshold_3prime = 20;
+        auto result = std::vector<ivs::interval>(batch.size());
+        trimmer.trim(batch, result);
+        assert((result == std::vector<ivs::interval>{{0, 8}, {0, 0}, {0, 12}, {0, 0}}));
+    }
+
+    // reuse keeps the buffers
+    {
+        auto capacity = batch.ranks.capacity();
+        auto data     = batch.ranks.data();
+        batch.clear();
+        assert(batch.empty() and batch.total_length() == 0);
+        batch.push_back(std::string_view{"ACGT"});
+        batch.push_back(std::string_view{"TTT"}, {}, "x");
+        assert(batch.size() == 2 and !batch.has_qualities());
+        assert(batch.quality(0).empty());
+        assert(batch.name(0).empty() and batch.name(1) == "x");
+        assert(batch.ranks.capacity() == capacity and batch.ranks.data() == data);
+    }
+}
+
+void test_fastx_reader() {
+    // lines
+    {
+        auto out = std::vector<uint8_t>{};
+        ivs::convert_lines_to_rank<ivs::dna5>(std::string_view{"ACG\nTN\r\n\nA"}, out);
+        assert((out == std::vector<uint8_t>{0, 1, 2, 3, 4, 0}));
+        auto qual = std::vector<uint8_t>{};
+        assert(ivs::decode_phred_lines<ivs::pthred42>(std::string_view{"!#\n+"}, qual));
+        assert((qual == std::vector<uint8_t>{0, 2, 10}));
+    }
+
+    auto fasta = std::string{
+        ">seq1 first\nACGT\nTT\n"
+        ">seq2\r\nGGNN\r\n\n"
+        ">empty\n"};
+    auto fastq = std::string{
+        "@read1\nACGTA\n+\nII#@I\n"
+        "@read2\nAC\nGT\n+read2\n@I\nII\n"
+        "@read3\nTTT\n+\n@@@"};
+
+    // parser
+    {
+        auto records = std::vector<ivs::fastx_record>{};
+        for (auto const& text : {std::span<char const>{fasta}, std::span<char const>{fastq}}) {
+            auto parser = ivs::fastx_parser{text};
+            for (auto iter = begin(parser); iter != end(parser); ++iter) {
+                records.push_back(*iter);
+            }
+        }
+        assert(records.size() == 6);
+        auto str = [](std::span<char const> s) { return std::string{s.begin(), s.end()}; };
+        assert(records[0].name == "seq1 first" and str(records[0].sequence) == "ACGT\nTT" and records[0].line_breaks and records[0].quality.empty());
+        assert(records[1].name == "seq2" and str(records[1].sequence) == "GGNN" and !records[1].line_breaks);
+        assert(records[2].name == "empty" and records[2].sequence.empty());
+        assert(records[3].name == "read1" and str(records[3].sequence) == "ACGTA" and str(records[3].quality) == "II#@I" and !records[3].line_breaks);
+        assert(records[4].name == "read2" and str(records[4].quality) == "@I\nII" and records[4].line_breaks);
+        assert(records[5].name == "read3" and str(records[5].quality) == "@@@");
+
+        // zero copy without line breaks
+        auto buffer = std::vector<char>{};
+        assert(records[1].sequence_chars(buffer).data() == records[1].sequence.data());
+        assert(str(records[0].sequence_chars(buffer)) == "ACGTTT");
+        assert(str(records[4].sequence_chars(buffer)) == "ACGT");
+    }
+
+    // malformed input
+    for (auto bad : {std::string{"ACGT\n"}, std::string{"@r\nACGT\n"}, std::string{"@r\nACGT\n+\nII\n"}}) {
+        bool thrown{false};
+        try {
+            auto parser = ivs::fastx_parser{bad};
+            auto record = ivs::fastx_record{};
+            while (parser.next(record));
+        } catch (std::runtime_error const&) {
+            thrown = true;
+        }
+        assert(thrown);
+    }
+
+    // read from a mapped file into read batches
+    {
+        auto path = std::filesystem::temp_directory_path() / "ivsigma_test_fastx_reader.fq";
+        {
+            auto ofs = std::ofstream{path, std::ios::binary};
+            ofs << fastq;
+        }
+        auto reader = ivs::fastx_reader{path};
+        auto batch  = ivs::read_batch<ivs::dna5, ivs::pthred42>{};
+        assert(ivs::read_batch_from(reader, batch, 2) == 2);
+        assert(batch.has_qualities());
+        assert((batch.offsets == std::vector<size_t>{0, 5, 9}));
+        assert(std::ranges::equal(batch.sequence(1), ivs::convert_char_to_rank<ivs::dna5>(std::string{"ACGT"})));
+        assert(std::ranges::equal(batch.quality(1), ivs::decode_phred<ivs::pthred42>(std::string{"@III"})));
+        assert(batch.name(1) == "read2");
+        assert(ivs::read_batch_from(reader, batch, 2) == 1);
+        assert(batch.name(0) == "read3" and batch.quality(0)[0] == 31);
+        assert(ivs::read_batch_from(reader, batch, 2) == 0);
+        std::filesystem::remove(path);
+
+        // invalid quality chars throw and leave the batch unchanged, single and multi line records
+        // and so do qualities of a different length and records without qualities
+        for (auto text : {std::string{"@ok\nACGT\n+\nIIII\n@bad\nACGT\n+\nII~I\n"},
+                          std::string{"@ok\nACGT\n+\nIIII\n@bad\nAC\nGT\n+\nII\n~I\n"},
+                          std::string{"@ok\nACGT\n+\nIIII\n@bad\nAC\nGT\n+\nII\nI\n"},
+                          std::string{"@ok\nACGT\n+\nIIII\n>bad\nAC\nGT\n"}}) {
+            auto parser = ivs::fastx_parser{text};
+            bool thrown{false};
+            try {
+                ivs::read_batch_from(parser, batch, 10);
+            } catch (std::runtime_error const&) {
+                thrown = true;
+            }
+            assert(thrown);
+            assert(batch.size() == 1 and batch.total_length() == 4 and batch.qualities.size() == 4);
+        }
+
+        bool thrown{false};
+        try {
+            auto missing = ivs::mapped_file{path};
+        } catch (std::runtime_error const&) {
+            thrown = true;
+        }
+        assert(thrown);
+    }
+}
+
+namespace {
+// gzip member consisting of stored deflate blocks, with BGZF extra field
+auto make_bgzf_member(std::span<char const> text) -> std::vector<uint8_t> {
+    auto out = std::vector<uint8_t>{0x1f, 0x8b, 8, 4, 0, 0, 0, 0, 0, 0xff, 6, 0, 'B', 'C', 2, 0, 0, 0};
+    size_t p{0};
+    do {
+        auto len = std::min<size_t>(text.size() - p, 1000);
+        out.push_back(p + len == text.size() ? 1 : 0);
+        for (auto v : {len, len ^ 0xffff}) {
+            out.push_back(v & 0xff);
+            out.push_back((v >> 8) & 0xff);
+        }
+        out.insert(out.end(), text.begin() + p, text.begin() + p + len);
+        p += len;
+    } while (p < text.size());
+    for (auto v : {ivs::detail::crc32::compute(text), static_cast<uint32_t>(text.size())}) {
+        for (size_t i{0}; i < 4; ++i) out.push_back((v >> (i*8)) & 0xff);
+    }
+    out[16] = (out.size() - 1) & 0xff;
+    out[17] = (out.size() - 1) >> 8;
+    return out;
+}
+}
+
+void test_gzip_reader() {
+    // fixed huffman codes
+    auto small = std::vector<uint8_t>{
+        0x1f, 0x8b, 0x08, 0x00, 0x00, 0x00, 0x00, 0x00, 0x02, 0x03, 0xb3, 0x2b, 0xe6, 0x72, 0x74, 0x76, 0x0f, 0x41, 0xc6, 0x7e, 0x40, 0xc0, 0x05, 0x00,
+        0x75, 0x35, 0x37, 0x04, 0x18, 0x00, 0x00, 0x00,
+    };
+    // dynamic huffman codes with long back references, decompresses to 100 times ">s\n" + block + "\n"
+    auto big = std::vector<uint8_t>{
+        0x1f, 0x8b, 0x08, 0x00, 0x00, 0x00, 0x00, 0x00, 0x02, 0x03, 0xed, 0xd3, 0xcb, 0x6d, 0x1c, 0x31, 0x10, 0x05, 0xc0, 0xbb, 0x82, 0x12, 0xd0, 0xe0,
+        0x81, 0x09, 0x30, 0x13, 0xe7, 0x0f, 0x98, 0xef, 0x71, 0xa5, 0x04, 0x74, 0x2d, 0xac, 0xed, 0x1d, 0xcf, 0x92, 0xcd, 0xfe, 0xb0, 0xbe, 0xff, 0x7d,
+        0xed, 0xbd, 0xce, 0x39, 0xfb, 0xcc, 0xfd, 0x9e, 0x59, 0xe7, 0x7e, 0xf6, 0xde, 0x7d, 0xb5, 0xf6, 0x7d, 0x91, 0xe7, 0xbd, 0xd6, 0xe4, 0xb7, 0xfb,
+        0x70, 0xee, 0xfa, 0x99, 0x93, 0x25, 0xab, 0x1b, 0xef, 0xce, 0x95, 0x1d, 0x7b, 0xee, 0x9f, 0xfb, 0x74, 0xfa, 0xfb, 0x59, 0x73, 0x3f, 0x6b, 0x6e,
+        0x8c, 0xfb, 0x7b, 0x5e, 0xf6, 0x6f, 0xff, 0x73, 0xc3, 0xde, 0x95, 0x77, 0x79, 0x56, 0x27, 0xf6, 0xce, 0x39, 0x77, 0x53, 0x4e, 0xef, 0xfa, 0x93,
+        0xc8, 0x2b, 0x01, 0x72, 0x46, 0xb6, 0x65, 0x49, 0x33, 0x6d, 0xf0, 0xdd, 0x64, 0x6e, 0xf4, 0x9d, 0x73, 0x92, 0x71, 0x9e, 0x53, 0xc0, 0x4b, 0x26,
+        0x0b, 0x6e, 0xe8, 0xc9, 0x51, 0xf7, 0x55, 0x96, 0xf6, 0xdd, 0x0d, 0x7e, 0xf7, 0x4d, 0x42, 0x4c, 0x72, 0x39, 0xcd, 0xbc, 0x07, 0xa6, 0xac, 0x54,
+        0xb4, 0x93, 0x69, 0x56, 0x26, 0x89, 0xf4, 0xe4, 0xb4, 0xac, 0x97, 0xe9, 0x6b, 0xc9, 0x5d, 0x7e, 0xd3, 0x3d, 0x8d, 0xdb, 0xbe, 0xad, 0xf5, 0x53,
+        0xf2, 0x3a, 0x9f, 0xd2, 0xa7, 0xab, 0xcf, 0x6a, 0xa3, 0xa6, 0x89, 0xa4, 0xcc, 0x1b, 0x76, 0x9d, 0x9f, 0xa0, 0xb7, 0x0b, 0x2d, 0xa7, 0xdd, 0xdb,
+        0xed, 0x57, 0xd6, 0x25, 0x70, 0xea, 0x6f, 0x25, 0x93, 0x17, 0x2b, 0xf9, 0xaf, 0xee, 0x6c, 0xcf, 0x3b, 0x88, 0x94, 0xdd, 0x44, 0x6e, 0x37, 0x6f,
+        0x12, 0xad, 0xa0, 0xc3, 0x9a, 0x37, 0xca, 0xd5, 0xf4, 0x27, 0xad, 0x7e, 0x43, 0x4b, 0xb0, 0xa6, 0x72, 0x92, 0xef, 0xe9, 0x67, 0x1a, 0xa6, 0xb3,
+        0x4c, 0xca, 0xaf, 0xfa, 0xd7, 0x9b, 0x0e, 0x79, 0x75, 0xac, 0xeb, 0xed, 0xca, 0xfe, 0x24, 0xb2, 0xdf, 0x98, 0x4e, 0x67, 0xd0, 0xe6, 0xf7, 0xe0,
+        0xa6, 0x37, 0xaf, 0xb0, 0x84, 0xcb, 0x61, 0x9f, 0x19, 0xac, 0x8e, 0x7b, 0x4f, 0xab, 0x7f, 0x9b, 0x5e, 0x15, 0x69, 0x79, 0xdb, 0x77, 0x76, 0x17,
+        0xbc, 0x51, 0x9f, 0xb6, 0xb9, 0x79, 0xe5, 0xa4, 0x14, 0x94, 0x49, 0x37, 0xe5, 0x04, 0xe8, 0xc1, 0xbd, 0xac, 0x2d, 0xb3, 0x67, 0x9c, 0xf9, 0x4c,
+        0xfd, 0xd3, 0xae, 0x2c, 0x9c, 0x7e, 0xf7, 0x4e, 0xbe, 0x6e, 0x27, 0xaf, 0xbe, 0x9b, 0xd7, 0xcf, 0xf4, 0x3f, 0x0d, 0x4d, 0xd3, 0x3a, 0x8c, 0x7c,
+        0x67, 0x7b, 0x6f, 0xca, 0x7a, 0xb7, 0xfe, 0x2d, 0x3c, 0x1d, 0xcc, 0xbc, 0x6c, 0xf6, 0x2b, 0x6d, 0x9a, 0xe0, 0xbc, 0x1b, 0xdf, 0x12, 0xd6, 0xa7,
+        0x93, 0xab, 0x1d, 0xe8, 0x71, 0xbb, 0xd7, 0x6d, 0xfd, 0x3c, 0xf6, 0x7e, 0x64, 0x79, 0xbb, 0xf1, 0x2e, 0x49, 0x86, 0xd4, 0xeb, 0x34, 0x9d, 0xe3,
+        0xfb, 0x27, 0x6d, 0x6e, 0xd0, 0x79, 0x77, 0x7f, 0x7e, 0xaf, 0x4f, 0x3a, 0xf5, 0xc8, 0xbd, 0x51, 0xf6, 0xb7, 0x78, 0xdd, 0x4d, 0x7e, 0x77, 0x48,
+        0xe7, 0x65, 0xff, 0x1b, 0x70, 0xbe, 0xbe, 0x59, 0x67, 0x9d, 0x75, 0xd6, 0x59, 0x67, 0x9d, 0x75, 0xd6, 0x59, 0x67, 0x9d, 0x75, 0xd6, 0x59, 0x67,
+        0x9d, 0x75, 0xd6, 0x59, 0x67, 0x9d, 0x75, 0xd6, 0x59, 0x67, 0x9d, 0x75, 0xd6, 0x59, 0x67, 0x9d, 0x75, 0xd6, 0x59, 0x67, 0x9d, 0x75, 0xd6, 0x59,
+        0x67, 0x9d, 0x75, 0xd6, 0x59, 0x67, 0x9d, 0x75, 0xd6, 0x59, 0x67, 0x9d, 0x75, 0xd6, 0x59, 0x67, 0x9d, 0x75, 0xd6, 0x59, 0x67, 0x9d, 0x75, 0xd6,
+        0x59, 0x67, 0x9d, 0x75, 0xd6, 0x59, 0x67, 0x9d, 0x75, 0xd6, 0x59, 0x67, 0x9d, 0x75, 0xd6, 0x59, 0x67, 0x9d, 0x75, 0xd6, 0x59, 0x67, 0x9d, 0x75,
+        0xd6, 0x59, 0x67, 0x9d, 0x75, 0xd6, 0x59, 0x67, 0x9d, 0x75, 0xd6, 0x59, 0x67, 0x9d, 0x75, 0xd6, 0x59, 0x67, 0x9d, 0x75, 0xd6, 0x59, 0x67, 0x9d,
+        0x75, 0xd6, 0x59, 0x67, 0x9d, 0x75, 0xd6, 0x59, 0x67, 0x9d, 0x75, 0xd6, 0x59, 0x67, 0x9d, 0x75, 0xd6, 0x59, 0x67, 0x9d, 0x75, 0xd6, 0x59, 0x67,
+        0x9d, 0x75, 0xd6, 0x59, 0x67, 0x9d, 0x75, 0xd6, 0x59, 0x67, 0x9d, 0x75, 0xd6, 0x59, 0x67, 0x9d, 0x75, 0xd6, 0x59, 0x67, 0x9d, 0x75, 0xd6, 0x59,
+        0x67, 0x9d, 0x75, 0xd6, 0x59, 0x67, 0x9d, 0x75, 0xd6, 0x59, 0x67, 0x9d, 0x75, 0xd6, 0x59, 0x67, 0x9d, 0x75, 0xd6, 0x59, 0x67, 0x9d, 0x75, 0xd6,
+        0x59, 0x67, 0x9d, 0x75, 0xd6, 0x59, 0x67, 0x9d, 0x75, 0xd6, 0x59, 0x67, 0x9d, 0x75, 0xd6, 0x59, 0x67, 0x9d, 0x75, 0xd6, 0x59, 0x67, 0x9d, 0x75,
+        0xd6, 0x59, 0x67, 0x9d, 0x75, 0xd6, 0x59, 0x67, 0x9d, 0x75, 0xd6, 0x59, 0x67, 0x9d, 0x75, 0xd6, 0x59, 0x67, 0x9d, 0x75, 0xd6, 0x59, 0x67, 0x9d,
+        0x75, 0xd6, 0x59, 0x67, 0x9d, 0x75, 0xd6, 0x59, 0x67, 0x9d, 0x75, 0xd6, 0x59, 0x67, 0x9d, 0x75, 0xd6, 0x59, 0x67, 0x9d, 0x75, 0xd6, 0x59, 0x67,
+        0x9d, 0x75, 0xd6, 0x59, 0x67, 0x9d, 0x75, 0xd6, 0x59, 0x67, 0x9d, 0x75, 0xd6, 0x59, 0x67, 0x9d, 0x75, 0xd6, 0x59, 0x67, 0x9d, 0x75, 0xd6, 0x59,
+        0x67, 0x9d, 0x75, 0xd6, 0x59, 0x67, 0x9d, 0x75, 0xd6, 0x59, 0x67, 0x9d, 0x75, 0xd6, 0x59, 0x67, 0x9d, 0x75, 0xd6, 0x59, 0x67, 0x9d, 0x75, 0xd6,
+        0x59, 0x67, 0x9d, 0x75, 0xd6, 0x59, 0x67, 0x9d, 0x75, 0xd6, 0x59, 0x67, 0x9d, 0x75, 0xd6, 0x59, 0x67, 0x9d, 0x75, 0xd6, 0x59, 0x67, 0x9d, 0x75,
+        0xd6, 0x59, 0x67, 0x9d, 0x75, 0xd6, 0x59, 0x67, 0x9d, 0x75, 0xd6, 0x59, 0x67, 0x9d, 0x75, 0xd6, 0x59, 0x67, 0x9d, 0x75, 0xd6, 0x59, 0x67, 0x9d,
+        0x75, 0xd6, 0x59, 0x67, 0x9d, 0x75, 0xd6, 0x59, 0x67, 0x9d, 0x75, 0xd6, 0x59, 0x67, 0x9d, 0x75, 0xd6, 0x59, 0x67, 0x9d, 0x75, 0xd6, 0x59, 0x67,
+        0x9d, 0x75, 0xd6, 0x59, 0x67, 0x9d, 0x75, 0xd6, 0x59, 0x67, 0x9d, 0x75, 0xd6, 0x59, 0x67, 0x9d, 0x75, 0xd6, 0x59, 0x67, 0x9d, 0x75, 0xd6, 0x59,
+        0x67, 0x9d, 0x75, 0xd6, 0x59, 0x67, 0x9d, 0x75, 0xd6, 0x59, 0x67, 0x9d, 0x75, 0xd6, 0x59, 0x67, 0x9d, 0x75, 0xd6, 0x59, 0x67, 0x9d, 0x75, 0xd6,
+        0x59, 0x67, 0x9d, 0x75, 0xd6, 0x59, 0x67, 0x9d, 0x75, 0xd6, 0x59, 0x67, 0x9d, 0x75, 0xd6, 0x59, 0x67, 0x9d, 0x75, 0xd6, 0x59, 0x67, 0x9d, 0x75,
+        0xd6, 0x59, 0x67, 0x9d, 0x75, 0xd6, 0x59, 0x67, 0x9d, 0x75, 0xd6, 0x59, 0x67, 0x9d, 0x75, 0xd6, 0x59, 0x67, 0x9d, 0x75, 0xd6, 0x59, 0x67, 0x9d,
+        0x75, 0xd6, 0x59, 0x67, 0x9d, 0x75, 0xd6, 0x59, 0xff, 0xb3, 0xf5, 0xff, 0x00, 0xc4, 0xbd, 0xca, 0x30, 0x88, 0x01, 0x00,
+    };
+    auto block = std::string{};
+    for (uint32_t i{0}, x{1}; i < 1000; ++i) {
+        x = x * 1103515245u + 12345u;
+        block += "ACGT"[(x >> 16) & 3];
+    }
+    auto bigText = std::string{};
+    for (size_t i{0}; i < 100; ++i) {
+        bigText += ">s\n" + block + "\n";
+    }
+    auto asChars = [](std::vector<uint8_t> const& v) {
+        return std::span{reinterpret_cast<char const*>(v.data()), v.size()};
+    };
+    auto str = [](std::span<char const> s) { return std::string{s.begin(), s.end()}; };
+
+    // single threaded
+    {
+        assert(ivs::is_gzip(asChars(small)) and !ivs::is_bgzf(asChars(small)));
+        assert(str(ivs::inflate_gzip(asChars(small))) == ">s\nACGTACGTACGTACGTNNNN\n");
+        assert(str(ivs::inflate_gzip(asChars(big))) == bigText);
+
+        // concatenated members
+        auto both = small;
+        both.insert(both.end(), big.begin(), big.end());
+        assert(str(ivs::inflate_gzip(asChars(both))) == ">s\nACGTACGTACGTACGTNNNN\n" + bigText);
+
+        // corrupt data
+        auto corrupt = big;
+        corrupt[corrupt.size() - 6] ^= 1; // crc
+        bool thrown{false};
+        try {
+            ivs::inflate_gzip(asChars(corrupt));
+        } catch (std::runtime_error const&) {
+            thrown = true;
+        }
+        assert(thrown);
+        assert(!ivs::is_gzip(std::string_view{">s\nACGT\n"}));
+    }
+
+    // plain gzip in small chunks, the deflate window is kept between chunks
+    for (size_t buffers : {1, 2, 8}) {
+        auto reader = ivs::gzip_reader{asChars(big), 4, buffers, 4096};
+        auto chunk  = std::vector<char>{};
+        auto result = std::string{};
+        size_t chunks{0};
+        while (reader.next(chunk)) {
+            result += str(chunk);
+            ++chunks;
+        }
+        assert(result == bigText);
+        assert(chunks > 10);
+    }
+
+    // BGZF, decompressed in parallel
+    {
+        auto bgzf = std::vector<uint8_t>{};
+        for (size_t p{0}; p < bigText.size(); p += 3000) {
+            auto member = make_bgzf_member(std::span{bigText}.subspan(p, std::min<size_t>(3000, bigText.size() - p)));
+            bgzf.insert(bgzf.end(), member.begin(), member.end());
+        }
+        auto eofBlock = make_bgzf_member({});
+        bgzf.insert(bgzf.end(), eofBlock.begin(), eofBlock.end());
+        assert(ivs::is_bgzf(asChars(bgzf)));
+        assert(str(ivs::inflate_gzip(asChars(bgzf))) == bigText);
+
+        for (size_t threads : {1, 3}) {
+            auto reader = ivs::gzip_reader{asChars(bgzf), threads, 2, 8000};
+            auto chunk  = std::vector<char>{};
+            auto result = std::string{};
+            while (reader.next(chunk)) {
+                result += str(chunk);
+            }
+            assert(result == bigText);
+        }
+
+        // reader destroyed before all chunks are consumed
+        {
+            auto reader = ivs::gzip_reader{asChars(bgzf), 3, 2, 8000};
+            auto chunk  = std::vector<char>{};
+            assert(reader.next(chunk));
+        }
+
+        // records crossing chunk boundaries
+        auto path = std::filesystem::temp_directory_path() / "ivsigma_test_gzip_reader.fa.gz";
+        {
+            auto ofs = std::ofstream{path, std::ios::binary};
+            ofs.write(asChars(bgzf).data(), bgzf.size());
+        }
+        auto reader = ivs::gzip_fastx_reader{path, 2, 2, 8000};
+        size_t count{0};
+        for (auto iter = begin(reader); iter != end(reader); ++iter) {
+            assert((*iter).name == "s");
+            assert(str((*iter).sequence) == block);
+            ++count;
+        }
+        assert(count == 100);
+        std::filesystem::remove(path);
+    }
+
+    // records much larger than a chunk, the parser continues where it stopped instead of rescanning
+    {
+        auto longSeq = std::string{};
+        for (size_t i{0}; i < 300'000; ++i) longSeq += "ACGT"[(i * 7 + i / 13) % 4];
+        auto fasta = std::string{">long\n"};
+        for (size_t p{0}; p < longSeq.size(); p += 60) fasta += longSeq.substr(p, 60) + "\n";
+        fasta += ">short\nACGT\n";
+        auto fastq = "@long\n" + longSeq + "\n+\n" + std::string(longSeq.size(), 'I') + "\n@short\nACGT\n+\nIIII\n";
+
+        for (auto const& text : {fasta, fastq}) {
+            auto bgzf = std::vector<uint8_t>{};
+            for (size_t p{0}; p < text.size(); p += 997) {
+                auto member = make_bgzf_member(std::span{text}.subspan(p, std::min<size_t>(997, text.size() - p)));
+                bgzf.insert(bgzf.end(), member.begin(), member.end());
+            }
+            auto path = std::filesystem::temp_directory_path() / "ivsigma_test_gzip_reader_long.fa.gz";
+            {
+                auto ofs = std::ofstream{path, std::ios::binary};
+                ofs.write(asChars(bgzf).data(), bgzf.size());
+            }
+            auto reader = ivs::gzip_fastx_reader{path, 2, 4, 1000};
+            auto record = ivs::fastx_record{};
+            assert(reader.next(record));
+            auto seq = str(record.sequence);
+            std::erase(seq, '\n');
+            assert(record.name == "long" and seq == longSeq);
+            assert(record.quality.empty() or str(record.quality) == std::string(longSeq.size(), 'I'));
+            assert(reader.next(record));
+            assert(record.name == "short" and str(record.sequence) == "ACGT");
+            assert(!reader.next(record));
+            std::filesystem::remove(path);
+
+            // growing a buffer in small steps gives the same records as parsing it at once
+            auto expected = std::vector<std::string>{};
+            for (auto r : ivs::fastx_parser{text}) expected.push_back(std::string{r.name} + str(r.sequence) + str(r.quality));
+            auto parser = ivs::fastx_parser{};
+            auto buffer = std::string{};
+            auto result = std::vector<std::string>{};
+            for (size_t p{0}; p < text.size(); p += 4999) {
+                buffer.erase(0, parser.pos);
+                buffer += text.substr(p, 4999);
+                parser.resume_with(buffer, p + 4999 >= text.size());
+                while (parser.next(record)) result.push_back(std::string{record.name} + str(record.sequence) + str(record.quality));
+            }
+            assert(result == expected);
+        }
+    }
+}
+
+void test_fastx_writer() {
+    auto seq  = ivs::convert_char_to_rank<ivs::dna5>(std::string{"ACGTNACGTA"});
+    auto qual = ivs::convert_char_to_rank<ivs::pthred42>(std::string{"II#5+II#5+"});
+    {
+        auto os = std::ostringstream{};
+        {
+            auto writer = ivs::fastx_writer<ivs::dna5, ivs::pthred42>{os, 4};
+            writer.write_fasta("s1", seq);
+            writer.write_fasta("s2", std::span{seq}.first(8));
+            writer.write_fasta("empty", std::span<uint8_t const>{});
+            writer.write_fastq("r1", seq, qual);
+        }
+        assert(os.str() == ">s1\nACGT\nNACG\nTA\n>s2\nACGT\nNACG\n>empty\n\n@r1\nACGTNACGTA\n+\nII#5+II#5+\n");
+    }
+
+    // packed sequences
+    {
+        auto packed = ivs::packed_sequence<ivs::dna5>{seq};
+        auto os = std::ostringstream{};
+        {
+            auto writer = ivs::fastx_writer<ivs::dna5, ivs::pthred42>{os, 0};
+            writer.write_fasta("p", packed);
+            writer.write_fastq("q", packed, qual);
+        }
+        assert(os.str() == ">p\nACGTNACGTA\n@q\nACGTNACGTA\n+\nII#5+II#5+\n");
+    }
+
+    // long records with a small buffer round trip through the parser
+    {
+        auto batch = ivs::read_batch<ivs::dna5, ivs::pthred42>{};
+        auto chars = std::string{};
+        auto quals = std::string{};
+        for (size_t i{0}; i < 5000; ++i) {
+            chars += "ACGTN"[(i * 7) % 5];
+            quals += static_cast<char>('!' + (i % 42));
+        }
+        batch.push_back(chars, quals, "long");
+        batch.push_back(std::string_view{"ACGT"}, std::string_view{"IIII"}, "short");
+
+        for (auto withQualities : {true, false}) {
+            auto b = batch;
+            if (!withQualities) b.qualities.clear();
+            auto os = std::ostringstream{};
+            {
+                auto writer = ivs::fastx_writer<ivs::dna5, ivs::pthred42>{os, 60, 1024};
+                writer.write(b);
+            }
+            auto text   = os.str();
+            auto parser = ivs::fastx_parser{text};
+            auto result = ivs::read_batch<ivs::dna5, ivs::pthred42>{};
+            assert(ivs::read_batch_from(parser, result, 10) == 2);
+            assert(result.ranks == b.ranks and result.qualities == b.qualities and result.names == b.names);
+        }
+    }
+
+    // file output
+    {
+        auto path = std::filesystem::temp_directory_path() / "ivsigma_test_fastx_writer.fa";
+        {
+            auto writer = ivs::fastx_writer<ivs::dna5>{path};
+            writer.write_fasta("s1", seq);
+        }
+        auto reader = ivs::fastx_reader{path};
+        auto record = ivs::fastx_record{};
+        assert(reader.next(record) and record.name == "s1");
+        std::filesystem::remove(path);
+    }
+
+    // failed writes throw, on flush or once the buffer is full
+    {
+        auto broken = std::ostream{nullptr};
+        auto writer = ivs::fastx_writer<ivs::dna5>{broken, 80, 1024};
+        writer.write_fasta("s1", seq);
+        bool thrown{false};
+        try {
+            writer.flush();
+        } catch (std::runtime_error const&) {
+            thrown = true;
+        }
+        assert(thrown);
+
+        auto longSeq = std::vector<uint8_t>(5000, 1);
+        thrown = false;
+        try {
+            writer.write_fasta("long", longSeq);
+        } catch (std::runtime_error const&) {
+            thrown = true;
+        }
+        assert(thrown);
+    }
+}
+
+namespace {
+// creates a .2bit file, N are stored as N blocks and lower case chars as mask blocks
+auto make_twobit(std::vector<std::pair<std::string, std::string>> const& sequences, uint32_t version = 0, bool bigEndian = false) -> std::vector<char> {
+    auto out = std::vector<char>{};
+    auto put32 = [&](uint32_t v) {
+        for (size_t i{0}; i < 4; ++i) {
+            out.push_back(static_cast<char>(v >> (bigEndian ? (24 - 8*i) : (8*i))));
+        }
+    };
+    auto put64 = [&](uint64_t v) {
+        put32(static_cast<uint32_t>(bigEndian ? v >> 32 : v));
+        put32(static_cast<uint32_t>(bigEndian ? v : v >> 32));
+    };
+    auto runs = [](std::string const& seq, auto pred) {
+        auto res = std::vector<std::pair<uint32_t, uint32_t>>{};
+        for (uint32_t i{0}; i < seq.size(); ++i) {
+            if (!pred(seq[i])) continue;
+            if (!res.empty() and res.back().first + res.back().second == i) {
+                res.back().second += 1;
+            } else {
+                res.emplace_back(i, 1);
+            }
+        }
+        return res;
+    };
+    put32(0x1a412743);
+    put32(version);
+    put32(sequences.size());
+    put32(0);
+    auto offsetPos = std::vector<size_t>{};
+    for (auto const& [name, seq] : sequences) {
+        out.push_back(static_cast<char>(name.size()));
+        out.insert(out.end(), name.begin(), name.end());
+        offsetPos.push_back(out.size());
+        if (version == 0) put32(0); else put64(0);
+    }
+    for (size_t s{0}; s < sequences.size(); ++s) {
+        auto const& seq = sequences[s].second;
+        auto offset = out.size();
+        auto tmp = std::move(out);
+        out.clear();
+        if (version == 0) put32(offset); else put64(offset);
+        std::ranges::copy(out, tmp.begin() + offsetPos[s]);
+        out = std::move(tmp);
+
+        put32(seq.size());
+        for (auto const& blocks : {runs(seq, [](char c) { return c == 'N' or c == 'n'; }),
+                                   runs(seq, [](char c) { return std::islower(c) != 0; })}) {
+            put32(blocks.size());
+            for (auto [b, l] : blocks) put32(b);
+            for (auto [b, l] : blocks) put32(l);
+        }
+        put32(0);
+        for (size_t i{0}; i < seq.size(); i += 4) {
+            uint8_t byte{0};
+            for (size_t j{0}; j < 4; ++j) {
+                auto c = (i + j < seq.size()) ? std::toupper(seq[i+j]) : 'T';
+                uint8_t code = (c == 'C') ? 1 : (c == 'A') ? 2 : (c == 'G') ? 3 : 0;
+                byte |= code << (6 - 2*j);
+            }
+            out.push_back(static_cast<char>(byte));
+        }
+    }
+    return out;
+}
+}
+
+void test_twobit() {
+    auto sequences = std::vector<std::pair<std::string, std::string>>{
+        {"chr1", "ACGTacgtNNNNNGGCCTTAAnnACGTAGCTAGCTAGGAC"},
+        {"chrM", "TTTAGGC"},
+        {"empty", ""},
+    };
+    for (auto [version, bigEndian] : {std::pair{0u, false}, std::pair{1u, false}, std::pair{0u, true}}) {
+        auto data = make_twobit(sequences, version, bigEndian);
+        auto file = ivs::twobit_file{data};
+        assert(file.size() == 3);
+        assert(file.index[0].name == "chr1" and file.index[1].name == "chrM" and file.index[2].name == "empty");
+        for (size_t i{0}; i < file.size(); ++i) {
+            auto seq = file.sequence(i);
+            auto const& expected = sequences[i].second;
+            assert(seq.name == sequences[i].first);
+            assert(seq.size() == expected.size());
+            assert(seq.extract_char(0, seq.size(), true) == expected);
+            auto upper = expected;
+            for (auto& c : upper) c = static_cast<char>(std::toupper(c));
+            assert(seq.extract_char(0, seq.size()) == upper);
+            assert(seq.extract(0, seq.size()) == ivs::convert_char_to_rank<ivs::dna5>(upper));
+            for (size_t o{0}; o + 3 <= seq.size(); ++o) {
+                assert(seq.extract_char(o, 3, true) == expected.substr(o, 3));
+            }
+        }
+        auto chr1 = file.find("chr1");
+        assert(chr1);
+        assert((chr1->n_blocks == std::vector<ivs::interval>{{8, 13}, {21, 23}}));
+        assert((chr1->mask_blocks == std::vector<ivs::interval>{{4, 8}, {21, 23}}));
+        assert(!file.find("chr2"));
+
+        // k-mers skip N blocks and equal those of an n_compressed_sequence
+        auto ncs = ivs::n_compressed_sequence{chr1->extract(0, chr1->size())};
+        auto kmers = chr1->kmers(4);
+        auto expected = ncs.kmers(4);
+        auto a = std::vector<std::pair<size_t, size_t>>{};
+        auto b = std::vector<std::pair<size_t, size_t>>{};
+        for (auto iter = begin(kmers); iter != end(kmers); ++iter) a.emplace_back(iter.position(), *iter);
+        for (auto iter = begin(expected); iter != end(expected); ++iter) b.emplace_back(iter.position(), *iter);
+        assert(a == b and !a.empty());
+        auto minimizers = chr1->minimizers(4, 3);
+        assert(minimizers.size() > 0);
+    }
+
+    // malformed files
+    {
+        auto truncated = make_twobit(sequences);
+        truncated.resize(truncated.size() - 10);
+        auto file = ivs::twobit_file{truncated};
+        bool thrown{false};
+        try {
+            file.sequence(2);
+        } catch (std::runtime_error const&) {
+            thrown = true;
+        }
+        assert(thrown);
+
+        thrown = false;
+        auto invalid = std::vector<char>(16, 'A');
+        try {
+            ivs::twobit_file{invalid};
+        } catch (std::runtime_error const&) {
+            thrown = true;
+        }
+        assert(thrown);
+
+        // a sequence count exceeding the file throws before allocating
+        thrown = false;
+        auto huge = make_twobit(sequences);
+        std::ranges::fill(std::span{huge}.subspan(8, 4), char(0xff));
+        try {
+            ivs::twobit_file{huge};
+        } catch (std::runtime_error const&) {
+            thrown = true;
+        }
+        assert(thrown);
+    }
+}
+
+void test_packed_store() {
+    auto chr1 = ivs::convert_char_to_rank<ivs::dna5>(std::string{"ACGTNNACGTAGGCTTAGCNACGTACGATCGATCGGGATTACA"});
+    auto chr2 = ivs::convert_char_to_rank<ivs::dna5>(std::string{"TTTAGGC"});
+    auto writer = ivs::packed_store_writer<ivs::dna5>{};
+    writer.add("chr1", chr1);
+    writer.add("chr2", ivs::packed_sequence<ivs::dna5>{chr2});
+    writer.add("empty", std::span<uint8_t const>{});
+
+    auto path = std::filesystem::temp_directory_path() / "ivsigma_test_packed_store.ivs";
+    writer.write(path);
+    {
+        auto store = ivs::packed_store<ivs::dna5>{path, ivs::map_advice::huge_pages};
+        assert(store.size() == 3);
+        assert(store.name(0) == "chr1" and store.name(1) == "chr2" and store.name(2) == "empty");
+        assert(store.length(0) == chr1.size() and store.length(2) == 0);
+        assert(store.sequence(0).unpack() == chr1);
+        assert(store.sequence(1).unpack() == chr2);
+        assert(store.sequence(2).empty());
+        assert(store.find("chr2") == 1 and !store.find("chr3"));
+        for (size_t o{0}; o + 5 <= chr1.size(); ++o) {
+            assert(store.extract(0, o, 5) == std::vector<uint8_t>(chr1.begin() + o, chr1.begin() + o + 5));
+        }
+        assert(store.extract_char(1, 2, 4) == "TAGG");
+
+        // payloads are 64 byte aligned
+        for (size_t i{0}; i < store.size(); ++i) {
+            assert(reinterpret_cast<uintptr_t>(store.sequence(i).words.data()) % 64 == 0);
+        }
+
+        // concurrent readers
+        auto threads = std::vector<std::thread>{};
+        auto matches = std::array<bool, 4>{};
+        for (size_t t{0}; t < matches.size(); ++t) {
+            threads.emplace_back([&, t]() {
+                bool ok{true};
+                for (size_t o{t}; o + 8 <= chr1.size(); ++o) {
+                    ok = ok and store.extract(0, o, 8) == std::vector<uint8_t>(chr1.begin() + o, chr1.begin() + o + 8);
+                }
+                matches[t] = ok;
+            });
+        }
+        for (auto& t : threads) t.join();
+        assert(std::ranges::all_of(matches, [](bool b) { return b; }));
+
+        // stores are bound to their alphabet
+        bool thrown{false};
+        try {
+            ivs::packed_store<ivs::dna4>{path};
+        } catch (std::runtime_error const&) {
+            thrown = true;
+        }
+        assert(thrown);
+    }
+    std::filesystem::remove(path);
+
+    // in memory stores, 8 byte aligned
+    {
+        auto ss = std::stringstream{};
+        writer.write(ss);
+        auto text  = ss.str();
+        auto words = std::vector<uint64_t>((text.size() + 7) / 8);
+        std::memcpy(words.data(), text.data(), text.size());
+        auto store = ivs::packed_store<ivs::dna5>{std::span{reinterpret_cast<char const*>(words.data()), text.size()}};
+        assert(store.sequence(0).unpack() == chr1);
+
+        bool thrown{false};
+        try {
+            ivs::packed_store<ivs::dna5>{std::span{reinterpret_cast<char const*>(words.data()), text.size() - 64}};
+        } catch (std::runtime_error const&) {
+            thrown = true;
+        }
+        assert(thrown);
+
+        // entries pointing outside of the file are rejected when opening
+        auto header = ivs::detail::packed_store_header{};
+        std::memcpy(&header, words.data(), sizeof(header));
+        for (auto [field, value] : std::vector<std::pair<size_t, uint64_t>>{{0, 4}, {0, text.size()}, {1, 1'000'000},
+                                                                            {1, ~uint64_t{0}}, {2, 1000}, {3, ~uint64_t{0}}}) {
+            auto corrupt = words;
+            corrupt[header.entries / 8 + 4 + field] = value; // fields of the second entry
+            thrown = false;
+            try {
+                ivs::packed_store<ivs::dna5>{std::span{reinterpret_cast<char const*>(corrupt.data()), text.size()}};
+            } catch (std::runtime_error const&) {
+                thrown = true;
+            }
+            assert(thrown);
+        }
+    }
+}
+
+void test_super_kmer() {
+    auto reads = std::vector<std::vector<uint8_t>>{};
+    auto random = random_ranks(7, 200, 150);
+    for (size_t i{0}; i < random.size(); ++i) {
+        auto& read = random[i];
+        if (i % 11 == 0) read.resize(12);
+        reads.push_back(read);
+        if (i % 4 == 0) reads.push_back(ivs::reverse_complement_rank<ivs::dna4>(read));
+    }
+    auto expected = ivs::kmer_count_table{30'000};
+    ivs::count_kmers<ivs::dna4>(expected, reads, 21, 1);
+
+    auto dir = std::filesystem::temp_directory_path() / "ivsigma_test_super_kmer";
+    std::filesystem::create_directories(dir);
+    auto superKmers = std::map<ivs::minimizer_order, size_t>{};
+    for (auto order : {ivs::minimizer_order::hashed, ivs::minimizer_order::lexicographic}) {
+        auto partitioner = ivs::super_kmer_partitioner<ivs::dna4>{dir, 8, 21, 9, 1024, order};
+        for (auto const& read : reads) {
+            partitioner.add(read);
+        }
+        partitioner.flush();
+
+        // minimizers as selected by the partitioner
+        auto minimizers = [&](std::vector<uint8_t> const& ranks) {
+            auto res = std::vector<size_t>{};
+            if (order == ivs::minimizer_order::lexicographic) {
+                for (auto v : ivs::winnowing_minimizer<ivs::dna4>{ranks, 9, 21 - 9 + 1}) res.push_back(v);
+            } else {
+                using Hashed = ivs::detail::hashed_kmers<ivs::compact_encoding<ivs::dna4>>;
+                auto w = ivs::winnowing_minimizer<ivs::dna4, true, true, std::span<uint8_t const>, Hashed>{Hashed{{ranks, 9}}, 21 - 9 + 1};
+                for (auto v : w) res.push_back(v);
+            }
+            return res;
+        };
+
+        // super-k-mers of a bucket cover exactly its k-mers, each sharing the same minimizer
+        size_t totalKmers{0};
+        for (size_t i{0}; i < partitioner.size(); ++i) {
+            auto reader = ivs::super_kmer_reader<ivs::dna4>{partitioner.bucket_path(i)};
+            size_t kmers{0};
+            for (auto super_kmer = ivs::packed_span<ivs::dna4>{}; reader.next(super_kmer);) {
+                assert(super_kmer.size() >= 21 and super_kmer.size() <= 21 + 21 - 9);
+                auto values = minimizers(super_kmer.unpack());
+                assert(std::ranges::all_of(values, [&](size_t v) { return v == values[0]; }));
+                kmers += super_kmer.size() - 20;
+                superKmers[order] += 1;
+            }
+            assert(kmers == partitioner.bucket_kmers(i));
+            totalKmers += kmers;
+        }
+        // the hashed order spreads the k-mers evenly over the buckets
+        if (order == ivs::minimizer_order::hashed) {
+            for (size_t i{0}; i < partitioner.size(); ++i) {
+                assert(partitioner.bucket_kmers(i) * 8 < totalKmers * 3 / 2);
+            }
+        }
+        size_t allKmers{0};
+        for (auto const& read : reads) allKmers += read.size() >= 21 ? read.size() - 20 : 0;
+        assert(totalKmers == allKmers);
+
+        // counting bucket by bucket gives the same counts, every k-mer occurs in a single bucket
+        size_t distinct{0};
+        auto frequent = std::vector<ivs::kmer_count>{};
+        partitioner.count_buckets([&](ivs::kmer_count_table const& table) {
+            distinct += table.size();
+            table.for_each([&](uint64_t kmer, uint64_t count) {
+                assert(expected.count(kmer) == count);
+            });
+            auto f = table.kmers_above(2);
+            frequent.insert(frequent.end(), f.begin(), f.end());
+        });
+        assert(distinct == expected.size());
+        std::ranges::sort(frequent, {}, &ivs::kmer_count::kmer);
+        assert(frequent == expected.kmers_above(2) and !frequent.empty());
+    }
+    // the lexicographic order selects more minimizers, giving shorter super-k-mers
+    assert(superKmers[ivs::minimizer_order::hashed] < superKmers[ivs::minimizer_order::lexicographic]);
+    {
+        auto path = dir / "truncated.skm";
+        {
+            auto ofs = std::ofstream{path, std::ios::binary};
+            auto words = std::array<uint64_t, 2>{100, 0};
+            ofs.write(reinterpret_cast<char const*>(words.data()), sizeof(words));
+        }
+        auto reader = ivs::super_kmer_reader<ivs::dna4>{path};
+        auto super_kmer = ivs::packed_span<ivs::dna4>{};
+        bool thrown{false};
+        try {
+            reader.next(super_kmer);
+        } catch (std::runtime_error const&) {
+            thrown = true;
+        }
+        assert(thrown);
+    }
+    std::filesystem::remove_all(dir);
+}
+
+void test_radix_sort() {
+    auto next = test_rng{3};
+    // k-mers of different widths, large inputs use multiple threads
+    for (auto [n, bits] : {std::pair<size_t, size_t>{0, 64}, {100, 64}, {5'000, 22}, {300'000, 62}, {300'000, 14}}) {
+        auto values = std::vector<uint64_t>(n);
+        for (auto& v : values) v = bits == 64 ? next() : next() >> (64 - bits);
+        auto expected = values;
+        std::ranges::sort(expected);
+        for (size_t threads : {1, 4}) {
+            auto sorted = values;
+            ivs::radix_sort(sorted, threads);
+            assert(sorted == expected);
+        }
+    }
+
+    // equal high bits are skipped, only the differing digits are sorted
+    {
+        auto values = std::vector<uint64_t>{};
+        for (size_t i{0}; i < 10'000; ++i) values.push_back((uint64_t{0xab} << 56) | (next() >> 40));
+        auto expected = values;
+        std::ranges::sort(expected);
+        ivs::radix_sort(values, 2);
+        assert(values == expected);
+    }
+
+    // records with payload are sorted stable
+    {
+        auto records = std::vector<std::pair<uint64_t, uint32_t>>{};
+        for (uint32_t i{0}; i < 200'000; ++i) records.emplace_back(next() >> 52, i);
+        auto expected = records;
+        std::ranges::stable_sort(expected, {}, &std::pair<uint64_t, uint32_t>::first);
+        ivs::radix_sort(std::span{records}, [](auto const& r) { return r.first; }, 4);
+        assert(records == expected);
+    }
+
+    // unique and count
+    {
+        auto values = std::vector<uint64_t>{};
+        for (size_t i{0}; i < 100'000; ++i) values.push_back(next() >> 50);
+        auto expected = std::map<uint64_t, uint64_t>{};
+        for (auto v : values) expected[v] += 1;
+
+        auto counted = values;
+        auto counts = ivs::radix_sort_count(counted, 3);
+        assert(counts.size() == expected.size());
+        assert(std::ranges::is_sorted(counted));
+        for (auto [kmer, count] : counts) {
+            assert(expected[kmer] == count);
+        }
+
+        ivs::radix_sort_unique(values, 3);
+        assert(values.size() == expected.size());
+        assert(std::ranges::equal(values, expected | std::views::keys));
+    }
+}
+
+void test_minimizer_index() {
+    auto references = std::vector<std::vector<uint8_t>>{};
+    auto repeat = random_ranks(11, 1, 30)[0];
+    for (size_t i{0}; i < 40; ++i) {
+        auto ref = random_ranks(100 + i, 1, 500 + i * 10)[0];
+        std::ranges::copy(repeat, ref.begin() + 100); // repeat occurs in every reference
+        references.push_back(ref);
+    }
+
+    // brute force hits
+    auto expected = std::map<uint64_t, std::vector<ivs::minimizer_hit>>{};
+    for (uint32_t s{0}; s < references.size(); ++s) {
+        auto minimizers = ivs::winnowing_minimizer<ivs::dna4>{references[s], 11, 8};
+        for (auto iter = begin(minimizers); iter != end(minimizers); ++iter) {
+            auto pos = iter.position();
+            auto fwd = ivs::compact_encoding<ivs::dna4, false>{std::span{references[s]}.subspan(pos, 11), 11};
+            bool reverse = *begin(fwd) != *iter;
+            expected[*iter].push_back({s, static_cast<uint32_t>(pos << 1 | reverse)});
+        }
+    }
+
+    auto options = ivs::minimizer_index_options{.k = 11, .window = 8, .threads = 3};
+    auto index = ivs::minimizer_index<ivs::dna4>{references, options};
+    assert(index.size() == expected.size());
+    assert(index.dropped() == 0);
+    size_t hits{0};
+    for (auto const& [minimizer, h] : expected) {
+        assert(std::ranges::equal(index.lookup(minimizer), h));
+        hits += h.size();
+    }
+    assert(index.hit_count() == hits);
+
+    // strands of the hits match the reference
+    for (auto const& [minimizer, h] : expected) {
+        for (auto hit : h) {
+            auto kmer = std::span{references[hit.sequence]}.subspan(hit.position(), 11);
+            auto seq  = hit.reverse() ? ivs::reverse_complement_rank<ivs::dna4>(kmer) : std::vector<uint8_t>(kmer.begin(), kmer.end());
+            auto fwd  = ivs::compact_encoding<ivs::dna4, false>{seq, 11};
+            assert(*begin(fwd) == minimizer);
+        }
+    }
+
+    // batch lookup, including absent minimizers
+    {
+        auto minimizers = std::vector<uint64_t>{};
+        for (auto const& [minimizer, h] : expected) {
+            minimizers.push_back(minimizer);
+            minimizers.push_back(minimizer + 1);
+        }
+        auto out = std::vector<std::span<ivs::minimizer_hit const>>(minimizers.size());
+        index.lookup(minimizers, out);
+        for (size_t i{0}; i < minimizers.size(); ++i) {
+            auto iter = expected.find(minimizers[i]);
+            if (iter == expected.end()) {
+                assert(out[i].empty());
+            } else {
+                assert(std::ranges::equal(out[i], iter->second));
+            }
+        }
+    }
+
+    // querying the repeat finds all references
+    {
+        auto sequences = std::set<uint32_t>{};
+        index.for_each_hit(repeat, [&](size_t pos, bool reverse, std::span<ivs::minimizer_hit const> h) {
+            for (auto hit : h) {
+                if (hit.reverse() == reverse and hit.position() == pos + 100) sequences.insert(hit.sequence);
+            }
+        });
+        assert(sequences.size() == references.size());
+    }
+
+    // frequent minimizers are dropped
+    {
+        auto filtered = ivs::minimizer_index<ivs::dna4>{references, {.k = 11, .window = 8, .max_occurrences = 39, .threads = 2}};
+        size_t frequent{0};
+        for (auto const& [minimizer, h] : expected) {
+            if (h.size() > 39) {
+                frequent += 1;
+                assert(filtered.lookup(minimizer).empty());
+            } else {
+                assert(std::ranges::equal(filtered.lookup(minimizer), h));
+            }
+        }
+        assert(frequent > 0 and filtered.dropped() == frequent);
+        assert(filtered.size() + frequent == expected.size());
+
+        auto fraction = ivs::minimizer_index<ivs::dna4>{references, {.k = 11, .window = 8, .drop_fraction = 0.001, .threads = 1}};
+        assert(fraction.dropped() <= 0.001 * expected.size() and fraction.dropped() >= frequent);
+    }
+
+    // persisted indices are mapped
+    {
+        auto path = std::filesystem::temp_directory_path() / "ivsigma_test_minimizer_index.ivs";
+        index.save(path);
+        {
+            auto mapped = ivs::minimizer_index<ivs::dna4>{path};
+            assert(mapped.k() == 11 and mapped.window() == 8);
+            assert(mapped.size() == index.size());
+            for (auto const& [minimizer, h] : expected) {
+                assert(std::ranges::equal(mapped.lookup(minimizer), h));
+            }
+            bool thrown{false};
+            try {
+                ivs::minimizer_index<ivs::dna5>{path};
+            } catch (std::runtime_error const&) {
+                thrown = true;
+            }
+            assert(thrown);
+        }
+
+        // entries of the directory or the offsets out of order or out of bounds
+        auto text   = std::string(std::filesystem::file_size(path), '\0');
+        std::ifstream{path, std::ios::binary}.read(text.data(), std::ssize(text));
+        auto header = ivs::detail::minimizer_index_header{};
+        std::memcpy(&header, text.data(), sizeof(header));
+        auto layout = ivs::detail::minimizer_index_layout{header};
+        auto entry  = [](std::string& data, size_t offset, size_t i) -> uint64_t& { return reinterpret_cast<uint64_t*>(data.data() + offset)[i]; };
+        for (auto [offset, count] : {std::pair{layout.directory, size_t{1} << header.bucket_bits}, std::pair{layout.offsets, header.keys}}) {
+            for (auto value : {entry(text, offset, count / 2 + 1) + 1, uint64_t{1} << 40}) {
+                auto corrupt = text;
+                entry(corrupt, offset, count / 2) = value;
+                std::ofstream{path, std::ios::binary}.write(corrupt.data(), std::ssize(corrupt));
+                bool thrown{false};
+                try {
+                    ivs::minimizer_index<ivs::dna4>{path};
+                } catch (std::runtime_error const& e) {
+                    thrown = e.what() == std::string{"corrupt minimizer index"};
+                }
+                assert(thrown);
+            }
+        }
+        std::filesystem::remove(path);
+    }
+}
+
+void test_chaining() {
+    // hand made anchors: a colinear run, a second run on the reverse strand and noise
+    {
+        auto a = ivs::anchors{};
+        a.query_length = 1000;
+        a.span         = 15;
+        for (size_t i{0}; i < 10; ++i) {
+            a.push_back(0, false, 500 + i * 10, 100 + i * 10);
+        }
+        for (size_t i{0}; i < 5; ++i) {
+            a.push_back(1, true, 2000 + i * 20, 800 - i * 20);
+        }
+        a.push_back(0, false, 9000, 10);
+        a.push_back(0, false, 510, 50);
+        a.sort();
+
+        auto options = ivs::chaining_options{.min_score = 20, .min_anchors = 2};
+        for (auto const& chains : {ivs::chain_anchors(a, options), ivs::chain_anchors_colinear(a, options)}) {
+            assert(chains.size() == 2);
+            assert(chains[0].sequence == 0 and !chains[0].reverse);
+            assert(chains[0].anchors.size() == 10);
+            assert((chains[0].reference == ivs::interval{500, 605}));
+            assert((chains[0].query == ivs::interval{100, 205}));
+            assert(chains[1].sequence == 1 and chains[1].reverse);
+            assert(chains[1].anchors.size() == 5);
+            assert((chains[1].reference == ivs::interval{2000, 2095}));
+            assert((chains[1].query == ivs::interval{720, 815}));
+        }
+        // span + 9 * distance, no gap costs
+        assert(ivs::chain_anchors(a, options)[0].score == 15 + 9 * 10);
+        assert(ivs::chain_anchors(a, options)[1].score == 15 + 4 * 15);
+        assert(ivs::chain_anchors_colinear(a, options)[0].score == 10 * 15);
+
+        // gaps between the query and reference distance are penalized
+        auto b = ivs::anchors{};
+        b.query_length = 1000;
+        b.span         = 15;
+        b.push_back(0, false, 100, 100);
+        b.push_back(0, false, 120, 150);
+        b.sort();
+        auto chains = ivs::chain_anchors(b, {.min_score = 0, .min_anchors = 2});
+        assert(chains.size() == 1 and chains[0].score == 15 + 15 - ivs::detail::chain_gap_cost(30, 15));
+        // a gap larger than the bandwidth breaks the chain
+        assert(ivs::chain_anchors(b, {.bandwidth = 20, .min_score = 0, .min_anchors = 2}).empty());
+    }
+
+    // mapping a read against an index
+    {
+        auto references = random_ranks(5, 3, 3000);
+        auto index = ivs::minimizer_index<ivs::dna4>{references, {.k = 15, .window = 10, .threads = 1}};
+
+        auto read = std::vector<uint8_t>(references[1].begin() + 1000, references[1].begin() + 2000);
+        for (size_t i{50}; i < read.size(); i += 97) read[i] = (read[i] + 1) % 4; // substitutions
+        auto a = ivs::anchors{};
+        for (bool reverse : {false, true}) {
+            auto query = reverse ? ivs::reverse_complement_rank<ivs::dna4>(read) : read;
+            ivs::collect_anchors(index, query, a);
+            assert(a.size() > 20);
+            for (auto const& chains : {ivs::chain_anchors(a), ivs::chain_anchors_colinear(a)}) {
+                assert(!chains.empty());
+                auto const& best = chains[0];
+                assert(best.sequence == 1 and best.reverse == reverse);
+                assert(best.reference.begin >= 1000 and best.reference.begin < 1100);
+                assert(best.reference.end > 1900 and best.reference.end <= 2000);
+                auto expectedBegin = reverse ? query.size() - (best.reference.end - 1000) : best.reference.begin - 1000;
+                assert(best.query.begin == expectedBegin);
+                assert(chains.size() == 1 or chains[1].score < best.score / 4);
+            }
+        }
+    }
+}
+
+void test_bloom_filter() {
+    auto sequences = random_ranks(7, 70, 500);
+
+    // blocked bloom filter: no false negatives, few false positives
+    {
+        auto filter = ivs::blocked_bloom_filter{1 << 16, 4};
+        assert(filter.size() == 1 << 16);
+        auto kmers = std::vector<uint64_t>{};
+        for (auto kmer : ivs::compact_encoding<ivs::dna4>{sequences[0], 15}) {
+            kmers.push_back(kmer);
+        }
+        filter.insert(kmers);
+        filter.insert(ivs::compact_encoding<ivs::dna4>{sequences[1], 15});
+        assert(filter.count(ivs::compact_encoding<ivs::dna4>{sequences[0], 15}) == kmers.size());
+        assert(filter.count(ivs::compact_encoding<ivs::dna4>{sequences[1], 15}) == 486);
+        auto falsePositives = filter.count(ivs::compact_encoding<ivs::dna4>{sequences[2], 15});
+        assert(falsePositives < 5);
+        assert(!ivs::blocked_bloom_filter(1024, 3).contains(42));
+    }
+
+    // interleaved bloom filter: one bin per sequence, more than 64 bins
+    {
+        auto filter = ivs::interleaved_bloom_filter{sequences.size(), 1 << 14, 3};
+        assert(filter.bins() == 70);
+        for (size_t i{0}; i < sequences.size(); ++i) {
+            filter.insert(i, ivs::compact_encoding<ivs::dna4>{sequences[i], 19});
+        }
+        for (size_t i : {0, 1, 63, 64, 69}) {
+            auto read = std::vector<uint8_t>(sequences[i].begin() + 100, sequences[i].begin() + 250);
+            auto counts = filter.count(ivs::compact_encoding<ivs::dna4>{read, 19});
+            assert(counts.size() == sequences.size());
+            for (size_t j{0}; j < counts.size(); ++j) {
+                if (i == j) assert(counts[j] == 132);
+                else assert(counts[j] < 10);
+            }
+            auto bins = std::vector<uint64_t>(2);
+            filter.query(*begin(ivs::compact_encoding<ivs::dna4>{read, 19}), bins);
+            assert(((bins[i / 64] >> (i % 64)) & 1) == 1);
+            assert(bins[1] >> 6 == 0);
+        }
+        // counting minimizers instead of all k-mers
+        auto counts = filter.count(ivs::winnowing_minimizer<ivs::dna4>{sequences[5], 19, 5});
+        assert(std::ranges::max_element(counts) - counts.begin() == 5);
+    }
+
+    // single k-mers of any integer type, ranges of k-mers of other integer types
+    {
+        auto blocked = ivs::blocked_bloom_filter{1024, 3};
+        blocked.insert(42);
+        blocked.insert(uint32_t{43});
+        blocked.insert(std::vector<uint32_t>{44, 45});
+        assert(blocked.contains(42) and blocked.contains(43) and blocked.count(std::vector<int>{44, 45}) == 2);
+
+        auto interleaved = ivs::interleaved_bloom_filter{2, 1024, 3};
+        interleaved.insert(1, 42);
+        interleaved.insert(1, uint32_t{43});
+        interleaved.insert(0, std::vector<int>{44});
+        assert((interleaved.count(std::vector<uint32_t>{42, 43, 44}) == std::vector<uint32_t>{1, 2}));
+    }
+}
+
+void test_sketch() {
+    // a random genome and a copy with 1% substitutions
+    auto a    = random_ranks(11, 1, 100'000)[0];
+    auto b    = a;
+    auto next = test_rng{12};
+    for (size_t i{0}; i < b.size(); i += 100) {
+        auto pos = i + (next() >> 33) % 100;
+        b[pos]   = (b[pos] + 1 + (next() >> 33) % 3) % 4;
+    }
+
+    size_t const k = 21;
+    auto kmersA = std::set<uint64_t>{};
+    auto kmersB = std::set<uint64_t>{};
+    for (auto kmer : ivs::compact_encoding<ivs::dna4>{a, k}) kmersA.insert(kmer);
+    for (auto kmer : ivs::compact_encoding<ivs::dna4>{b, k}) kmersB.insert(kmer);
+    size_t shared = std::ranges::count_if(kmersA, [&](uint64_t kmer) { return kmersB.contains(kmer); });
+    auto exactJaccard = double(shared) / double(kmersA.size() + kmersB.size() - shared);
+
+    // MinHash
+    {
+        auto sa = ivs::minhash_sketch{k, 2000};
+        auto sb = ivs::minhash_sketch{k, 2000};
+        sa.insert(ivs::compact_encoding<ivs::dna4>{a, k});
+        for (auto kmer : ivs::compact_encoding<ivs::dna4>{b, k}) sb.insert(kmer);
+        assert(sa.hashes().size() == 2000 and std::ranges::is_sorted(sa.hashes()));
+        assert(std::abs(ivs::jaccard(sa, sb) - exactJaccard) < 0.03);
+        assert(ivs::jaccard(sa, sa) == 1.);
+        auto d = ivs::mash_distance(ivs::jaccard(sa, sb), k);
+        assert(d > 0.007 and d < 0.013);
+
+        // merging two halves gives the same sketch
+        auto h1 = ivs::minhash_sketch{k, 2000};
+        auto h2 = ivs::minhash_sketch{k, 2000};
+        h1.insert(ivs::compact_encoding<ivs::dna4>{std::span{a}.first(50'000), k});
+        h2.insert(ivs::compact_encoding<ivs::dna4>{std::span{a}.subspan(50'000 - k + 1), k});
+        h1.merge(h2);
+        assert(std::ranges::equal(h1.hashes(), sa.hashes()));
+
+        auto ss = std::stringstream{};
+        sa.write(ss);
+        auto sc = ivs::minhash_sketch::read(ss);
+        assert(sc.k() == k and sc.size() == 2000);
+        assert(std::ranges::equal(sc.hashes(), sa.hashes()));
+    }
+
+    // FracMinHash
+    {
+        auto sa = ivs::frac_minhash_sketch{k, 100};
+        auto sb = ivs::frac_minhash_sketch{k, 100};
+        sa.insert(ivs::compact_encoding<ivs::dna4>{a, k});
+        sb.insert(ivs::compact_encoding<ivs::dna4>{b, k});
+        assert(std::abs(sa.cardinality() / double(kmersA.size()) - 1.) < 0.1);
+        assert(std::abs(ivs::jaccard(sa, sb) - exactJaccard) < 0.03);
+        assert(std::abs(ivs::containment_ani(sa, sb) - 0.99) < 0.002);
+        assert(ivs::containment(sa, sa) == 1.);
+
+        // containment of a part in the whole genome
+        auto part = ivs::frac_minhash_sketch{k, 100};
+        part.insert(ivs::compact_encoding<ivs::dna4>{std::span{a}.first(20'000), k});
+        assert(ivs::containment(part, sa) == 1.);
+        assert(ivs::containment(sa, part) < 0.3);
+
+        auto ss = std::stringstream{};
+        sb.write(ss);
+        auto sc = ivs::frac_minhash_sketch::read(ss);
+        assert(sc.scaled() == 100 and std::ranges::equal(sc.hashes(), sb.hashes()));
+    }
+
+    // single k-mers of any integer type, ranges of k-mers of other integer types
+    {
+        auto mh  = ivs::minhash_sketch{k, 10};
+        auto fmh = ivs::frac_minhash_sketch{k, 1};
+        auto hll = ivs::hyperloglog{};
+        mh.insert(42);
+        fmh.insert(uint32_t{42});
+        hll.insert(42);
+        mh.insert(std::vector<uint32_t>{43, 44});
+        fmh.insert(std::vector<int>{43, 44});
+        hll.insert(std::vector<uint32_t>{43, 44});
+        assert(mh.hashes().size() == 3 and fmh.hashes().size() == 3);
+        assert(std::abs(hll.cardinality() - 3.) < 0.1);
+    }
+
+    // HyperLogLog
+    {
+        auto hll = ivs::hyperloglog{};
+        hll.insert(ivs::compact_encoding<ivs::dna4>{a, k});
+        assert(std::abs(hll.cardinality() / double(kmersA.size()) - 1.) < 0.05);
+        auto small = ivs::hyperloglog{};
+        small.insert(ivs::compact_encoding<ivs::dna4>{std::span{a}.first(120), k});
+        assert(std::abs(small.cardinality() - 100.) < 3.);
+
+        auto hb = ivs::hyperloglog{};
+        hb.insert(ivs::compact_encoding<ivs::dna4>{b, k});
+        hb.merge(hll);
+        auto unionSize = double(kmersA.size() + kmersB.size() - shared);
+        assert(std::abs(hb.cardinality() / unionSize - 1.) < 0.05);
+
+        auto ss = std::stringstream{};
+        hb.write(ss);
+        assert(ivs::hyperloglog::read(ss).cardinality() == hb.cardinality());
+        auto bad = std::stringstream{"IVSHLL"};
+        try {
+            (void)ivs::hyperloglog::read(bad);
+            assert(false);
+        } catch (std::runtime_error const&) {}
+    }
+
+    // multiple threads
+    {
+        auto reads = std::vector<std::vector<uint8_t>>{};
+        for (size_t i{0}; i + 150 <= a.size(); i += 120) {
+            reads.emplace_back(a.begin() + i, a.begin() + i + 150);
+        }
+        auto s1 = ivs::minhash_sketch{k};
+        auto s4 = ivs::minhash_sketch{k};
+        ivs::sketch_kmers<ivs::dna4>(s1, reads, k, 1);
+        ivs::sketch_kmers<ivs::dna4>(s4, reads, k, 4);
+        assert(std::ranges::equal(s1.hashes(), s4.hashes()));
+        auto f4 = ivs::frac_minhash_sketch{k, 100};
+        ivs::sketch_kmers<ivs::dna4>(f4, reads, k, 4);
+        auto full = ivs::frac_minhash_sketch{k, 100};
+        full.insert(ivs::compact_encoding<ivs::dna4>{a, k});
+        assert(ivs::containment(f4, full) == 1.);
+        // values already in the sketch are kept
+        auto both = ivs::frac_minhash_sketch{k, 100};
+        both.insert(ivs::compact_encoding<ivs::dna4>{b, k});
+        ivs::sketch_kmers<ivs::dna4>(both, reads, k, 4);
+        auto expectedBoth = ivs::frac_minhash_sketch{k, 100};
+        expectedBoth.insert(ivs::compact_encoding<ivs::dna4>{b, k});
+        expectedBoth.merge(f4);
+        assert(std::ranges::equal(both.hashes(), expectedBoth.hashes()));
+        auto h4 = ivs::hyperloglog{};
+        ivs::sketch_kmers<ivs::dna4>(h4, reads, k, 4);
+        assert(std::abs(h4.cardinality() / double(kmersA.size()) - 1.) < 0.05);
+    }
+}
+
 int main() {
     test_nucliotides();
     test_aminoacids();
     test_qualities();
+    test_quality_binning();
+    test_quality_filter();
+    test_trimming();
+    test_read_batch();
+    test_fastx_reader();
+    test_gzip_reader();
+    test_fastx_writer();
+    test_twobit();
+    test_packed_store();
     test_compact_encoding();
     test_winnowing_minimizer();
+    test_kmer_counter();
+    test_super_kmer();
+    test_radix_sort();
+    test_minimizer_index();
+    test_chaining();
+    test_bloom_filter();
+    test_sketch();
+    test_homopolymer_compression();
+    test_translation();
+    test_convert_rank();
+    test_bisulfite();
+    test_packed_sequence();
+    test_composition();
+    test_dust();
+    test_soft_mask();
+    test_n_compressed_sequence();
     using namespace std::literals;
     assert(!ivs::verify_char("ACGT"s));
     assert(ivs::verify_char("ACG\0T"s).value() == 3);